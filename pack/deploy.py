@@ -40,8 +40,8 @@ for i in dirList:
 
 src32Path = src32Dir + "/release/" + targetName + ".exe"
 src64Path = src64Dir + "/release/" + targetName + ".exe"
-AndroidConf = srcAndroidDir + "/android-build/build/outputs/apk/debug/output.json"
-srcAndroidPath = srcAndroidDir + "/android-build/build/outputs/apk/debug/android-build-debug.apk"
+AndroidConf = srcAndroidDir + "/app/android-build/build/outputs/apk/debug/output.json"
+srcAndroidPath = srcAndroidDir + "/app/android-build/build/outputs/apk/debug/android-build-debug.apk"
 print("Target Files:")
 print(src32Path)
 print(src64Path)
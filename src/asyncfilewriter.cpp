@@ -0,0 +1,56 @@
+#include "asyncfilewriter.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+AsyncFileWriter::AsyncFileWriter(QObject *parent)
+    : QObject{parent}
+{
+    m_file.setParent(this); // for moveToThread()
+}
+
+bool AsyncFileWriter::open(const QString &filename)
+{
+    m_file.close();
+    m_file.setFileName(filename);
+    // the data is aggregated by the caller, no need to buffer it again
+    return m_file.open(QFile::WriteOnly | QFile::Unbuffered);
+}
+
+void AsyncFileWriter::write(const QByteArray &data)
+{
+    if(!m_file.isOpen())
+        return;
+    qint64 num = m_file.write(data);
+    if(num > 0)
+        emit written(num);
+    if(num != data.size())
+        emit error(m_file.errorString());
+}
+
+// write() is unbuffered, so there is nothing to flush in QFile
+// push the data in the OS cache to the disk
+void AsyncFileWriter::sync()
+{
+    if(!m_file.isOpen())
+        return;
+#ifdef Q_OS_WIN
+    _commit(m_file.handle());
+#else
+    fsync(m_file.handle());
+#endif
+}
+
+void AsyncFileWriter::close(bool syncBeforeClose)
+{
+    if(m_file.isOpen())
+    {
+        if(syncBeforeClose)
+            sync();
+        m_file.close();
+    }
+    emit closed();
+}
@@ -0,0 +1,25 @@
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include <QObject>
+#include <QFile>
+
+class AsyncFileWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AsyncFileWriter(QObject *parent = nullptr);
+
+    Q_INVOKABLE bool open(const QString& filename);
+    Q_INVOKABLE void write(const QByteArray& data);
+    Q_INVOKABLE void sync();
+    Q_INVOKABLE void close(bool syncBeforeClose);
+protected:
+    QFile m_file;
+signals:
+    void written(qsizetype num);
+    void closed();
+    void error(const QString& info);
+};
+
+#endif // ASYNCFILEWRITER_H
@@ -0,0 +1,22 @@
+# QTest benchmarks for the data hot paths, runs under QCoreApplication
+# ./bench_hotpaths -o result.xml,xml
+# python3 compare.py result.xml
+QT += testlib
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+TARGET = bench_hotpaths
+
+include(../core/core.pri)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    bench_hotpaths.cpp
+
+DISTFILES += \
+    compare.py \
+    perf_harness.py
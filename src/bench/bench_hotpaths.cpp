@@ -0,0 +1,207 @@
+#include <QtTest>
+#include <QTextCodec>
+
+#include "asynccrc.h"
+#include "plotparser.h"
+#include "util.h"
+
+class BenchHotPaths : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void crcAddData_data();
+    void crcAddData();
+    void unescape_data();
+    void unescape();
+    void plotParse_data();
+    void plotParse();
+    void plotToDouble_data();
+    void plotToDouble();
+    void rawDataAppend_data();
+    void rawDataAppend();
+    void hexFormat_data();
+    void hexFormat();
+private:
+    QByteArray m_randomData;
+    QByteArray m_plotData;
+};
+
+void BenchHotPaths::initTestCase()
+{
+    m_randomData.resize(1024 * 1024);
+    for(int i = 0; i < m_randomData.size(); i++)
+        m_randomData[i] = (char)(i * 131 + (i >> 8));
+
+    // the same lines as demo/Arduino/plot_performance
+    for(int i = 0; m_plotData.size() < 1024 * 1024; i++)
+        m_plotData += QByteArray::number(i % 512) + ",12.34,-5.67,18.90," + QByteArray::number(i % 128 + 20) + "\n";
+}
+
+void BenchHotPaths::crcAddData_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<quint64>("poly");
+    QTest::addColumn<quint64>("init");
+    QTest::addColumn<bool>("ref");
+    QTest::addColumn<quint64>("xorOut");
+    QTest::addColumn<quint64>("check"); // the result of "123456789"
+
+    QTest::newRow("CRC-8") << 8 << 0x07ULL << 0x00ULL << false << 0x00ULL << 0xF4ULL;
+    QTest::newRow("CRC-8/MAXIM") << 8 << 0x31ULL << 0x00ULL << true << 0x00ULL << 0xA1ULL;
+    QTest::newRow("CRC-16/CCITT-FALSE") << 16 << 0x1021ULL << 0xFFFFULL << false << 0x0000ULL << 0x29B1ULL;
+    QTest::newRow("CRC-16/MODBUS") << 16 << 0x8005ULL << 0xFFFFULL << true << 0x0000ULL << 0x4B37ULL;
+    QTest::newRow("CRC-32/MPEG-2") << 32 << 0x04C11DB7ULL << 0xFFFFFFFFULL << false << 0x00000000ULL << 0x0376E6E7ULL;
+    QTest::newRow("CRC-32") << 32 << 0x04C11DB7ULL << 0xFFFFFFFFULL << true << 0xFFFFFFFFULL << 0xCBF43926ULL;
+    QTest::newRow("CRC-64/ECMA-182") << 64 << 0x42F0E1EBA9EA3693ULL << 0ULL << false << 0ULL << 0x6C40DF5F0B497347ULL;
+    QTest::newRow("CRC-64/XZ") << 64 << 0x42F0E1EBA9EA3693ULL << ~0ULL << true << ~0ULL << 0x995DC9BBDF1939FAULL;
+}
+
+void BenchHotPaths::crcAddData()
+{
+    QFETCH(int, width);
+    QFETCH(quint64, poly);
+    QFETCH(quint64, init);
+    QFETCH(bool, ref);
+    QFETCH(quint64, xorOut);
+    QFETCH(quint64, check);
+
+    AsyncCRC crc(width, poly, init, ref, ref, xorOut);
+    crc.reset();
+    crc.addData(QByteArray("123456789"));
+    QCOMPARE(crc.getResult(), check);
+
+    QBENCHMARK
+    {
+        crc.reset();
+        crc.addData(m_randomData);
+    }
+}
+
+void BenchHotPaths::unescape_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("plain") << QString("The quick brown fox jumps over the lazy dog.").repeated(100);
+    QTest::newRow("escape") << QString("\\r\\n\\t\\\\\\x55\\xAA\\101\\0").repeated(100);
+    QTest::newRow("unicode") << QString("\\u4e2d\\u6587 text ").repeated(100);
+}
+
+void BenchHotPaths::unescape()
+{
+    QFETCH(QString, text);
+    QTextCodec* codec = QTextCodec::codecForName("UTF-8");
+
+    QBENCHMARK
+    {
+        Util::unescape(text, codec);
+    }
+}
+
+void BenchHotPaths::plotParse_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("4096") << 4096;
+    QTest::newRow("65536") << 65536;
+}
+
+void BenchHotPaths::plotParse()
+{
+    // PlotTab::newData() then PlotTab::processData(), without the plotting
+    QFETCH(int, chunkSize);
+    PlotParser parser;
+    parser.setDecoder(QTextCodec::codecForName("UTF-8")->makeDecoder());
+    parser.setFrameSeparator("\n");
+    parser.setDataSeparator(",");
+    parser.setClearFlag("cls");
+    QVector<double> values;
+    int frameNum = 0;
+
+    QBENCHMARK
+    {
+        for(int i = 0; i < m_plotData.size(); i += chunkSize)
+        {
+            parser.append(m_plotData.mid(i, chunkSize));
+            while(parser.nextFrame(values, 5) != PlotParser::NoFrame)
+                frameNum++;
+        }
+    }
+    QVERIFY(frameNum > 0);
+}
+
+void BenchHotPaths::plotToDouble_data()
+{
+    QTest::addColumn<QString>("str");
+
+    QTest::newRow("integer") << QString("-12345");
+    QTest::newRow("decimal") << QString("3.1415926");
+    QTest::newRow("padded") << QString(" +18.90\r");
+}
+
+void BenchHotPaths::plotToDouble()
+{
+    QFETCH(QString, str);
+    PlotParser parser;
+
+    QBENCHMARK
+    {
+        parser.toDouble(str);
+    }
+}
+
+void BenchHotPaths::rawDataAppend_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("64") << 64;
+    QTest::newRow("4096") << 4096;
+    QTest::newRow("65536") << 65536;
+}
+
+void BenchHotPaths::rawDataAppend()
+{
+    // MainWindow::onReadyRead() appends to rawReceivedData and RxUIBuf,
+    // RxUIBuf is cleared by the UI timer
+    QFETCH(int, chunkSize);
+    QByteArray chunk = m_randomData.left(chunkSize);
+    const int total = 16 * 1024 * 1024;
+
+    QBENCHMARK
+    {
+        QByteArray rawReceivedData, RxUIBuf;
+        for(int i = 0; i < total; i += chunkSize)
+        {
+            rawReceivedData += chunk;
+            RxUIBuf += chunk;
+            if(RxUIBuf.size() >= 65536)
+                RxUIBuf.clear();
+        }
+    }
+}
+
+void BenchHotPaths::hexFormat_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("append 64") << 64;
+    QTest::newRow("append 4096") << 4096;
+    QTest::newRow("sync 1048576") << 1048576;
+}
+
+void BenchHotPaths::hexFormat()
+{
+    // DataTab::appendReceivedData() and DataTab::syncReceivedEditWithData()
+    QFETCH(int, size);
+    QByteArray data = m_randomData.left(size);
+
+    QBENCHMARK
+    {
+        QString text = data.toHex(' ') + ' ';
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchHotPaths)
+
+#include "bench_hotpaths.moc"
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# Compare the QTest benchmark results with the stored baseline
+# ./bench_hotpaths -o result.xml,xml
+# python3 compare.py result.xml            # compare with baseline.xml
+# python3 compare.py result.xml --update   # store result.xml as baseline.xml
+# The exit code is 1 if any result is slower than the threshold
+
+import sys
+import os
+import shutil
+import argparse
+import xml.etree.ElementTree as ET
+
+
+def loadResults(path):
+    results = {}
+    root = ET.parse(path).getroot()
+    for func in root.iter("TestFunction"):
+        for bench in func.iter("BenchmarkResult"):
+            key = (func.get("name"), bench.get("tag"), bench.get("metric"))
+            # the value is already divided by the iterations
+            results[key] = float(bench.get("value"))
+    return results
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("result", help="output of bench_hotpaths -o <file>,xml")
+parser.add_argument("--baseline", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "baseline.xml"))
+parser.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent")
+parser.add_argument("--update", action="store_true", help="store the result as the baseline")
+args = parser.parse_args()
+
+if args.update:
+    shutil.copyfile(args.result, args.baseline)
+    print("Baseline updated:", args.baseline)
+    sys.exit(0)
+
+if not os.path.exists(args.baseline):
+    print("No baseline at", args.baseline + ", run with --update first")
+    sys.exit(2)
+
+baseline = loadResults(args.baseline)
+current = loadResults(args.result)
+regressed = False
+
+print("function,tag,metric,baseline,current,change%")
+for key in sorted(current.keys()):
+    if key not in baseline:
+        print(",".join(key) + ",," + "%g" % current[key] + ",")
+        continue
+    base = baseline[key]
+    curr = current[key]
+    change = (curr - base) / base * 100 if base != 0 else 0.0
+    mark = ""
+    if change > args.threshold:
+        mark = " REGRESSED"
+        regressed = True
+    print(",".join(key) + ",%g,%g,%+.1f%s" % (base, curr, change, mark))
+
+for key in sorted(baseline.keys()):
+    if key not in current:
+        print(",".join(key) + ",%g,,missing" % baseline[key])
+
+sys.exit(1 if regressed else 0)
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# Run the performance.txt scenarios with SerialTest --perf-scenario
+# Each scenario runs in a new process with a temporary config file
+# python3 perf_harness.py ../../build/SerialTest --offscreen --output new.json
+# python3 perf_harness.py ../../build/SerialTest --compare old.json
+
+import sys
+import os
+import json
+import argparse
+import tempfile
+import subprocess
+
+scenarioList = ["text+plot", "text", "plot", "off"]
+# key, title, format, scale
+columnList = [
+    ("throughput", "Rx B/s", "%.0f", 1),
+    ("peakRssKiB", "Peak RSS MiB", "%.1f", 1 / 1024),
+    ("cpuMs", "CPU s", "%.2f", 1 / 1000),
+    ("maxStallMs", "Max stall ms", "%.0f", 1),
+    ("stallCount", "Stalls", "%.0f", 1),
+    ("droppedBytes", "Dropped", "%.0f", 1),
+]
+
+
+def runScenario(args, scenario):
+    with tempfile.TemporaryDirectory() as tmpDir:
+        reportPath = os.path.join(tmpDir, "report.json")
+        cmd = [args.binary,
+               "--config-path", os.path.join(tmpDir, "preference.ini"),
+               "--perf-scenario", scenario,
+               "--perf-bytes", str(args.bytes),
+               "--perf-rate", str(args.rate),
+               "--perf-report", reportPath]
+        if args.offscreen:
+            cmd += ["-platform", "offscreen"]
+        print("Running", scenario, "...", file=sys.stderr)
+        returnCode = subprocess.call(cmd)
+        if not os.path.exists(reportPath):
+            print("No report, return code:", returnCode, file=sys.stderr)
+            return None
+        report = json.load(open(reportPath))
+    report["cpuMs"] = report["cpuUserMs"] + report["cpuSystemMs"]
+    return report
+
+
+def formatValue(report, column):
+    if report is None or column[0] not in report:
+        return "-"
+    return column[2] % (report[column[0]] * column[3])
+
+
+def printTable(results, baseline):
+    header = ["Scenario"]
+    for column in columnList:
+        header.append(column[1])
+        if baseline is not None:
+            header += ["Base", "Change"]
+    print("| " + " | ".join(header) + " |")
+    print("|" + "---|" * len(header))
+    for scenario in results:
+        report = results[scenario]
+        row = [scenario]
+        for column in columnList:
+            row.append(formatValue(report, column))
+            if baseline is None:
+                continue
+            base = baseline.get(scenario)
+            row.append(formatValue(base, column))
+            if report is None or base is None or base[column[0]] == 0:
+                row.append("-")
+            else:
+                row.append("%+.1f%%" % ((report[column[0]] - base[column[0]]) / base[column[0]] * 100))
+        if report is not None and report["timedOut"]:
+            row[0] += " (timeout)"
+        print("| " + " | ".join(row) + " |")
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("binary", help="path of SerialTest")
+parser.add_argument("--scenarios", default=",".join(scenarioList), help="comma separated, all by default")
+parser.add_argument("--bytes", type=int, default=10485760)
+parser.add_argument("--rate", type=int, default=92160, help="bytes/s, 0 for max")
+parser.add_argument("--offscreen", action="store_true", help="use the offscreen platform, no display is needed")
+parser.add_argument("--output", help="save the results in JSON")
+parser.add_argument("--compare", help="the results of another build")
+args = parser.parse_args()
+
+results = {}
+for scenario in args.scenarios.split(","):
+    results[scenario] = runScenario(args, scenario)
+
+if args.output:
+    json.dump(results, open(args.output, "w"), indent=4)
+
+baseline = json.load(open(args.compare)) if args.compare else None
+printTable(results, baseline)
+sys.exit(0 if all(results.values()) else 1)
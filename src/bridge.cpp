@@ -0,0 +1,154 @@
+#include "bridge.h"
+
+// stop reading the source when the target falls behind, then resume after it drains
+static const qint64 highWatermark = 256 * 1024;
+static const qint64 lowWatermark = 64 * 1024;
+
+Bridge::Bridge(Connection* device, QObject *parent)
+    : QObject{parent}
+{
+    m_device = device;
+    m_peer = new Connection(this);
+    m_peer->setRxBuffered(false); // the peer is not shown in the UI
+    m_reportTimer = new QTimer(this);
+    m_reportTimer->setInterval(1000);
+    connect(m_reportTimer, &QTimer::timeout, this, &Bridge::reportStats);
+    m_clock.start();
+}
+
+Bridge::~Bridge()
+{
+    stop();
+}
+
+void Bridge::start(Connection::Type type, const Connection::NetworkArgument& arg)
+{
+    stop();
+    m_toPeer = Direction();
+    m_toPeer.source = m_device;
+    m_toDevice = Direction();
+    m_toDevice.source = m_peer;
+    m_peer->setType(type);
+    m_peer->setArgument(arg);
+    // both connections live in this thread, use direct connections to avoid queuing
+    connect(m_device, &Connection::dataArrived, this, &Bridge::onDeviceData, Qt::DirectConnection);
+    connect(m_peer, &Connection::dataArrived, this, &Bridge::onPeerData, Qt::DirectConnection);
+    connect(m_device, &Connection::bytesWritten, this, &Bridge::onDeviceBytesWritten);
+    connect(m_peer, &Connection::bytesWritten, this, &Bridge::onPeerBytesWritten);
+    // a closed target never drains, don't leave the source paused
+    connect(m_peer, &Connection::disconnected, this, [ = ]
+    {
+        m_device->setRxPaused(false);
+    });
+    connect(m_device, &Connection::disconnected, this, [ = ]
+    {
+        m_peer->setRxPaused(false);
+    });
+    m_device->setRxBuffered(m_tapEnabled);
+    m_running = true;
+    m_reportTimer->start();
+    // connectFailed() might be emitted there, then stop() is called
+    m_peer->open();
+}
+
+void Bridge::stop()
+{
+    if(!m_running)
+        return;
+    m_running = false;
+    m_reportTimer->stop();
+    disconnect(m_device, nullptr, this, nullptr);
+    disconnect(m_peer, nullptr, this, nullptr);
+    m_peer->close();
+    m_device->setRxPaused(false);
+    m_peer->setRxPaused(false);
+    m_device->setRxBuffered(true);
+    reportStats();
+}
+
+bool Bridge::isRunning()
+{
+    return m_running;
+}
+
+Connection* Bridge::peer()
+{
+    return m_peer;
+}
+
+void Bridge::setTapEnabled(bool enabled)
+{
+    m_tapEnabled = enabled;
+    if(m_running)
+        m_device->setRxBuffered(enabled);
+}
+
+void Bridge::onDeviceData(const QByteArray& data)
+{
+    forward(m_peer, m_toPeer, data);
+}
+
+void Bridge::onPeerData(const QByteArray& data)
+{
+    forward(m_device, m_toDevice, data);
+}
+
+void Bridge::onDeviceBytesWritten()
+{
+    onWritten(m_device, m_toDevice);
+}
+
+void Bridge::onPeerBytesWritten()
+{
+    onWritten(m_peer, m_toPeer);
+}
+
+void Bridge::forward(Connection* target, Direction& direction, const QByteArray& data)
+{
+    if(data.isEmpty() || !target->isConnected())
+        return;
+    qint64 arrivalTime = m_clock.nsecsElapsed();
+    qint64 len = target->write(data);
+    if(len <= 0)
+        return;
+    direction.num += len;
+    if(!target->hasWriteFeedback())
+    {
+        addLatency(m_clock.nsecsElapsed() - arrivalTime);
+        return;
+    }
+    direction.queuedNum += len;
+    direction.pending.append(qMakePair(direction.queuedNum, arrivalTime));
+    if(target->bytesToWrite() >= highWatermark)
+        direction.source->setRxPaused(true);
+}
+
+void Bridge::onWritten(Connection* target, Direction& direction)
+{
+    // bytesToWrite() of a server is the backlog of the slowest client
+    qint64 writtenNum = direction.queuedNum - target->bytesToWrite();
+    qint64 currTime = m_clock.nsecsElapsed();
+    while(!direction.pending.isEmpty() && direction.pending.first().first <= writtenNum)
+    {
+        addLatency(currTime - direction.pending.first().second);
+        direction.pending.removeFirst();
+    }
+    if(direction.source->isRxPaused() && target->bytesToWrite() <= lowWatermark)
+        direction.source->setRxPaused(false);
+}
+
+void Bridge::addLatency(qint64 nsecs)
+{
+    m_latencySum += nsecs;
+    m_latencyCount++;
+    m_latencyMax = qMax(m_latencyMax, nsecs);
+}
+
+void Bridge::reportStats()
+{
+    qint64 avgLatency = m_latencyCount > 0 ? m_latencySum / m_latencyCount / 1000 : 0;
+    emit statsUpdated(m_toPeer.num, m_toDevice.num, avgLatency, m_latencyMax / 1000);
+    m_latencySum = 0;
+    m_latencyCount = 0;
+    m_latencyMax = 0;
+}
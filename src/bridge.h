@@ -0,0 +1,59 @@
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "connection.h"
+
+// forward the data between the device connection and a TCP server/UDP endpoint
+// the data is forwarded in the thread of the connections, without passing through the UI
+class Bridge : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Bridge(Connection* device, QObject *parent = nullptr);
+    ~Bridge();
+
+    void start(Connection::Type type, const Connection::NetworkArgument& arg); // async
+    void stop();
+    bool isRunning();
+    Connection* peer();
+    // show the data from the device in the UI
+    void setTapEnabled(bool enabled);
+signals:
+    // latency is the time from receiving the data to writing it out, in microseconds
+    void statsUpdated(qint64 toPeerNum, qint64 toDeviceNum, qint64 avgLatency, qint64 maxLatency);
+private slots:
+    void onDeviceData(const QByteArray& data);
+    void onPeerData(const QByteArray& data);
+    void onDeviceBytesWritten();
+    void onPeerBytesWritten();
+    void reportStats();
+private:
+    struct Direction
+    {
+        Connection* source = nullptr;
+        qint64 num = 0;
+        qint64 queuedNum = 0;
+        QList<QPair<qint64, qint64>> pending; // <end of data, arrival time>
+    };
+
+    Connection* m_device;
+    Connection* m_peer;
+    bool m_running = false;
+    bool m_tapEnabled = true;
+    QElapsedTimer m_clock;
+    QTimer* m_reportTimer;
+    Direction m_toPeer, m_toDevice;
+    qint64 m_latencySum = 0;
+    qint64 m_latencyCount = 0;
+    qint64 m_latencyMax = 0;
+
+    void forward(Connection* target, Direction& direction, const QByteArray& data);
+    void onWritten(Connection* target, Direction& direction);
+    void addLatency(qint64 nsecs);
+};
+
+#endif // BRIDGE_H
@@ -0,0 +1,110 @@
+#include "bridgedialog.h"
+#include "ui_bridgedialog.h"
+
+#include <QMessageBox>
+
+BridgeDialog::BridgeDialog(Bridge* bridge, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::BridgeDialog)
+{
+    ui->setupUi(this);
+    m_bridge = bridge;
+    m_settings = MySettings::defaultSettings();
+
+    ui->typeBox->addItem(tr("TCP Server"), Connection::TCP_Server);
+    ui->typeBox->addItem(tr("UDP"), Connection::UDP);
+    connect(ui->typeBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &BridgeDialog::onTypeChanged);
+    connect(m_bridge->peer(), &Connection::stateChanged, this, &BridgeDialog::onPeerStateChanged);
+    connect(m_bridge->peer(), &Connection::connectFailed, this, &BridgeDialog::onPeerConnectFailed);
+    connect(m_bridge, &Bridge::statsUpdated, this, &BridgeDialog::onStatsUpdated);
+
+    loadPreference();
+    onTypeChanged();
+    onPeerStateChanged(m_bridge->peer()->state());
+}
+
+BridgeDialog::~BridgeDialog()
+{
+    delete ui;
+}
+
+void BridgeDialog::on_startButton_clicked()
+{
+    Connection::NetworkArgument arg;
+    arg.localAddress = QHostAddress::Any;
+    arg.localPort = ui->localPortBox->value();
+    arg.remoteName = ui->remoteAddrEdit->text();
+    arg.remotePort = ui->remotePortBox->value();
+    m_bridge->setTapEnabled(ui->tapBox->isChecked());
+    m_bridge->start((Connection::Type)ui->typeBox->currentData().toInt(), arg);
+    savePreference();
+}
+
+void BridgeDialog::on_stopButton_clicked()
+{
+    m_bridge->stop();
+}
+
+void BridgeDialog::on_tapBox_clicked(bool checked)
+{
+    m_bridge->setTapEnabled(checked);
+    savePreference();
+}
+
+void BridgeDialog::onTypeChanged()
+{
+    bool isUDP = ui->typeBox->currentData().toInt() == Connection::UDP;
+    ui->remoteAddrLabel->setVisible(isUDP);
+    ui->remoteAddrEdit->setVisible(isUDP);
+    ui->remotePortLabel->setVisible(isUDP);
+    ui->remotePortBox->setVisible(isUDP);
+}
+
+void BridgeDialog::onPeerStateChanged(Connection::State newState)
+{
+    QString text;
+    if(newState == Connection::Unconnected)
+        text = tr("Stopped");
+    else if(newState == Connection::Bound)
+        text = tr("Waiting for clients");
+    else
+        text = tr("Forwarding");
+    ui->stateLabel->setText(tr("State") + ": " + text);
+    ui->startButton->setEnabled(newState == Connection::Unconnected);
+    ui->stopButton->setEnabled(newState != Connection::Unconnected);
+}
+
+void BridgeDialog::onPeerConnectFailed(const QString& info)
+{
+    m_bridge->stop();
+    QMessageBox::warning(this, tr("Error"), tr("Cannot start the bridge.") + "\n" + info);
+}
+
+void BridgeDialog::onStatsUpdated(qint64 toPeerNum, qint64 toDeviceNum, qint64 avgLatency, qint64 maxLatency)
+{
+    ui->statsLabel->setText(tr("Forwarded") + QString(": %1/%2 B\n").arg(toPeerNum).arg(toDeviceNum)
+                            + tr("Latency") + QString(": %1 us (") .arg(avgLatency) + tr("max") + QString(" %1 us)").arg(maxLatency));
+}
+
+void BridgeDialog::loadPreference()
+{
+    m_settings->beginGroup("SerialTest_Bridge");
+    int typeId = ui->typeBox->findData(m_settings->value("Type", Connection::TCP_Server).toInt());
+    ui->typeBox->setCurrentIndex((typeId == -1) ? 0 : typeId);
+    ui->localPortBox->setValue(m_settings->value("LocalPort", 37281).toInt());
+    ui->remoteAddrEdit->setText(m_settings->value("RemoteAddr", "127.0.0.1").toString());
+    ui->remotePortBox->setValue(m_settings->value("RemotePort", 37282).toInt());
+    ui->tapBox->setChecked(m_settings->value("Tap", true).toBool());
+    m_settings->endGroup();
+}
+
+void BridgeDialog::savePreference()
+{
+    m_settings->beginGroup("SerialTest_Bridge");
+    m_settings->setValue("Type", ui->typeBox->currentData().toInt());
+    m_settings->setValue("LocalPort", ui->localPortBox->value());
+    m_settings->setValue("RemoteAddr", ui->remoteAddrEdit->text());
+    m_settings->setValue("RemotePort", ui->remotePortBox->value());
+    m_settings->setValue("Tap", ui->tapBox->isChecked());
+    m_settings->endGroup();
+}
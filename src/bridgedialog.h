@@ -0,0 +1,40 @@
+#ifndef BRIDGEDIALOG_H
+#define BRIDGEDIALOG_H
+
+#include <QDialog>
+
+#include "bridge.h"
+#include "mysettings.h"
+
+namespace Ui
+{
+class BridgeDialog;
+}
+
+class BridgeDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BridgeDialog(Bridge* bridge, QWidget *parent = nullptr);
+    ~BridgeDialog();
+
+private slots:
+    void on_startButton_clicked();
+    void on_stopButton_clicked();
+    void on_tapBox_clicked(bool checked);
+    void onTypeChanged();
+    void onPeerStateChanged(Connection::State newState);
+    void onPeerConnectFailed(const QString& info);
+    void onStatsUpdated(qint64 toPeerNum, qint64 toDeviceNum, qint64 avgLatency, qint64 maxLatency);
+
+private:
+    Ui::BridgeDialog *ui;
+    Bridge* m_bridge;
+    MySettings* m_settings;
+
+    void loadPreference();
+    void savePreference();
+};
+
+#endif // BRIDGEDIALOG_H
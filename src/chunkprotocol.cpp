@@ -0,0 +1,513 @@
+#include "chunkprotocol.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QtEndian>
+
+namespace
+{
+const char Magic0 = '\xA5';
+const char Magic1 = '\x5A';
+const quint8 CAN = 0x18;
+
+const qsizetype HeaderLength = 7; // magic(2) + type(1) + payload length(4)
+const quint32 MinBlockSize = 64;
+const quint32 MaxBlockSize = 65536;
+const quint32 MaxPayloadSize = MaxBlockSize + 4; // Data: block index(4) + block
+const int MaxRangeNum = 1024; // in a Status frame, the rest is reported in the next round
+const int BlocksPerTick = 16;
+const char MapMagic[] = "SCHK";
+
+void appendLE32(QByteArray& dest, quint32 val)
+{
+    char buf[4];
+    qToLittleEndian(val, buf);
+    dest.append(buf, 4);
+}
+
+void appendLE64(QByteArray& dest, quint64 val)
+{
+    char buf[8];
+    qToLittleEndian(val, buf);
+    dest.append(buf, 8);
+}
+}
+
+ChunkProtocol::ChunkProtocol(QObject *parent)
+    : FileProtocol{parent},
+      m_crc32(32, 0x04C11DB7ULL, 0xFFFFFFFFULL, true, true, 0xFFFFFFFFULL) // CRC-32
+{
+    m_sendTimer = new QTimer(this);
+    m_sendTimer->setInterval(0);
+    connect(m_sendTimer, &QTimer::timeout, this, &ChunkProtocol::sendBlocks);
+}
+
+bool ChunkProtocol::startTransmit(const QString &filename)
+{
+    m_file.close();
+    m_file.setFileName(filename);
+    if(!m_file.open(QFile::ReadOnly))
+        return false;
+
+    m_fileSize = m_file.size();
+    m_blockSize = qBound(MinBlockSize, m_argument.blockSize, MaxBlockSize);
+    m_blockCount = (m_fileSize + m_blockSize - 1) / m_blockSize;
+    // size(8) + block size(4) + modification time(8) + name
+    // the receiver resumes only if the manifest is not changed
+    m_manifest.clear();
+    appendLE64(m_manifest, m_fileSize);
+    appendLE32(m_manifest, m_blockSize);
+    appendLE64(m_manifest, QFileInfo(filename).lastModified().toMSecsSinceEpoch());
+    m_manifest.append(QFileInfo(filename).fileName().toUtf8());
+
+    m_confirmedNum = 0;
+    m_retryCount = 0;
+    m_canCount = 0;
+    m_rxBuf.clear();
+    m_missing.clear();
+    m_isRunning = true;
+    sendRequest(frame(Manifest, m_manifest));
+    return true;
+}
+
+bool ChunkProtocol::startReceive(const QString &path)
+{
+    m_file.close();
+    m_receivePath = path;
+    m_manifest.clear();
+    m_retryCount = 0;
+    m_canCount = 0;
+    m_rxBuf.clear();
+    m_rxActive = false;
+    m_state = RxWaitManifest;
+    m_isRunning = true;
+    m_timer->start(m_argument.timeout);
+    return true;
+}
+
+void ChunkProtocol::stop()
+{
+    if(m_isRunning && m_state == RxData)
+        saveMap();
+    FileProtocol::stop();
+    m_sendTimer->stop();
+    m_state = Idle;
+}
+
+// the data sent while disconnected is lost, ask for the status again
+void ChunkProtocol::onReconnected()
+{
+    if(!m_isRunning)
+        return;
+    m_retryCount = 0;
+    if(m_state == TxWaitStatus)
+        sendRequest(m_lastRequest);
+    else if(m_state != TxSending)
+        m_timer->start(m_argument.timeout);
+}
+
+void ChunkProtocol::newData(const QByteArray &data)
+{
+    if(!m_isRunning)
+        return;
+    m_rxBuf.append(data);
+    parse();
+}
+
+void ChunkProtocol::parse()
+{
+    const char* buf = m_rxBuf.constData();
+    qsizetype size = m_rxBuf.size();
+    qsizetype pos = 0;
+    while(pos < size)
+    {
+        if(buf[pos] != Magic0)
+        {
+            // 5 CANs outside the frames: cancelled by the peer
+            m_canCount = ((quint8)buf[pos] == CAN) ? m_canCount + 1 : 0;
+            pos++;
+            if(m_canCount >= 5)
+            {
+                m_rxBuf.clear();
+                m_sendTimer->stop();
+                if(m_state == RxData)
+                    saveMap();
+                m_state = Idle;
+                fail(tr("Cancelled by the peer"), false);
+                return;
+            }
+            continue;
+        }
+        m_canCount = 0;
+        if(size - pos < HeaderLength)
+            break;
+        quint32 len = qFromLittleEndian<quint32>(buf + pos + 3);
+        if(buf[pos + 1] != Magic1 || len > MaxPayloadSize)
+        {
+            pos++;
+            continue;
+        }
+        if(size - pos < HeaderLength + len + 4)
+            break;
+        // CRC-32 of type, length and payload
+        m_crc32.reset();
+        m_crc32.addData(buf + pos + 2, HeaderLength - 2 + len);
+        if(m_crc32.getResult() != qFromLittleEndian<quint32>(buf + pos + HeaderLength + len))
+        {
+            // corrupted, search the next frame inside it
+            pos++;
+            continue;
+        }
+        onFrame((quint8)buf[pos + 2], QByteArray(buf + pos + HeaderLength, len));
+        if(!m_isRunning)
+        {
+            m_rxBuf.clear();
+            return;
+        }
+        pos += HeaderLength + len + 4;
+    }
+    m_rxBuf.remove(0, pos);
+}
+
+void ChunkProtocol::onFrame(quint8 type, const QByteArray &payload)
+{
+    if(m_state == TxWaitStatus || m_state == TxSending)
+        onTxFrame(type, payload);
+    else
+        onRxFrame(type, payload);
+}
+
+void ChunkProtocol::onTimeout()
+{
+    if(!m_isRunning)
+        return;
+    if(m_state == RxDone)
+    {
+        // nothing is missing, but the Done frame is lost
+        QFile::remove(m_mapPath);
+        m_state = Idle;
+        complete();
+        return;
+    }
+    if(m_state == RxData && m_rxActive)
+    {
+        m_rxActive = false;
+        m_timer->start(m_argument.timeout);
+        return;
+    }
+    // a corrupted length might hold the parser, skip it
+    if(!m_rxBuf.isEmpty())
+    {
+        m_rxBuf.remove(0, 1);
+        parse();
+        if(!m_isRunning)
+            return;
+    }
+    if(++m_retryCount > m_argument.retryNum)
+    {
+        if(m_state == RxData)
+            saveMap();
+        m_state = Idle;
+        fail(tr("Timeout"));
+        return;
+    }
+    if(m_state == TxWaitStatus)
+        emit send(m_lastRequest);
+    m_timer->start(m_argument.timeout);
+}
+
+QByteArray ChunkProtocol::frame(quint8 type, const QByteArray &payload)
+{
+    QByteArray result;
+    result.reserve(HeaderLength + payload.size() + 4);
+    result.append(Magic0);
+    result.append(Magic1);
+    result.append((char)type);
+    appendLE32(result, payload.size());
+    result.append(payload);
+    m_crc32.reset();
+    m_crc32.addData(result.constData() + 2, result.size() - 2);
+    appendLE32(result, m_crc32.getResult());
+    return result;
+}
+
+qint64 ChunkProtocol::blockLength(quint32 index)
+{
+    return qMin((qint64)m_blockSize, m_fileSize - (qint64)index * m_blockSize);
+}
+
+void ChunkProtocol::sendRequest(const QByteArray &request)
+{
+    m_lastRequest = request;
+    m_state = TxWaitStatus;
+    emit send(request);
+    m_timer->start(m_argument.timeout);
+}
+
+void ChunkProtocol::onTxFrame(quint8 type, const QByteArray &payload)
+{
+    // the Status of a resent request might arrive twice
+    if(type != Status || m_state != TxWaitStatus)
+        return;
+    // missing block number(4) + ranges(start(4) + count(4))
+    if(payload.size() < 4 || (payload.size() - 4) % 8 != 0)
+        return;
+    const char* buf = payload.constData();
+    quint32 missingNum = qFromLittleEndian<quint32>(buf);
+    QList<Range> ranges;
+    for(qsizetype i = 4; i < payload.size(); i += 8)
+    {
+        Range range = {qFromLittleEndian<quint32>(buf + i), qFromLittleEndian<quint32>(buf + i + 4)};
+        if(range.count == 0 || range.start >= m_blockCount || range.count > m_blockCount - range.start)
+            return;
+        ranges.append(range);
+    }
+    if(missingNum > m_blockCount || (missingNum > 0 && ranges.isEmpty()))
+        return;
+
+    m_timer->stop();
+    m_retryCount = 0;
+    qint64 confirmedNum = (missingNum == 0) ? m_fileSize : qMin(m_fileSize, (qint64)(m_blockCount - missingNum) * m_blockSize);
+    if(confirmedNum > m_confirmedNum)
+    {
+        emit dataTransmitted(confirmedNum - m_confirmedNum);
+        m_confirmedNum = confirmedNum;
+    }
+    if(missingNum == 0)
+    {
+        emit send(frame(Done, QByteArray()));
+        m_state = Idle;
+        complete();
+        return;
+    }
+
+    m_missing = ranges;
+    m_rangeIndex = 0;
+    m_rangeOffset = 0;
+    // the receiver reports the lost blocks after each round
+    m_roundBudget = m_argument.window > 0 ? m_argument.window : m_fileSize;
+    m_state = TxSending;
+    m_sendTimer->start();
+}
+
+void ChunkProtocol::sendBlocks()
+{
+    if(!m_isRunning || m_state != TxSending)
+    {
+        m_sendTimer->stop();
+        return;
+    }
+    for(int i = 0; i < BlocksPerTick; i++)
+    {
+        if(m_rangeIndex >= m_missing.size() || m_roundBudget <= 0)
+        {
+            m_sendTimer->stop();
+            sendRequest(frame(Poll, QByteArray()));
+            return;
+        }
+        quint32 index = m_missing[m_rangeIndex].start + m_rangeOffset;
+        qint64 len = blockLength(index);
+        QByteArray payload;
+        payload.reserve(4 + len);
+        appendLE32(payload, index);
+        payload.resize(4 + len);
+        if(!m_file.seek((qint64)index * m_blockSize) || m_file.read(payload.data() + 4, len) != len)
+        {
+            m_sendTimer->stop();
+            m_state = Idle;
+            fail(tr("Failed to read the file"));
+            return;
+        }
+        emit send(frame(Data, payload));
+        m_roundBudget -= len;
+        if(++m_rangeOffset >= m_missing[m_rangeIndex].count)
+        {
+            m_rangeIndex++;
+            m_rangeOffset = 0;
+        }
+    }
+}
+
+void ChunkProtocol::onRxFrame(quint8 type, const QByteArray &payload)
+{
+    m_retryCount = 0;
+    if(type == Manifest)
+    {
+        if(m_state != RxWaitManifest && payload == m_manifest)
+            sendStatus(); // the Status is lost
+        else
+            onManifest(payload);
+        return;
+    }
+    if(m_state == RxWaitManifest)
+        return;
+
+    if(type == Data && m_state == RxData)
+    {
+        m_rxActive = true;
+        if(payload.size() < 4)
+            return;
+        quint32 index = qFromLittleEndian<quint32>(payload.constData());
+        if(index >= m_blockCount || payload.size() - 4 != blockLength(index))
+            return;
+        char* bits = m_blockMap.data() + index / 8;
+        if(*bits & (1 << (index % 8)))
+            return;
+        if(!m_file.seek((qint64)index * m_blockSize) || m_file.write(payload.constData() + 4, payload.size() - 4) != payload.size() - 4)
+        {
+            saveMap();
+            m_state = Idle;
+            fail(tr("Failed to write the file"));
+            return;
+        }
+        *bits |= (1 << (index % 8));
+        m_receivedBlockNum++;
+        m_mapDirty = true;
+        emit dataReceived(payload.size() - 4);
+    }
+    else if(type == Poll)
+    {
+        saveMap();
+        sendStatus();
+    }
+    else if(type == Done && m_receivedBlockNum == m_blockCount)
+    {
+        QFile::remove(m_mapPath);
+        m_state = Idle;
+        complete();
+    }
+}
+
+void ChunkProtocol::onManifest(const QByteArray &payload)
+{
+    if(payload.size() < 20)
+        return;
+    if(m_state == RxData)
+        saveMap(); // the sender is changed, keep the progress of the previous file
+    const char* buf = payload.constData();
+    qint64 fileSize = qFromLittleEndian<qint64>(buf);
+    quint32 blockSize = qFromLittleEndian<quint32>(buf + 8);
+    if(fileSize < 0 || blockSize < MinBlockSize || blockSize > MaxBlockSize || (fileSize + blockSize - 1) / blockSize > 0xFFFFFFFFLL)
+        return;
+
+    m_file.close();
+    m_manifest = payload;
+    m_fileSize = fileSize;
+    m_blockSize = blockSize;
+    m_blockCount = (m_fileSize + m_blockSize - 1) / m_blockSize;
+    QString path = receiveFilePath(QString::fromUtf8(payload.mid(20)));
+    m_mapPath = path + ".chunkmap";
+    m_file.setFileName(path);
+
+    bool resume = QFileInfo::exists(path) && loadMap();
+    if(!resume)
+    {
+        m_blockMap = QByteArray((m_blockCount + 7) / 8, '\0');
+        m_receivedBlockNum = 0;
+    }
+    m_firstMissing = 0;
+    if(!m_file.open(resume ? QFile::ReadWrite : (QFile::ReadWrite | QFile::Truncate)) || !m_file.resize(m_fileSize))
+    {
+        m_state = Idle;
+        fail(tr("Failed to open") + " " + path);
+        return;
+    }
+    if(resume)
+    {
+        emit message(tr("Resuming") + " " + path + ", " + QString::number(m_blockCount - m_receivedBlockNum) + " " + tr("blocks left"));
+        emit dataReceived(qMin(m_fileSize, (qint64)m_receivedBlockNum * m_blockSize));
+    }
+    else
+        emit message(tr("Receiving") + " " + path);
+    m_mapDirty = true;
+    saveMap();
+    m_rxActive = false;
+    m_state = RxData;
+    sendStatus();
+}
+
+void ChunkProtocol::sendStatus()
+{
+    quint32 missingNum = m_blockCount - m_receivedBlockNum;
+    QByteArray payload;
+    appendLE32(payload, missingNum);
+    int rangeNum = 0;
+    // the received prefix is not scanned again in the next rounds
+    m_firstMissing = findBlock(m_firstMissing, false);
+    quint32 i = m_firstMissing;
+    while(i < m_blockCount && rangeNum < MaxRangeNum)
+    {
+        quint32 end = findBlock(i, true);
+        appendLE32(payload, i);
+        appendLE32(payload, end - i);
+        rangeNum++;
+        i = findBlock(end, false);
+    }
+    m_state = (missingNum == 0) ? RxDone : RxData;
+    emit send(frame(Status, payload));
+    m_timer->start(m_argument.timeout);
+}
+
+// the first block from index in the given state, m_blockCount if none
+// the bytes without such a block are skipped as a whole
+quint32 ChunkProtocol::findBlock(quint32 index, bool received)
+{
+    const uchar* bits = reinterpret_cast<const uchar*>(m_blockMap.constData());
+    const uchar skipped = received ? 0x00 : 0xFF;
+    while(index < m_blockCount)
+    {
+        if(index % 8 == 0 && bits[index / 8] == skipped)
+        {
+            index += 8;
+            continue;
+        }
+        if(((bits[index / 8] >> (index % 8)) & 1) == received)
+            return index;
+        index++;
+    }
+    return m_blockCount;
+}
+
+// map file: magic(4) + manifest length(4) + manifest + bitmap
+bool ChunkProtocol::loadMap()
+{
+    QFile mapFile(m_mapPath);
+    if(!mapFile.open(QFile::ReadOnly))
+        return false;
+    QByteArray content = mapFile.readAll();
+    qsizetype bitmapSize = (m_blockCount + 7) / 8;
+    if(content.size() < 8 || !content.startsWith(MapMagic))
+        return false;
+    quint32 manifestSize = qFromLittleEndian<quint32>(content.constData() + 4);
+    if(manifestSize != (quint32)m_manifest.size() || content.size() != 8 + manifestSize + bitmapSize)
+        return false;
+    if(content.mid(8, manifestSize) != m_manifest)
+        return false;
+
+    m_blockMap = content.mid(8 + manifestSize);
+    uchar* bits = reinterpret_cast<uchar*>(m_blockMap.data());
+    // the padding bits should not count as blocks
+    if(m_blockCount % 8 != 0)
+        bits[bitmapSize - 1] &= (1 << (m_blockCount % 8)) - 1;
+    m_receivedBlockNum = 0;
+    for(qsizetype i = 0; i < bitmapSize; i++)
+        m_receivedBlockNum += qPopulationCount(bits[i]);
+    return true;
+}
+
+// replaced atomically, a crash while saving keeps the previous map
+void ChunkProtocol::saveMap()
+{
+    if(!m_mapDirty)
+        return;
+    m_file.flush(); // the map should not claim the unwritten blocks
+    QByteArray content(MapMagic);
+    appendLE32(content, m_manifest.size());
+    content.append(m_manifest);
+    content.append(m_blockMap);
+
+    QSaveFile mapFile(m_mapPath);
+    if(mapFile.open(QFile::WriteOnly) && mapFile.write(content) == content.size() && mapFile.commit())
+        m_mapDirty = false;
+}
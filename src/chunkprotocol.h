@@ -0,0 +1,96 @@
+#ifndef CHUNKPROTOCOL_H
+#define CHUNKPROTOCOL_H
+
+#include <QByteArray>
+
+#include "fileprotocol.h"
+#include "asynccrc.h"
+
+// resumable transfer in fixed-size blocks, each frame is protected by CRC-32
+// the sender announces the file in a manifest, the receiver reports the missing blocks,
+// then the sender resends only those until nothing is missing.
+// the receiver keeps the received blocks in a .chunkmap file beside the received file,
+// so the transfer can be resumed after reconnecting or restarting.
+class ChunkProtocol : public FileProtocol
+{
+    Q_OBJECT
+public:
+    explicit ChunkProtocol(QObject *parent = nullptr);
+
+    bool startTransmit(const QString& filename) override;
+    bool startReceive(const QString& path) override;
+    void newData(const QByteArray& data) override;
+    void stop() override;
+    void onReconnected() override;
+protected:
+    enum FrameType
+    {
+        Manifest = 1,
+        Status,
+        Data,
+        Poll,
+        Done,
+    };
+
+    enum State
+    {
+        Idle = 0,
+        // transmit
+        TxWaitStatus, // Manifest or Poll is sent
+        TxSending,
+        // receive
+        RxWaitManifest,
+        RxData,
+        RxDone, // nothing is missing, wait for Done
+    };
+
+    struct Range
+    {
+        quint32 start;
+        quint32 count;
+    };
+
+    State m_state = Idle;
+    AsyncCRC m_crc32;
+    QByteArray m_rxBuf;
+    int m_canCount = 0;
+    QByteArray m_manifest;
+    qint64 m_fileSize = 0;
+    quint32 m_blockSize = 0;
+    quint32 m_blockCount = 0;
+
+    // transmit
+    QList<Range> m_missing;
+    int m_rangeIndex = 0;
+    quint32 m_rangeOffset = 0;
+    qint64 m_roundBudget = 0;
+    qint64 m_confirmedNum = 0;
+    QByteArray m_lastRequest; // resent on timeout
+    QTimer* m_sendTimer;
+
+    // receive
+    QByteArray m_blockMap; // 1 bit per block, LSB first, the same as the map file
+    quint32 m_receivedBlockNum = 0;
+    quint32 m_firstMissing = 0; // the blocks before it are all received
+    bool m_mapDirty = false; // changed since the last saveMap()
+    QString m_mapPath;
+    bool m_rxActive = false; // data arrived in the timeout period
+
+    void onTimeout() override;
+    void parse();
+    void onFrame(quint8 type, const QByteArray& payload);
+    void onTxFrame(quint8 type, const QByteArray& payload);
+    void onRxFrame(quint8 type, const QByteArray& payload);
+    QByteArray frame(quint8 type, const QByteArray& payload);
+    qint64 blockLength(quint32 index);
+
+    void sendRequest(const QByteArray& request);
+    void sendBlocks();
+    void onManifest(const QByteArray& payload);
+    void sendStatus();
+    quint32 findBlock(quint32 index, bool received);
+    bool loadMap();
+    void saveMap();
+};
+
+#endif // CHUNKPROTOCOL_H
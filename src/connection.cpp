@@ -1,7 +1,32 @@
 ﻿#include "connection.h"
+#include "tracer.h"
 
 #include <QNetworkDatagram>
 #include <QMetaEnum>
+#include <QtEndian>
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <netinet/in.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+
+// preallocated buffers for recvmmsg()
+struct Connection::UDPBatch
+{
+    static const int num = 64;
+    static const int slotSize = 65536; // the max size of a datagram
+    QByteArray slab;
+    int fd = -1;
+    mmsghdr msgs[num];
+    iovec iovecs[num];
+    sockaddr_storage addrs[num];
+    char controls[num][CMSG_SPACE(sizeof(timespec))];
+};
+#endif
 
 Connection::Connection(QObject *parent)
     : QObject{parent}
@@ -14,11 +39,34 @@ Connection::Connection(QObject *parent)
     m_TCPSocket = new QTcpSocket();
     m_TCPServer = new QTcpServer();
     m_UDPSocket = new QUdpSocket();
+    m_PTY = new PtyDevice(this);
+    m_localSocket = new QLocalSocket(this);
+    m_localServer = new QLocalServer(this);
+    m_unixDatagram = new UnixDatagramSocket(this);
+    m_fifo = new FifoDevice(this);
+    m_generator = new DataGenerator(this);
+    // shared by Unix_Client and Unix_Server, the signal is kept connected
+    connect(m_unixDatagram, &QIODevice::readyRead, this, &Connection::onReadyRead);
 
     BTServer_initServiceInfo();
 
     m_pollTimer->setInterval(100); // default interval
     connect(m_pollTimer, &QTimer::timeout, this, &Connection::onPollingTimeout);
+    m_SP_lineWatcher = new ModemLineWatcher(this);
+    connect(m_SP_lineWatcher, &ModemLineWatcher::edgesAvailable, this, &Connection::SP_onLineEdgesAvailable);
+    connect(m_SP_lineWatcher, &ModemLineWatcher::stopped, this, &Connection::SP_onLineWatcherStopped);
+
+    m_TxFlushTimer = new QTimer(this);
+    m_TxFlushTimer->setSingleShot(true);
+    m_TxFlushTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_TxFlushTimer, &QTimer::timeout, this, &Connection::flushTxQueue);
+}
+
+Connection::~Connection()
+{
+#ifdef Q_OS_LINUX
+    delete m_UDPBatch;
+#endif
 }
 
 Connection::Type Connection::type()
@@ -34,6 +82,7 @@ bool Connection::setType(Type type)
     m_lastSPArgumentValid = false;
     m_lastBTArgumentValid = false;
     m_lastNetArgumentValid = false;
+    m_lastLocalArgumentValid = false;
     updateSignalSlot();
     return true;
 }
@@ -51,9 +100,29 @@ Connection::State Connection::state()
 void Connection::setPolling(bool enabled)
 {
     m_pollTimerEnabled = enabled;
-    if(!enabled)
+    SP_updateLineMonitor();
+}
+
+void Connection::SP_updateLineMonitor()
+{
+    bool enabled = m_pollTimerEnabled && isConnected();
+    if(!enabled || m_type != SerialPort)
+    {
         m_pollTimer->stop();
-    else if(enabled && isConnected())
+        m_SP_lineWatcher->stop();
+        m_SP_lineWatching = false;
+        if(enabled)
+            m_pollTimer->start();
+        return;
+    }
+    if(m_SP_lineWatching || m_pollTimer->isActive())
+        return;
+    // report the current state, then wait for the changes
+    onPollingTimeout();
+#ifdef Q_OS_LINUX
+    m_SP_lineWatching = m_SP_lineWatcher->start(m_serialPort->handle());
+#endif
+    if(!m_SP_lineWatching)
         m_pollTimer->start();
 }
 
@@ -97,6 +166,26 @@ void Connection::setArgument(NetworkArgument arg)
     m_currNetArgument = arg;
 }
 
+void Connection::setArgument(LocalArgument arg)
+{
+    m_currLocalArgument = arg;
+}
+
+void Connection::setArgument(GeneratorArgument arg)
+{
+    m_currGeneratorArgument = arg;
+}
+
+Connection::LocalArgument Connection::getLocalArgument()
+{
+    return m_currLocalArgument;
+}
+
+Connection::GeneratorArgument Connection::getGeneratorArgument()
+{
+    return m_currGeneratorArgument;
+}
+
 Connection::SerialPortArgument Connection::getSerialPortArgument()
 {
     return m_currSPArgument;
@@ -149,8 +238,10 @@ QStringList Connection::arg2StringList(const SerialPortArgument& arg)
         QString::number(arg.parity),
         QString::number(arg.flowControl),
     };
-    if(arg.name != arg.id)
+    if(arg.name != arg.id || arg.lowLatency)
         argList += arg.id;
+    if(arg.lowLatency)
+        argList += "1";
     return argList;
 }
 
@@ -168,6 +259,56 @@ QStringList Connection::arg2StringList(const NetworkArgument &arg)
     return argList;
 }
 
+QStringList Connection::arg2StringList(const LocalArgument& arg)
+{
+    QStringList argList
+    {
+        arg.path,
+        arg.writePath,
+        arg.datagram ? "1" : "0",
+    };
+    if(!arg.alias.isEmpty())
+        argList += arg.alias;
+    return argList;
+}
+
+Connection::LocalArgument Connection::stringList2LocalArg(const QStringList& list)
+{
+    Connection::LocalArgument arg;
+    if(list.size() >= 3)
+    {
+        arg.path = list[0];
+        arg.writePath = list[1];
+        arg.datagram = (list[2] == "1");
+        if(list.size() >= 4)
+            arg.alias = list[3];
+    }
+    return arg;
+}
+
+QStringList Connection::arg2StringList(const GeneratorArgument& arg)
+{
+    QStringList argList
+    {
+        QString::number(arg.workload),
+        QString::number(arg.rate),
+        QString::fromLatin1(arg.frame.toHex(' ')),
+    };
+    return argList;
+}
+
+Connection::GeneratorArgument Connection::stringList2GeneratorArg(const QStringList& list)
+{
+    Connection::GeneratorArgument arg;
+    if(list.size() >= 3)
+    {
+        arg.workload = (DataGenerator::Workload)list[0].toInt();
+        arg.rate = list[1].toLongLong();
+        arg.frame = QByteArray::fromHex(list[2].toLatin1());
+    }
+    return arg;
+}
+
 Connection::SerialPortArgument Connection::stringList2SPArg(const QStringList& list)
 {
     Connection::SerialPortArgument arg;
@@ -180,6 +321,8 @@ Connection::SerialPortArgument Connection::stringList2SPArg(const QStringList& l
             arg.id = arg.name;
         switch(list.size())
         {
+        case 8:
+            arg.lowLatency = (list[7] == "1");
         case 7:
             arg.id = list[6];
         case 6:
@@ -235,7 +378,11 @@ void Connection::open()
 
         // serialport doesn't have connected() signal(open() is sync function), so call onConnected() manually
         if(m_serialPort->open(QIODevice::ReadWrite))
+        {
+            m_SP_lowLatency = m_currSPArgument.lowLatency && SP_setLowLatency(true);
+            m_SP_RTTPending = false;
             onConnected();
+        }
         else
             emit connectFailed(m_serialPort->errorString());
     }
@@ -335,6 +482,68 @@ void Connection::open()
                                    .arg(m_currNetArgument.localAddress.toString())
                                    .arg(m_currNetArgument.localPort));
     }
+    else if(m_type == PTY)
+    {
+        // like serialport, open() is sync function
+        if(m_PTY->openPty(m_PTYLinkPath))
+            onConnected();
+        else
+            emit connectFailed(m_PTY->errorString());
+    }
+    else if(m_type == Unix_Client)
+    {
+        if(m_currLocalArgument.datagram)
+        {
+            if(m_unixDatagram->connectTo(m_currLocalArgument.path))
+                onConnected();
+            else
+                emit connectFailed(m_unixDatagram->errorString());
+            return;
+        }
+        changeState(Connecting);
+        m_localSocket->connectToServer(m_currLocalArgument.path);
+    }
+    else if(m_type == Unix_Server)
+    {
+        if(m_currLocalArgument.datagram)
+        {
+            // no connection, bound = connected
+            if(m_unixDatagram->bind(m_currLocalArgument.path))
+                onConnected();
+            else
+                emit connectFailed(m_unixDatagram->errorString());
+            return;
+        }
+        // remove the socket left by the last run
+        QLocalServer::removeServer(m_currLocalArgument.path);
+        if(!m_localServer->listen(m_currLocalArgument.path))
+        {
+            emit connectFailed(tr("Failed to listen to ") + "\n" + m_currLocalArgument.path + "\n" + m_localServer->errorString());
+            return;
+        }
+        changeState(Bound);
+        // onClientConnected() will be called when client is connected
+        afterConnected();
+    }
+    else if(m_type == Fifo)
+    {
+        if(m_fifo->openFifo(m_currLocalArgument.path, m_currLocalArgument.writePath))
+            onConnected();
+        else
+            emit connectFailed(m_fifo->errorString());
+    }
+    else if(m_type == Generator)
+    {
+        if(m_generator->start(m_currGeneratorArgument.workload, m_currGeneratorArgument.rate, m_currGeneratorArgument.frame))
+            onConnected();
+        else
+            emit connectFailed(m_generator->errorString());
+    }
+}
+
+bool Connection::isUnixDatagram()
+{
+    return (m_type == Unix_Client || m_type == Unix_Server) && m_currLocalArgument.datagram;
 }
 
 bool Connection::reopen()
@@ -357,6 +566,12 @@ bool Connection::reopen()
             return false;
         setArgument(m_lastNetArgument);
     }
+    else if(m_type == Unix_Client || m_type == Unix_Server || m_type == Fifo)
+    {
+        if(!m_lastLocalArgumentValid)
+            return false;
+        setArgument(m_lastLocalArgument);
+    }
     open();
     return true;
 }
@@ -365,8 +580,16 @@ void Connection::close(bool forced)
 {
     if(m_state == Unconnected && !forced)
         return;
+    flushTxQueue();
     if(m_type == SerialPort)
     {
+        // stop the watcher before the descriptor is closed
+        m_pollTimer->stop();
+        m_SP_lineWatcher->stop();
+        m_SP_lineWatching = false;
+        if(m_SP_lowLatency)
+            SP_setLowLatency(false);
+        m_SP_lowLatency = false;
         m_serialPort->close();
     }
     else if(m_type == BT_Client)
@@ -379,6 +602,8 @@ void Connection::close(bool forced)
         m_RfcommServiceInfo.unregisterService();
         m_BTServer->close();
         m_BTTxClients.clear();
+        m_broadcastCursors.clear();
+        Server_trimBroadcast();
         for(auto it = m_BTConnectedClients.begin(); it != m_BTConnectedClients.end(); ++it)
             (*it)->close();
         // the delete operation will be done in Server_onClientDisconnected()
@@ -419,6 +644,8 @@ void Connection::close(bool forced)
     {
         m_TCPServer->close();
         m_TCPTxClients.clear();
+        m_broadcastCursors.clear();
+        Server_trimBroadcast();
         for(auto it = m_TCPConnectedClients.begin(); it != m_TCPConnectedClients.end(); ++it)
             (*it)->close();
         // the delete operation will be done in Server_onClientDisconnected()
@@ -427,6 +654,35 @@ void Connection::close(bool forced)
     {
         m_UDPSocket->close();
     }
+    else if(m_type == PTY)
+    {
+        m_PTY->close();
+    }
+    else if(isUnixDatagram())
+    {
+        m_unixDatagram->close();
+    }
+    else if(m_type == Unix_Client)
+    {
+        m_localSocket->abort();
+    }
+    else if(m_type == Unix_Server)
+    {
+        m_localServer->close();
+        m_broadcastCursors.clear();
+        Server_trimBroadcast();
+        for(auto it = m_localConnectedClients.begin(); it != m_localConnectedClients.end(); ++it)
+            (*it)->close();
+        // the delete operation will be done in Server_onClientDisconnected()
+    }
+    else if(m_type == Fifo)
+    {
+        m_fifo->close();
+    }
+    else if(m_type == Generator)
+    {
+        m_generator->close();
+    }
     onDisconnected();
 }
 
@@ -436,14 +692,17 @@ void Connection::updateSignalSlot()
     disconnect(m_lastOnErrorConn);
     disconnect(m_lastOnConnectedConn);
     disconnect(m_lastOnDisconnectedConn);
+    disconnect(m_lastBytesWrittenConn);
     if(m_type == SerialPort)
     {
         m_lastReadyReadConn = connect(m_serialPort, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_serialPort, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
         m_lastOnErrorConn = connect(m_serialPort, &QSerialPort::errorOccurred, this, &Connection::onErrorOccurred);
     }
     else if(m_type == BT_Client)
     {
         m_lastReadyReadConn = connect(m_BTSocket, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_BTSocket, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
         m_lastOnErrorConn = connect(m_BTSocket, QOverload<QBluetoothSocket::SocketError>::of(&QBluetoothSocket::error), this, &Connection::onErrorOccurred);
         m_lastOnConnectedConn = connect(m_BTSocket, &QBluetoothSocket::connected, this, &Connection::onConnected);
         m_lastOnDisconnectedConn = connect(m_BTSocket, &QBluetoothSocket::disconnected, this, &Connection::onDisconnected);
@@ -465,6 +724,7 @@ void Connection::updateSignalSlot()
     else if(m_type == TCP_Client)
     {
         m_lastReadyReadConn = connect(m_TCPSocket, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_TCPSocket, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
         m_lastOnErrorConn = connect(m_TCPSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, &Connection::onErrorOccurred);
 #else
@@ -490,6 +750,39 @@ void Connection::updateSignalSlot()
         m_lastOnConnectedConn = connect(m_UDPSocket, &QAbstractSocket::connected, this, &Connection::onConnected);
         m_lastOnDisconnectedConn = connect(m_UDPSocket, &QAbstractSocket::disconnected, this, &Connection::onDisconnected);
     }
+    else if(m_type == PTY)
+    {
+        // the slave is kept open, so the master has no disconnected() or error
+        m_lastReadyReadConn = connect(m_PTY, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_PTY, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
+    }
+    else if(m_type == Unix_Client)
+    {
+        // for the stream mode, the datagram socket is connected in the constructor
+        m_lastReadyReadConn = connect(m_localSocket, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_localSocket, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
+        m_lastOnErrorConn = connect(m_localSocket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error), this, &Connection::onErrorOccurred);
+#else
+        m_lastOnErrorConn = connect(m_localSocket, &QLocalSocket::errorOccurred, this, &Connection::onErrorOccurred);
+#endif
+        m_lastOnConnectedConn = connect(m_localSocket, &QLocalSocket::connected, this, &Connection::onConnected);
+        m_lastOnDisconnectedConn = connect(m_localSocket, &QLocalSocket::disconnected, this, &Connection::onDisconnected);
+    }
+    else if(m_type == Unix_Server)
+    {
+        // readyRead(), disconnected() is connected in onClientConnected()
+        m_lastOnConnectedConn = connect(m_localServer, &QLocalServer::newConnection, this, &Connection::Server_onClientConnected);
+    }
+    else if(m_type == Fifo)
+    {
+        m_lastReadyReadConn = connect(m_fifo, &QIODevice::readyRead, this, &Connection::onReadyRead);
+        m_lastBytesWrittenConn = connect(m_fifo, &QIODevice::bytesWritten, this, &Connection::bytesWritten);
+    }
+    else if(m_type == Generator)
+    {
+        m_lastReadyReadConn = connect(m_generator, &QIODevice::readyRead, this, &Connection::onReadyRead);
+    }
 }
 
 void Connection::BTServer_initServiceInfo()
@@ -556,36 +849,308 @@ void Connection::changeState(State newState)
 
 void Connection::onReadyRead()
 {
+    if(m_RxPaused)
+        return; // read by setRxPaused(false)
+    receive(qobject_cast<QIODevice*>(sender()));
+}
+
+// client: the sender for BT_Server, TCP_Server and Unix_Server
+void Connection::receive(QIODevice* client)
+{
+    TraceScope scope("Connection::onReadyRead");
+    QByteArray data;
     if(m_type == SerialPort)
     {
-        m_buf += m_serialPort->readAll();
+        data = m_serialPort->readAll();
     }
     else if(m_type == BT_Client)
     {
-        m_buf += m_BTSocket->readAll();
+        data = m_BTSocket->readAll();
     }
-    else if(m_type == BT_Server)
+    else if(m_type == TCP_Client)
     {
-        m_buf += qobject_cast<QBluetoothSocket*>(sender())->readAll();
+        data = m_TCPSocket->readAll();
     }
-    else if(m_type == TCP_Client)
+    else if(m_type == PTY)
     {
-        m_buf += m_TCPSocket->readAll();
+        data = m_PTY->readAll();
     }
-    else if(m_type == TCP_Server)
+    else if(isUnixDatagram())
+    {
+        data = m_unixDatagram->receiveAll();
+    }
+    else if(m_type == Unix_Client)
     {
-        m_buf += qobject_cast<QTcpSocket*>(sender())->readAll();
+        data = m_localSocket->readAll();
+    }
+    else if(m_type == Fifo)
+    {
+        data = m_fifo->readAll();
+    }
+    else if(m_type == Generator)
+    {
+        data = m_generator->readAll();
+    }
+    else if(m_type == BT_Server || m_type == TCP_Server || m_type == Unix_Server)
+    {
+        data = client->readAll();
+        auto idIt = m_clientIds.constFind(client);
+        if(idIt != m_clientIds.cend())
+        {
+            ClientStream& stream = m_clientStreams[*idIt];
+            stream.RxCount += data.size();
+            // only the subscribed streams are kept, others are counted
+            if(stream.subscribed && m_RxBuffered)
+                stream.buf += data;
+        }
     }
     else if(m_type == UDP)
     {
         // readyRead() will not be emitted unless all pending datagrams are handled
         // this should be handled as soon as possible
+#ifdef Q_OS_LINUX
+        UDP_receiveBatch(data);
+#else
         while(m_UDPSocket->hasPendingDatagrams())
-            m_buf += m_UDPSocket->receiveDatagram().data();
+        {
+            QNetworkDatagram datagram = m_UDPSocket->receiveDatagram();
+            UDP_setDatagramSender(UDP_addDatagramInfo(datagram.data().size(), 0), datagram.senderAddress(), datagram.senderPort());
+            data += datagram.data();
+        }
+#endif
+    }
+    scope.setArg(data.size());
+    onDataArrived(data); // once per batch
+}
+
+// the sender is filled by the caller
+Connection::DatagramRecord& Connection::UDP_addDatagramInfo(qint32 size, qint64 timestamp)
+{
+    if(m_datagramRing.isEmpty())
+        m_datagramRing.resize(m_maxDatagramInfoNum);
+    int index = (m_datagramHead + m_datagramNum) % m_maxDatagramInfoNum;
+    if(m_datagramNum < m_maxDatagramInfoNum)
+        m_datagramNum++;
+    else
+        m_datagramHead = (m_datagramHead + 1) % m_maxDatagramInfoNum;
+    DatagramRecord& record = m_datagramRing[index];
+    record.pos = m_UDPRxPos;
+    record.timestamp = timestamp;
+    record.size = size;
+    record.senderPort = 0;
+    record.protocol = QAbstractSocket::UnknownNetworkLayerProtocol;
+    m_UDPRxPos += size;
+    return record;
+}
+
+void Connection::UDP_setDatagramSender(DatagramRecord& record, const QHostAddress& sender, quint16 senderPort)
+{
+    record.senderPort = senderPort;
+    record.protocol = sender.protocol();
+    if(record.protocol == QAbstractSocket::IPv4Protocol)
+        qToBigEndian(sender.toIPv4Address(), record.sender);
+    else if(record.protocol == QAbstractSocket::IPv6Protocol)
+    {
+        Q_IPV6ADDR addr = sender.toIPv6Address();
+        for(int i = 0; i < 16; i++)
+            record.sender[i] = addr[i];
+    }
+}
+
+QList<Connection::DatagramInfo> Connection::UDP_takeDatagramInfo()
+{
+    QList<DatagramInfo> result;
+    result.reserve(m_datagramNum);
+    for(int i = 0; i < m_datagramNum; i++)
+    {
+        const DatagramRecord& record = m_datagramRing[(m_datagramHead + i) % m_maxDatagramInfoNum];
+        DatagramInfo info;
+        info.pos = record.pos;
+        info.size = record.size;
+        if(record.protocol == QAbstractSocket::IPv4Protocol)
+            info.sender = QHostAddress(qFromBigEndian<quint32>(record.sender));
+        else if(record.protocol == QAbstractSocket::IPv6Protocol)
+            info.sender = QHostAddress(record.sender);
+        info.senderPort = record.senderPort;
+        info.timestamp = record.timestamp;
+        result.append(info);
+    }
+    m_datagramHead = 0;
+    m_datagramNum = 0;
+    return result;
+}
+
+#ifdef Q_OS_LINUX
+void Connection::UDP_receiveBatch(QByteArray& data)
+{
+    int fd = m_UDPSocket->socketDescriptor();
+    if(m_UDPBatch == nullptr)
+    {
+        m_UDPBatch = new UDPBatch;
+        m_UDPBatch->slab.resize(UDPBatch::num * UDPBatch::slotSize);
+    }
+    UDPBatch* batch = m_UDPBatch;
+    char* slab = batch->slab.data();
+    if(batch->fd != fd)
+    {
+        // the timestamps are available from the next datagram
+        int enabled = 1;
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enabled, sizeof(enabled));
+        batch->fd = fd;
+    }
+
+    int receivedNum;
+    do
+    {
+        for(int i = 0; i < UDPBatch::num; i++)
+        {
+            batch->iovecs[i].iov_base = slab + i * UDPBatch::slotSize;
+            batch->iovecs[i].iov_len = UDPBatch::slotSize;
+            msghdr& hdr = batch->msgs[i].msg_hdr;
+            hdr.msg_name = &batch->addrs[i];
+            hdr.msg_namelen = sizeof(sockaddr_storage);
+            hdr.msg_iov = &batch->iovecs[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = batch->controls[i];
+            hdr.msg_controllen = sizeof(batch->controls[i]);
+            hdr.msg_flags = 0;
+        }
+        receivedNum = recvmmsg(fd, batch->msgs, UDPBatch::num, MSG_DONTWAIT, nullptr);
+        for(int i = 0; i < receivedNum; i++)
+        {
+            msghdr& hdr = batch->msgs[i].msg_hdr;
+            qint32 len = batch->msgs[i].msg_len;
+            qint64 timestamp = 0;
+            for(cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+            {
+                if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+                {
+                    timespec ts;
+                    memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                    timestamp = ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+                }
+            }
+            // the address is copied raw, QHostAddress is only created when the info is taken
+            DatagramRecord& record = UDP_addDatagramInfo(len, timestamp);
+            if(batch->addrs[i].ss_family == AF_INET)
+            {
+                const sockaddr_in* addr = reinterpret_cast<sockaddr_in*>(&batch->addrs[i]);
+                record.protocol = QAbstractSocket::IPv4Protocol;
+                record.senderPort = ntohs(addr->sin_port);
+                memcpy(record.sender, &addr->sin_addr, 4);
+            }
+            else if(batch->addrs[i].ss_family == AF_INET6)
+            {
+                const sockaddr_in6* addr = reinterpret_cast<sockaddr_in6*>(&batch->addrs[i]);
+                record.protocol = QAbstractSocket::IPv6Protocol;
+                record.senderPort = ntohs(addr->sin6_port);
+                memcpy(record.sender, &addr->sin6_addr, 16);
+            }
+            data.append(slab + i * UDPBatch::slotSize, len);
+        }
+    }
+    while(receivedNum == UDPBatch::num);
+
+    // QUdpSocket won't emit readyRead() again until a datagram is read through it
+    // the read fails with TemporaryError if nothing is left, so the signals are blocked
+    QHostAddress sender;
+    quint16 port = 0;
+    m_UDPSocket->blockSignals(true);
+    qint64 len = m_UDPSocket->readDatagram(slab, UDPBatch::slotSize, &sender, &port);
+    m_UDPSocket->blockSignals(false);
+    if(len >= 0)
+    {
+        UDP_setDatagramSender(UDP_addDatagramInfo(len, 0), sender, port);
+        data.append(slab, len);
+    }
+}
+#endif
+
+
+void Connection::onDataArrived(const QByteArray& data)
+{
+    if(m_SP_RTTPending && m_type == SerialPort)
+    {
+        qint64 nsecs = m_SP_RTTTimer.nsecsElapsed();
+        RTTStats& stats = m_SP_RTTStats[m_SP_lowLatency];
+        stats.last = nsecs;
+        stats.min = stats.count ? qMin(stats.min, nsecs) : nsecs;
+        stats.max = qMax(stats.max, nsecs);
+        stats.sum += nsecs;
+        stats.count++;
+        m_SP_RTTPending = false;
+        emit SP_RTTMeasured(nsecs);
     }
+    // for forwarding, the data is not copied and readAll() is bypassed
+    emit dataArrived(data);
+    if(!m_RxBuffered)
+        return;
+    m_buf += data;
     emit readyRead();
 }
 
+void Connection::setRxBuffered(bool buffered)
+{
+    m_RxBuffered = buffered;
+}
+
+void Connection::setRxPaused(bool paused)
+{
+    if(paused == m_RxPaused)
+        return;
+    m_RxPaused = paused;
+    qint64 limit = paused ? m_pausedReadBufferSize : 0;
+    if(m_type == SerialPort)
+        setReadBufferLimit(m_serialPort, limit);
+    else if(m_type == TCP_Client)
+        setReadBufferLimit(m_TCPSocket, limit);
+    else if(m_type == Unix_Client)
+        setReadBufferLimit(m_localSocket, limit);
+    for(QTcpSocket* socket : qAsConst(m_TCPConnectedClients))
+        setReadBufferLimit(socket, limit);
+    for(QLocalSocket* socket : qAsConst(m_localConnectedClients))
+        setReadBufferLimit(socket, limit);
+    if(paused)
+        return;
+    // readyRead() is not emitted again for the data which is buffered already
+    QMetaObject::invokeMethod(this, [ = ]()
+    {
+        if(m_RxPaused || !isConnected())
+            return;
+        if(m_type == BT_Server || m_type == TCP_Server || m_type == Unix_Server)
+        {
+            const QList<QObject*> clients = m_clientIds.keys();
+            for(QObject* client : clients)
+            {
+                QIODevice* device = qobject_cast<QIODevice*>(client);
+                if(device != nullptr && device->bytesAvailable() > 0)
+                    receive(device);
+            }
+        }
+        else
+            receive(nullptr);
+    }, Qt::QueuedConnection);
+}
+
+bool Connection::isRxPaused()
+{
+    return m_RxPaused;
+}
+
+// BT sockets, UDP and others are not limited, they are just not read while paused
+void Connection::setReadBufferLimit(QIODevice* device, qint64 size)
+{
+    QAbstractSocket* socket = qobject_cast<QAbstractSocket*>(device);
+    QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(device);
+    QSerialPort* serialPort = qobject_cast<QSerialPort*>(device);
+    if(socket != nullptr)
+        socket->setReadBufferSize(size);
+    else if(localSocket != nullptr)
+        localSocket->setReadBufferSize(size);
+    else if(serialPort != nullptr)
+        serialPort->setReadBufferSize(size);
+}
+
 void Connection::onErrorOccurred()
 {
     qDebug() << "Connection::onErrorOccurred()";
@@ -688,6 +1253,22 @@ void Connection::onErrorOccurred()
             close(true); // this will emit disconnected()
         }
     }
+    else if(m_type == Unix_Client)
+    {
+        QLocalSocket::LocalSocketError error;
+        error = m_localSocket->error();
+        qDebug() << "Local Socket Error:" << error << m_localSocket->errorString();
+        qDebug() << "State:" << m_localSocket->state();
+
+        if(error == QLocalSocket::OperationError || error == QLocalSocket::UnsupportedSocketOperationError)
+            ;
+        else
+        {
+            if(m_state == Connecting)
+                emit connectFailed(m_localSocket->errorString());
+            close(true); // this will emit disconnected()
+        }
+    }
     // untested yet
     // for server, the m_state need to be changed there
     if(m_type == BT_Server)
@@ -731,61 +1312,234 @@ QByteArray Connection::readAll()
 }
 
 qint64 Connection::write(const char *data, qint64 len)
+{
+    // the RTT starts when the data is accepted, so the coalescing delay is included
+    bool RTTStarted = false;
+    if(m_type == SerialPort && len > 0 && !m_SP_RTTPending)
+    {
+        m_SP_RTTTimer.start();
+        m_SP_RTTPending = true;
+        RTTStarted = true;
+    }
+    qint64 result = len;
+    // small writes of stream devices are coalesced then sent together
+    if(m_TxCoalesceMsec > 0 && isConnected() && ((m_type == SerialPort && !m_SP_lowLatency) || m_type == BT_Client || m_type == TCP_Client))
+    {
+        if(len >= m_TxFlushSize)
+        {
+            // large buffers(e.g. the mapped file slices) are written from the caller's buffer without copying
+            flushTxQueue();
+            result = writeDirect(data, len);
+        }
+        else
+        {
+            m_TxQueue.append(QByteArray(data, len));
+            m_TxQueueSize += len;
+            if(m_TxQueueSize >= m_TxFlushSize)
+                flushTxQueue();
+            else if(!m_TxFlushTimer->isActive())
+                m_TxFlushTimer->start(m_TxCoalesceMsec);
+        }
+    }
+    else
+        result = writeDirect(data, len);
+    if(RTTStarted && result <= 0)
+        m_SP_RTTPending = false;
+    return result;
+}
+
+qint64 Connection::writeDirect(const char *data, qint64 len)
 {
     if(m_type == SerialPort)
     {
-        return m_serialPort->write(data, len);
+        qint64 result = m_serialPort->write(data, len);
+        // QSerialPort writes in the next event loop, flush() writes now
+        if(m_SP_lowLatency)
+            m_serialPort->flush();
+        return result;
     }
     else if(m_type == BT_Client)
     {
         return m_BTSocket->write(data, len);
     }
-    else if(m_type == BT_Server)
+    else if(isUnixDatagram())
     {
-        quint64 maxLen = 0, currLen;
-        // write to all connected clients
-        for(auto it = m_BTTxClients.cbegin(); it != m_BTTxClients.cend(); ++it)
-        {
-            currLen = (*it)->write(data, len);
-            if(currLen > maxLen)
-                maxLen = currLen;
-        }
-        return maxLen;
+        return m_unixDatagram->write(data, len);
+    }
+    else if(m_type == BT_Server || m_type == TCP_Server || m_type == Unix_Server)
+    {
+        return Server_broadcast(data, len);
     }
     else if(m_type == BLE_Central)
     {
+        // the write request might be queued, so the data is copied there
         if(m_BLERxTxMode == BLE_2S2C)
-            m_BLETxService->writeCharacteristic(m_BLETxCharacteristic, QByteArray::fromRawData(data, len));
+            m_BLETxService->writeCharacteristic(m_BLETxCharacteristic, QByteArray(data, len));
         else
-            m_BLERxTxService->writeCharacteristic(m_BLETxCharacteristic, QByteArray::fromRawData(data, len));
+            m_BLERxTxService->writeCharacteristic(m_BLETxCharacteristic, QByteArray(data, len));
         return len; // no feedback
     }
     else if(m_type == TCP_Client)
     {
         return m_TCPSocket->write(data, len);
     }
-    else if(m_type == TCP_Server)
+    else if(m_type == UDP)
+    {
+        return m_UDPSocket->writeDatagram(data, len, QHostAddress(m_currNetArgument.remoteName), m_currNetArgument.remotePort);
+    }
+    else if(m_type == PTY)
+    {
+        return m_PTY->write(data, len);
+    }
+    else if(m_type == Unix_Client)
+    {
+        return m_localSocket->write(data, len);
+    }
+    else if(m_type == Fifo)
     {
-        quint64 maxLen = 0, currLen;
-        // write to all connected clients
-        for(auto it = m_TCPTxClients.cbegin(); it != m_TCPTxClients.cend(); ++it)
+        return m_fifo->write(data, len);
+    }
+    else if(m_type == Generator)
+    {
+        return m_generator->write(data, len); // discarded
+    }
+    return 0;
+}
+
+qint64 Connection::write(const QByteArray & data)
+{
+    return write(data.constData(), data.size());
+}
+
+void Connection::setTxCoalescing(int msec)
+{
+    m_TxCoalesceMsec = msec;
+    if(msec <= 0)
+        flushTxQueue();
+}
+
+qint64 Connection::TxQueueSize()
+{
+    return m_TxQueueSize;
+}
+
+void Connection::flushTxQueue()
+{
+    m_TxFlushTimer->stop();
+    if(m_TxQueue.isEmpty())
+        return;
+    int index = 0;
+    qint64 offset = 0;
+#ifdef Q_OS_LINUX
+    // submit the queue with one writev() if nothing is left in the buffer of Qt, or the order is broken
+    int fd = -1;
+    if(m_type == SerialPort && m_serialPort->bytesToWrite() == 0)
+        fd = m_serialPort->handle();
+    else if(m_type == TCP_Client && m_TCPSocket->bytesToWrite() == 0)
+        fd = m_TCPSocket->socketDescriptor();
+    if(fd >= 0)
+    {
+        const int maxIovNum = 64;
+        iovec iov[maxIovNum];
+        qint64 writtenNum = 0;
+        while(index < m_TxQueue.size())
+        {
+            int iovNum = 0;
+            qint64 batchSize = 0;
+            for(int i = index; i < m_TxQueue.size() && iovNum < maxIovNum; i++, iovNum++)
+            {
+                qint64 start = (i == index) ? offset : 0;
+                iov[iovNum].iov_base = const_cast<char*>(m_TxQueue[i].constData()) + start;
+                iov[iovNum].iov_len = m_TxQueue[i].size() - start;
+                batchSize += iov[iovNum].iov_len;
+            }
+            ssize_t result = ::writev(fd, iov, iovNum);
+            if(result <= 0)
+                break; // EAGAIN or error, let Qt handle the rest
+            writtenNum += result;
+            // skip the written chunks
+            qint64 rest = result;
+            while(rest > 0)
+            {
+                qint64 chunkRest = m_TxQueue[index].size() - offset;
+                if(rest >= chunkRest)
+                {
+                    rest -= chunkRest;
+                    index++;
+                    offset = 0;
+                }
+                else
+                {
+                    offset += rest;
+                    rest = 0;
+                }
+            }
+            if(result < batchSize)
+                break;
+        }
+        // Qt doesn't know the data written there, report it like QIODevice does
+        if(writtenNum > 0)
         {
-            currLen = (*it)->write(data, len);
-            if(currLen > maxLen)
-                maxLen = currLen;
+            QMetaObject::invokeMethod(this, [ = ]()
+            {
+                emit bytesWritten(writtenNum);
+            }, Qt::QueuedConnection);
         }
+    }
+#endif
+    // the rest is handed to Qt chunk by chunk, without joining them first
+    QList<QByteArray> queue;
+    queue.swap(m_TxQueue);
+    m_TxQueueSize = 0;
+    for(; index < queue.size(); index++)
+    {
+        writeDirect(queue[index].constData() + offset, queue[index].size() - offset);
+        offset = 0;
+    }
+}
+
+qint64 Connection::bytesToWrite()
+{
+    if(m_type == SerialPort)
+    {
+        return m_serialPort->bytesToWrite() + m_TxQueueSize;
+    }
+    else if(m_type == BT_Client)
+    {
+        return m_BTSocket->bytesToWrite() + m_TxQueueSize;
+    }
+    else if(m_type == TCP_Client)
+    {
+        return m_TCPSocket->bytesToWrite() + m_TxQueueSize;
+    }
+    else if(m_type == BT_Server || m_type == TCP_Server || m_type == Unix_Server)
+    {
+        // the slowest client, including the queued data which is not fed to it
+        qint64 maxLen = 0;
+        for(auto it = m_broadcastCursors.cbegin(); it != m_broadcastCursors.cend(); ++it)
+            maxLen = qMax(maxLen, m_broadcastEnd - it->pos + it.key()->bytesToWrite());
         return maxLen;
     }
-    else if(m_type == UDP)
+    else if(m_type == PTY)
     {
-        return m_UDPSocket->writeDatagram(data, len, QHostAddress(m_currNetArgument.remoteName), m_currNetArgument.remotePort);
+        return m_PTY->bytesToWrite();
+    }
+    else if(m_type == Unix_Client && !m_currLocalArgument.datagram)
+    {
+        return m_localSocket->bytesToWrite();
     }
+    else if(m_type == Fifo)
+    {
+        return m_fifo->bytesToWrite();
+    }
+    // BLE, UDP, Unix datagram socket and Generator are not buffered
     return 0;
 }
 
-qint64 Connection::write(const QByteArray & data)
+bool Connection::hasWriteFeedback()
 {
-    return write(data.constData(), data.size());
+    return m_type == SerialPort || m_type == BT_Client || m_type == BT_Server || m_type == TCP_Client || m_type == TCP_Server || m_type == PTY
+           || ((m_type == Unix_Client || m_type == Unix_Server) && !m_currLocalArgument.datagram) || m_type == Fifo;
 }
 
 void Connection::onConnected()
@@ -821,9 +1575,20 @@ void Connection::afterConnected()
     {
         m_lastNetArgument = m_currNetArgument;
         m_lastNetArgumentValid = true;
+        m_UDPRxPos = 0;
+        m_datagramHead = 0;
+        m_datagramNum = 0;
+#ifdef Q_OS_LINUX
+        if(m_UDPBatch != nullptr)
+            m_UDPBatch->fd = -1; // the descriptor might be reused by the new socket
+#endif
     }
-    if(m_pollTimerEnabled)
-        m_pollTimer->start();
+    else if(m_type == Unix_Client || m_type == Unix_Server || m_type == Fifo)
+    {
+        m_lastLocalArgument = m_currLocalArgument;
+        m_lastLocalArgumentValid = true;
+    }
+    SP_updateLineMonitor();
     emit connected();
 }
 
@@ -831,8 +1596,8 @@ void Connection::onDisconnected()
 {
     State oldState = m_state;
     qDebug() << "Connection::onDisconnected()";
-    m_pollTimer->stop();
     changeState(Unconnected);
+    SP_updateLineMonitor();
     if(oldState != Unconnected)
         emit disconnected();
 }
@@ -848,10 +1613,13 @@ void Connection::Server_onClientConnected()
 
         changeState(Connected);
         connect(socket, &QBluetoothSocket::readyRead, this, &Connection::onReadyRead);
+        connect(socket, &QBluetoothSocket::bytesWritten, this, &Connection::Server_onClientBytesWritten);
         connect(socket, &QBluetoothSocket::disconnected, this, &Connection::Server_onClientDisconnected);
         connect(socket, QOverload<QBluetoothSocket::SocketError>::of(&QBluetoothSocket::error), this, &Connection::Server_onClientErrorOccurred);
         m_BTConnectedClients.append(socket);
         m_BTTxClients.append(socket);
+        Server_setBroadcastEnabled(socket, true);
+        Server_addClientStream(socket);
         emit BT_clientConnected();
     }
     else if(m_type == TCP_Server)
@@ -862,6 +1630,7 @@ void Connection::Server_onClientConnected()
 
         changeState(Connected);
         connect(socket, &QTcpSocket::readyRead, this, &Connection::onReadyRead);
+        connect(socket, &QTcpSocket::bytesWritten, this, &Connection::Server_onClientBytesWritten);
         connect(socket, &QTcpSocket::disconnected, this, &Connection::Server_onClientDisconnected);
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
         connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, &Connection::onErrorOccurred);
@@ -870,8 +1639,30 @@ void Connection::Server_onClientConnected()
 #endif
         m_TCPConnectedClients.append(socket);
         m_TCPTxClients.append(socket);
+        Server_setBroadcastEnabled(socket, true);
+        Server_addClientStream(socket);
         emit TCP_clientConnected();
     }
+    else if(m_type == Unix_Server)
+    {
+        QLocalSocket* socket = m_localServer->nextPendingConnection();
+        if(!socket)
+            return;
+
+        changeState(Connected);
+        connect(socket, &QLocalSocket::readyRead, this, &Connection::onReadyRead);
+        connect(socket, &QLocalSocket::bytesWritten, this, &Connection::Server_onClientBytesWritten);
+        connect(socket, &QLocalSocket::disconnected, this, &Connection::Server_onClientDisconnected);
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
+        connect(socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error), this, &Connection::Server_onClientErrorOccurred);
+#else
+        connect(socket, &QLocalSocket::errorOccurred, this, &Connection::Server_onClientErrorOccurred);
+#endif
+        m_localConnectedClients.append(socket);
+        Server_setBroadcastEnabled(socket, true);
+        Server_addClientStream(socket);
+        emit Unix_clientConnected();
+    }
 }
 
 // this will be called by cliendDisconnected() and clientErrorOccurred()
@@ -888,6 +1679,8 @@ void Connection::Server_onClientDisconnectedHandler(QObject * clientObj)
 
         firstCall = m_BTConnectedClients.removeOne(socket);
         m_BTTxClients.removeOne(socket);
+        Server_setBroadcastEnabled(socket, false);
+        Server_removeClientStream(socket);
         if(m_BTConnectedClients.empty())
         {
             if(m_BTServer->isListening())
@@ -907,6 +1700,8 @@ void Connection::Server_onClientDisconnectedHandler(QObject * clientObj)
 
         firstCall = m_TCPConnectedClients.removeOne(socket);
         m_TCPTxClients.removeOne(socket);
+        Server_setBroadcastEnabled(socket, false);
+        Server_removeClientStream(socket);
         if(m_TCPConnectedClients.empty())
         {
             if(m_TCPServer->isListening())
@@ -918,6 +1713,26 @@ void Connection::Server_onClientDisconnectedHandler(QObject * clientObj)
         if(firstCall)
             emit TCP_clientDisconnected();
     }
+    else if(m_type == Unix_Server)
+    {
+        QLocalSocket *socket = qobject_cast<QLocalSocket *>(clientObj);
+        if(!socket)
+            return;
+
+        firstCall = m_localConnectedClients.removeOne(socket);
+        Server_setBroadcastEnabled(socket, false);
+        Server_removeClientStream(socket);
+        if(m_localConnectedClients.empty())
+        {
+            if(m_localServer->isListening())
+                changeState(Bound);
+            else
+                changeState(Unconnected);
+        }
+        socket->deleteLater();
+        if(firstCall)
+            emit Unix_clientDisconnected();
+    }
 }
 
 void Connection::Server_onClientDisconnected()
@@ -964,6 +1779,21 @@ void Connection::Server_onClientErrorOccurred()
             Server_onClientDisconnectedHandler(sender());
         }
     }
+    else if(m_type == Unix_Server)
+    {
+        QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+        QLocalSocket::LocalSocketError socketError;
+        socketError = socket->error();
+        qDebug() << "Local Socket Error:" << socketError << socket->errorString();
+
+        if(socketError == QLocalSocket::OperationError || socketError == QLocalSocket::UnsupportedSocketOperationError)
+            ;
+        else
+        {
+            socket->close();
+            Server_onClientDisconnectedHandler(sender());
+        }
+    }
 }
 
 void Connection::onPollingTimeout()
@@ -978,6 +1808,75 @@ void Connection::onPollingTimeout()
     }
 }
 
+void Connection::SP_onLineEdgesAvailable()
+{
+    QVector<ModemLineEdge> edges = m_SP_lineWatcher->takeEdges();
+    if(edges.isEmpty() || !m_SP_lineWatching)
+        return;
+    QSerialPort::PinoutSignals newSignal = edges.last().signal;
+    if(newSignal != m_SP_lastSignals)
+        emit SP_signalsChanged(newSignal);
+    m_SP_lastSignals = newSignal;
+    emit SP_lineEdgesArrived(edges);
+}
+
+void Connection::SP_onLineWatcherStopped()
+{
+    if(!m_SP_lineWatching)
+        return;
+    // the port stopped answering TIOCMGET, fall back to polling
+    m_SP_lineWatcher->stop();
+    m_SP_lineWatching = false;
+    if(m_pollTimerEnabled && isConnected() && m_type == SerialPort)
+        m_pollTimer->start();
+}
+
+bool Connection::SP_setLowLatency(bool enabled)
+{
+#ifdef Q_OS_LINUX
+    int fd = m_serialPort->handle();
+    // ASYNC_LOW_LATENCY makes the driver push the received data to the tty immediately
+    // for FTDI chips, it also sets the latency timer to 1ms
+    serial_struct serial;
+    bool result = (ioctl(fd, TIOCGSERIAL, &serial) == 0);
+    if(result)
+    {
+        if(enabled)
+        {
+            m_SP_oldSerialFlags = serial.flags;
+            serial.flags |= ASYNC_LOW_LATENCY;
+        }
+        else
+            serial.flags = (serial.flags & ~ASYNC_LOW_LATENCY) | (m_SP_oldSerialFlags & ASYNC_LOW_LATENCY);
+        result = (ioctl(fd, TIOCSSERIAL, &serial) == 0);
+    }
+    // the RTT stats are filed under the low latency mode only if the driver accepts it
+    if(!result && enabled)
+        qDebug() << "Connection::SP_setLowLatency(): ASYNC_LOW_LATENCY is not supported," << strerror(errno);
+    return result;
+#else
+    Q_UNUSED(enabled)
+    return false;
+#endif
+}
+
+bool Connection::SP_isLowLatency()
+{
+    return m_SP_lowLatency;
+}
+
+Connection::RTTStats Connection::SP_RTTStats(bool lowLatency)
+{
+    return m_SP_RTTStats[lowLatency];
+}
+
+void Connection::SP_resetRTTStats()
+{
+    m_SP_RTTStats[0] = RTTStats();
+    m_SP_RTTStats[1] = RTTStats();
+    m_SP_RTTPending = false;
+}
+
 QSerialPort::PinoutSignals Connection::SP_pinoutSignals()
 {
     return m_serialPort->pinoutSignals();
@@ -1110,10 +2009,26 @@ bool Connection::BTServer_setClientMode(QBluetoothSocket * clientSocket, bool Rx
         m_BTTxClients.append(clientSocket);
     else if(!TxEnabled)
         m_BTTxClients.removeOne(clientSocket);
+    Server_setBroadcastEnabled(clientSocket, TxEnabled);
 
     return true;
 }
 
+QString Connection::PTY_slaveName()
+{
+    return m_PTY->slaveName();
+}
+
+void Connection::PTY_setLinkPath(const QString& path)
+{
+    m_PTYLinkPath = path;
+}
+
+QString Connection::PTY_linkPath()
+{
+    return m_PTYLinkPath;
+}
+
 void Connection::UDP_setRemote(const QString & addr, quint16 port)
 {
     if(m_type != UDP)
@@ -1132,6 +2047,26 @@ int Connection::TCPServer_clientCount()
     return m_TCPConnectedClients.count();
 }
 
+qint64 Connection::Generator_producedBytes()
+{
+    return m_generator->producedBytes();
+}
+
+double Connection::Generator_achievedRate()
+{
+    return m_generator->achievedRate();
+}
+
+QList<QLocalSocket *> Connection::UnixServer_clientList() const
+{
+    return m_localConnectedClients;
+}
+
+int Connection::UnixServer_clientCount()
+{
+    return m_localConnectedClients.count();
+}
+
 bool Connection::TCPServer_setClientMode(QTcpSocket * clientSocket, bool RxEnabled, bool TxEnabled)
 {
     if(!m_TCPConnectedClients.contains(clientSocket))
@@ -1151,10 +2086,255 @@ bool Connection::TCPServer_setClientMode(QTcpSocket * clientSocket, bool RxEnabl
         m_TCPTxClients.append(clientSocket);
     else if(!TxEnabled)
         m_TCPTxClients.removeOne(clientSocket);
+    Server_setBroadcastEnabled(clientSocket, TxEnabled);
 
     return true;
 }
 
+void Connection::Server_addClientStream(QIODevice* socket)
+{
+    int id = m_nextClientId++;
+    m_clientIds[socket] = id;
+    m_clientStreams[id].socket = socket;
+    if(m_RxPaused)
+        setReadBufferLimit(socket, m_pausedReadBufferSize);
+}
+
+void Connection::Server_removeClientStream(QObject* socket)
+{
+    auto idIt = m_clientIds.find(socket);
+    if(idIt == m_clientIds.end())
+        return;
+    auto streamIt = m_clientStreams.find(*idIt);
+    m_clientIds.erase(idIt);
+    // Server_readAll() will remove it
+    if(!streamIt->buf.isEmpty())
+        streamIt->socket = nullptr;
+    else
+        m_clientStreams.erase(streamIt);
+}
+
+QString Connection::Server_clientName(QIODevice* socket) const
+{
+    if(m_type == BT_Server)
+    {
+        QBluetoothSocket* BTSocket = qobject_cast<QBluetoothSocket*>(socket);
+        if(!BTSocket->peerName().isEmpty())
+            return BTSocket->peerName();
+        return BTSocket->peerAddress().toString();
+    }
+    else if(m_type == Unix_Server)
+    {
+        QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket);
+#ifdef Q_OS_LINUX
+        // the peer of a Unix domain socket has no address, use its pid
+        ucred cred;
+        socklen_t len = sizeof(cred);
+        if(getsockopt(localSocket->socketDescriptor(), SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0)
+            return "pid " + QString::number(cred.pid);
+#endif
+        return "fd " + QString::number(localSocket->socketDescriptor());
+    }
+    QTcpSocket* TCPSocket = qobject_cast<QTcpSocket*>(socket);
+    return TCPSocket->peerAddress().toString() + ":" + QString::number(TCPSocket->peerPort());
+}
+
+QMap<int, QString> Connection::Server_clientMap() const
+{
+    QMap<int, QString> result;
+    for(auto it = m_clientStreams.cbegin(); it != m_clientStreams.cend(); ++it)
+    {
+        if(it->socket != nullptr)
+            result[it.key()] = Server_clientName(it->socket);
+    }
+    return result;
+}
+
+qint64 Connection::Server_clientRxCount(int clientId) const
+{
+    auto it = m_clientStreams.constFind(clientId);
+    if(it == m_clientStreams.cend())
+        return 0;
+    return it->RxCount;
+}
+
+QByteArray Connection::Server_readAll(int clientId)
+{
+    auto it = m_clientStreams.find(clientId);
+    if(it == m_clientStreams.end())
+        return QByteArray();
+    QByteArray result(it->buf);
+    it->buf.clear();
+    if(it->socket == nullptr)
+        m_clientStreams.erase(it);
+    return result;
+}
+
+void Connection::Server_setRxSubscription(const QList<int>& clientIdList)
+{
+    for(auto it = m_clientStreams.begin(); it != m_clientStreams.end();)
+    {
+        it->subscribed = clientIdList.contains(it.key());
+        if(!it->subscribed)
+            it->buf.clear();
+        if(it->buf.isEmpty() && it->socket == nullptr)
+            it = m_clientStreams.erase(it);
+        else
+            ++it;
+    }
+}
+
+void Connection::Server_setLagLimit(qint64 bytes, LagPolicy policy)
+{
+    m_lagLimit = bytes;
+    m_lagPolicy = policy;
+}
+
+void Connection::Server_setBroadcastEnabled(QIODevice* socket, bool enabled)
+{
+    if(enabled && !m_broadcastCursors.contains(socket))
+        m_broadcastCursors[socket] = Server_broadcastEndCursor(); // only the new data is sent
+    else if(!enabled && m_broadcastCursors.remove(socket) > 0)
+        Server_trimBroadcast();
+}
+
+qint64 Connection::Server_broadcast(const char* data, qint64 len)
+{
+    if(m_broadcastCursors.isEmpty() || len <= 0)
+        return 0;
+    if(m_lagPolicy == Lag_Block)
+    {
+        qint64 maxLag = 0;
+        for(auto it = m_broadcastCursors.cbegin(); it != m_broadcastCursors.cend(); ++it)
+            maxLag = qMax(maxLag, m_broadcastEnd - it->pos);
+        if(maxLag > 0 && maxLag + len > m_lagLimit)
+            return 0;
+    }
+
+    // the only copy, shared by all clients
+    m_broadcastQueue.append(QByteArray(data, len));
+    m_broadcastEnd += len;
+
+    // closing a client modifies m_broadcastCursors, so handle the lagging clients later
+    QList<QIODevice*> laggingClients;
+    const QList<QIODevice*> clients = m_broadcastCursors.keys();
+    for(QIODevice* client : clients)
+    {
+        Server_feedClient(client);
+        if(m_broadcastEnd - m_broadcastCursors[client].pos > m_lagLimit)
+            laggingClients.append(client);
+    }
+    for(QIODevice* client : qAsConst(laggingClients))
+    {
+        if(m_lagPolicy == Lag_Drop)
+            m_broadcastCursors[client] = Server_broadcastEndCursor();
+        else if(m_lagPolicy == Lag_Disconnect)
+        {
+            qDebug() << "Connection::Server_broadcast(): disconnect lagging client" << m_broadcastEnd - m_broadcastCursors[client].pos;
+            QBluetoothSocket* BTSocket = qobject_cast<QBluetoothSocket*>(client);
+            if(BTSocket != nullptr)
+                BTSocket->disconnectFromService();
+            client->close();
+            Server_onClientDisconnectedHandler(client);
+        }
+    }
+    Server_trimBroadcast();
+    return len;
+}
+
+#ifdef Q_OS_LINUX
+// the descriptor of a server client, -1 if unknown
+static qintptr clientDescriptor(QIODevice* socket)
+{
+    QAbstractSocket* netSocket = qobject_cast<QAbstractSocket*>(socket);
+    if(netSocket != nullptr)
+        return netSocket->socketDescriptor();
+    QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(socket);
+    if(localSocket != nullptr)
+        return localSocket->socketDescriptor();
+    QBluetoothSocket* BTSocket = qobject_cast<QBluetoothSocket*>(socket);
+    if(BTSocket != nullptr)
+        return BTSocket->socketDescriptor();
+    return -1;
+}
+#endif
+
+void Connection::Server_feedClient(QIODevice* socket)
+{
+    auto cursorIt = m_broadcastCursors.find(socket);
+    if(cursorIt == m_broadcastCursors.end())
+        return;
+    // resume from where the last call stopped
+    BroadcastCursor& cursor = *cursorIt;
+    qint64 directNum = 0;
+    while(cursor.pos < m_broadcastEnd)
+    {
+        qint64 space = m_socketFeedSize - socket->bytesToWrite();
+        if(space <= 0)
+            break;
+        const QByteArray& chunk = m_broadcastQueue.at(cursor.chunk - m_broadcastFirstChunk);
+        const char* data = chunk.constData() + cursor.offset;
+        qint64 rest = chunk.size() - cursor.offset;
+        qint64 len = 0;
+#ifdef Q_OS_LINUX
+        // nothing is buffered by Qt, the kernel takes the data from the shared chunk directly
+        // only the part refused by a full kernel buffer is copied into the socket, then bytesWritten() resumes feeding
+        qintptr fd = (socket->bytesToWrite() == 0) ? clientDescriptor(socket) : -1;
+        if(fd >= 0)
+        {
+            len = ::send(fd, data, rest, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if(len > 0)
+                directNum += len;
+        }
+#endif
+        if(len <= 0)
+            len = socket->write(data, qMin(rest, space));
+        if(len <= 0)
+            break;
+        cursor.pos += len;
+        cursor.offset += len;
+        if(cursor.offset == chunk.size())
+        {
+            cursor.chunk++;
+            cursor.offset = 0;
+        }
+    }
+    // Qt doesn't know the data sent there, report it like QIODevice does
+    if(directNum > 0)
+    {
+        QMetaObject::invokeMethod(this, [ = ]()
+        {
+            emit bytesWritten(directNum);
+        }, Qt::QueuedConnection);
+    }
+}
+
+Connection::BroadcastCursor Connection::Server_broadcastEndCursor() const
+{
+    return {m_broadcastEnd, m_broadcastFirstChunk + m_broadcastQueue.size(), 0};
+}
+
+// release the data which is sent to all clients
+void Connection::Server_trimBroadcast()
+{
+    qint64 minCursor = m_broadcastEnd;
+    for(auto it = m_broadcastCursors.cbegin(); it != m_broadcastCursors.cend(); ++it)
+        minCursor = qMin(minCursor, it->pos);
+    while(!m_broadcastQueue.isEmpty() && m_broadcastBegin + m_broadcastQueue.first().size() <= minCursor)
+    {
+        m_broadcastBegin += m_broadcastQueue.first().size();
+        m_broadcastFirstChunk++;
+        m_broadcastQueue.removeFirst();
+    }
+}
+
+void Connection::Server_onClientBytesWritten(qint64 bytes)
+{
+    Server_feedClient(qobject_cast<QIODevice*>(sender()));
+    Server_trimBroadcast();
+    emit bytesWritten(bytes);
+}
+
 void Connection::blackhole()
 {
     // discard received data
@@ -1299,8 +2479,7 @@ void Connection::BLEC_onServiceDetailDiscovered(QLowEnergyService::ServiceState
 void Connection::BLEC_onDataArrived(const QLowEnergyCharacteristic & characteristic, const QByteArray & newValue)
 {
     Q_UNUSED(characteristic)
-    m_buf += newValue;
-    emit readyRead();
+    onDataArrived(newValue);
 }
 
 const QMap<Connection::Type, QLatin1String> Connection::m_typeNameMap
@@ -1312,7 +2491,12 @@ const QMap<Connection::Type, QLatin1String> Connection::m_typeNameMap
     {Connection::BLE_Peripheral, QLatin1String(QT_TR_NOOP("BLE Peripheral"))},
     {Connection::TCP_Client, QLatin1String(QT_TR_NOOP("TCP Client"))},
     {Connection::TCP_Server, QLatin1String(QT_TR_NOOP("TCP Server"))},
-    {Connection::UDP, QLatin1String(QT_TR_NOOP("UDP"))}
+    {Connection::UDP, QLatin1String(QT_TR_NOOP("UDP"))},
+    {Connection::PTY, QLatin1String(QT_TR_NOOP("PTY"))},
+    {Connection::Unix_Client, QLatin1String(QT_TR_NOOP("Unix Socket Client"))},
+    {Connection::Unix_Server, QLatin1String(QT_TR_NOOP("Unix Socket Server"))},
+    {Connection::Fifo, QLatin1String(QT_TR_NOOP("FIFO"))},
+    {Connection::Generator, QLatin1String(QT_TR_NOOP("Generator"))}
 };
 
 bool Connection::NetworkArgument::operator==(const NetworkArgument &other) const
@@ -1323,3 +2507,11 @@ bool Connection::NetworkArgument::operator==(const NetworkArgument &other) const
            && remoteName == other.remoteName
            && remotePort == other.remotePort;
 }
+
+bool Connection::LocalArgument::operator==(const LocalArgument &other) const
+{
+    // alias doesn't matter
+    return path == other.path
+           && writePath == other.writePath
+           && datagram == other.datagram;
+}
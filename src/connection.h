@@ -13,6 +13,16 @@
 #include <QTcpServer>
 #include <QUdpSocket>
 #include <QDataStream>
+#include <QHash>
+#include <QElapsedTimer>
+
+#include "modemlinewatcher.h"
+#include "ptydevice.h"
+#include "fifodevice.h"
+#include "unixdatagramsocket.h"
+#include "datagenerator.h"
+#include <QLocalSocket>
+#include <QLocalServer>
 
 class Connection : public QObject
 {
@@ -27,7 +37,12 @@ public:
         BLE_Peripheral,
         TCP_Client,
         TCP_Server,
-        UDP
+        UDP,
+        PTY,
+        Unix_Client,
+        Unix_Server,
+        Fifo,
+        Generator
     };
     Q_ENUM(Type)
 
@@ -39,6 +54,15 @@ public:
         Bound,
     };
 
+    // for BT_Server and TCP_Server, what to do if a client falls too far behind the broadcast
+    enum LagPolicy
+    {
+        Lag_Drop = 0, // skip the data the client hasn't got
+        Lag_Disconnect,
+        Lag_Block, // refuse new data until the client catches up
+    };
+    Q_ENUM(LagPolicy)
+
     struct SerialPortArgument
     {
         QString name;
@@ -48,6 +72,14 @@ public:
         QSerialPort::Parity parity = QSerialPort::NoParity;
         QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
         QString id; // <name> or <vendorID>-<productID>
+        bool lowLatency = false; // Linux only, ASYNC_LOW_LATENCY and no write buffering
+    };
+
+    // round-trip time from a write to the next received data, in nanoseconds
+    struct RTTStats
+    {
+        qint64 count = 0;
+        qint64 last = 0, min = 0, max = 0, sum = 0;
     };
 
     struct BTArgument
@@ -73,7 +105,36 @@ public:
         bool operator==(const NetworkArgument& other) const;
     };
 
+    // for Unix_Client, Unix_Server and Fifo
+    struct LocalArgument
+    {
+        QString path; // the socket path, or the FIFO to read
+        QString writePath; // Fifo only, the FIFO to write
+        bool datagram = false; // Unix_Client and Unix_Server only
+        QString alias; // useless for connection
+        bool operator==(const LocalArgument& other) const;
+    };
+
+    // synthetic Rx data for benchmarking, see DataGenerator
+    struct GeneratorArgument
+    {
+        DataGenerator::Workload workload = DataGenerator::SineCSV;
+        qint64 rate = 92160; // bytes per second, 0 for as fast as possible, 921600 baud by default
+        QByteArray frame; // for FixedFrame
+    };
+
+    // for UDP, the data from readAll() is split into datagrams by this
+    struct DatagramInfo
+    {
+        qint64 pos; // position in the received data since connected
+        qint32 size;
+        QHostAddress sender;
+        quint16 senderPort;
+        qint64 timestamp; // kernel receive time in microseconds since epoch, 0 if not available
+    };
+
     explicit Connection(QObject *parent = nullptr);
+    ~Connection();
 
     // general
     Type type();
@@ -90,17 +151,34 @@ public:
     SerialPortArgument getSerialPortArgument();
     BTArgument getBTArgument();
     NetworkArgument getNetworkArgument(bool fillLocalAddress = true, bool fillLocalPort = true);
+    LocalArgument getLocalArgument();
+    GeneratorArgument getGeneratorArgument();
     static QStringList arg2StringList(const SerialPortArgument& arg);
     static QStringList arg2StringList(const BTArgument& arg);
     static QStringList arg2StringList(const NetworkArgument& arg);
+    static QStringList arg2StringList(const LocalArgument& arg);
+    static QStringList arg2StringList(const GeneratorArgument& arg);
     static SerialPortArgument stringList2SPArg(const QStringList& list);
     static NetworkArgument stringList2NetArg(const QStringList& list);
+    static LocalArgument stringList2LocalArg(const QStringList& list);
+    static GeneratorArgument stringList2GeneratorArg(const QStringList& list);
 
 
     // IO
     QByteArray readAll();
+    // if false, the received data is only emitted by dataArrived()
+    void setRxBuffered(bool buffered);
+    // stop reading from the device, the unread data stays in the driver so the flow control of TCP/serial port works
+    void setRxPaused(bool paused);
+    bool isRxPaused();
     qint64 write(const char *data, qint64 len);
     qint64 write(const QByteArray &data);
+    qint64 bytesToWrite(); // including the coalescing queue
+    // for SerialPort, BT_Client and TCP_Client, coalesce the writes within the latency budget, 0 to disable
+    void setTxCoalescing(int msec);
+    qint64 TxQueueSize();
+    // true if bytesToWrite() and bytesWritten() reflect the real write progress
+    bool hasWriteFeedback();
 
     // SerialPort
     QSerialPort::PinoutSignals SP_pinoutSignals();
@@ -114,6 +192,10 @@ public:
     bool SP_setStopBits(QSerialPort::StopBits stopBits);
     bool SP_setParity(QSerialPort::Parity parity);
     bool SP_setFlowControl(QSerialPort::FlowControl flowControl);
+    bool SP_isLowLatency();
+    // kept for the normal mode and the low latency mode separately, to compare them
+    RTTStats SP_RTTStats(bool lowLatency);
+    void SP_resetRTTStats();
 
     // Bluetooth
     QString BT_remoteName();
@@ -124,9 +206,34 @@ public:
 
     // Network
     void UDP_setRemote(const QString& addr, quint16 port);
+    QList<DatagramInfo> UDP_takeDatagramInfo();
     QList<QTcpSocket*> TCPServer_clientList() const;
     int TCPServer_clientCount();
     bool TCPServer_setClientMode(QTcpSocket* clientSocket, bool RxEnabled = true, bool TxEnabled = true);
+
+    // PTY
+    // the slave path for other programs, valid after connected
+    QString PTY_slaveName();
+    // create a symlink to the slave on open, empty to disable
+    void PTY_setLinkPath(const QString& path);
+    QString PTY_linkPath();
+
+    // Unix domain socket
+    QList<QLocalSocket*> UnixServer_clientList() const;
+    int UnixServer_clientCount();
+
+    // Generator
+    // kept after disconnected, for the result of the last run
+    qint64 Generator_producedBytes();
+    double Generator_achievedRate();
+
+    // per-client Rx streams of BT_Server and TCP_Server
+    // readAll() returns the data of all clients, the subscribed clients are also buffered separately
+    QMap<int, QString> Server_clientMap() const;
+    qint64 Server_clientRxCount(int clientId) const;
+    QByteArray Server_readAll(int clientId);
+    void Server_setRxSubscription(const QList<int>& clientIdList);
+    void Server_setLagLimit(qint64 bytes, LagPolicy policy);
 public slots:
     // general
     void setPolling(bool enabled);
@@ -135,6 +242,8 @@ public slots:
     void setArgument(SerialPortArgument arg);
     void setArgument(BTArgument arg);
     void setArgument(NetworkArgument arg);
+    void setArgument(LocalArgument arg);
+    void setArgument(GeneratorArgument arg);
     void open(); // async
     bool reopen(); // async, return false if no argument is stored in the previous connection
     void close(bool forced = false); // async
@@ -156,12 +265,16 @@ private:
     QMetaObject::Connection m_lastOnErrorConn;
     QMetaObject::Connection m_lastOnConnectedConn;
     QMetaObject::Connection m_lastOnDisconnectedConn;
+    QMetaObject::Connection m_lastBytesWrittenConn;
 
     // establish connetion and reconnect
     bool m_lastSPArgumentValid = false, m_lastBTArgumentValid = false, m_lastNetArgumentValid = false;
     SerialPortArgument m_lastSPArgument, m_currSPArgument;
     BTArgument m_lastBTArgument, m_currBTArgument;
     NetworkArgument m_lastNetArgument, m_currNetArgument;
+    bool m_lastLocalArgumentValid = false;
+    LocalArgument m_lastLocalArgument, m_currLocalArgument;
+    GeneratorArgument m_currGeneratorArgument; // always valid
 
     QSerialPort* m_serialPort = nullptr;
     QBluetoothServer* m_BTServer = nullptr;
@@ -175,12 +288,21 @@ private:
     QTcpServer* m_TCPServer = nullptr;
     QTcpSocket* m_TCPSocket = nullptr;
     QUdpSocket* m_UDPSocket = nullptr;
+    PtyDevice* m_PTY = nullptr;
+    QString m_PTYLinkPath;
+    QLocalSocket* m_localSocket = nullptr;
+    QLocalServer* m_localServer = nullptr;
+    UnixDatagramSocket* m_unixDatagram = nullptr; // for both Unix_Client and Unix_Server
+    FifoDevice* m_fifo = nullptr;
+    DataGenerator* m_generator = nullptr;
+    bool isUnixDatagram();
 
     QList<QBluetoothSocket*> m_BTConnectedClients;
     QList<QBluetoothSocket*> m_BTTxClients;
     QList<QBluetoothUuid> m_BLEDiscoveredServices;
     QList<QTcpSocket*> m_TCPConnectedClients;
     QList<QTcpSocket*> m_TCPTxClients;
+    QList<QLocalSocket*> m_localConnectedClients;
     QBluetoothServiceInfo m_RfcommServiceInfo;
     BLE_RxTxMode m_BLERxTxMode;
 
@@ -191,8 +313,84 @@ private:
 
     //
     QSerialPort::PinoutSignals m_SP_lastSignals;
+    // replaces the polling if the port supports it
+    ModemLineWatcher* m_SP_lineWatcher = nullptr;
+    bool m_SP_lineWatching = false;
+    void SP_updateLineMonitor();
+    bool m_SP_lowLatency = false;
+    int m_SP_oldSerialFlags = 0;
+    bool SP_setLowLatency(bool enabled);
+    QElapsedTimer m_SP_RTTTimer;
+    bool m_SP_RTTPending = false;
+    RTTStats m_SP_RTTStats[2];
 
     QByteArray m_buf;
+    bool m_RxBuffered = true;
+    bool m_RxPaused = false;
+    // Qt stops reading from the device when its buffer is full
+    static const qint64 m_pausedReadBufferSize = 64 * 1024;
+    void setReadBufferLimit(QIODevice* device, qint64 size);
+    void receive(QIODevice* client);
+
+    // for coalescing the writes
+    QList<QByteArray> m_TxQueue;
+    qint64 m_TxQueueSize = 0;
+    QTimer* m_TxFlushTimer;
+    int m_TxCoalesceMsec = 0;
+    static const qint64 m_TxFlushSize = 16 * 1024; // flush immediately if the queue is large enough
+    qint64 writeDirect(const char *data, qint64 len);
+
+    // the latest datagram info, the old ones are overwritten if nobody takes them
+    // the records are kept raw in a ring allocated once, UDP_takeDatagramInfo() converts them
+    struct DatagramRecord
+    {
+        qint64 pos;
+        qint64 timestamp;
+        qint32 size;
+        quint16 senderPort;
+        QAbstractSocket::NetworkLayerProtocol protocol;
+        quint8 sender[16]; // network byte order, IPv4 uses the first 4 bytes
+    };
+    QVector<DatagramRecord> m_datagramRing;
+    int m_datagramHead = 0; // the oldest record
+    int m_datagramNum = 0;
+    qint64 m_UDPRxPos = 0;
+    static const int m_maxDatagramInfoNum = 16384;
+#ifdef Q_OS_LINUX
+    // read datagrams in batches with recvmmsg()
+    struct UDPBatch;
+    UDPBatch* m_UDPBatch = nullptr;
+    void UDP_receiveBatch(QByteArray& data);
+#endif
+
+    struct ClientStream
+    {
+        QIODevice* socket; // nullptr after the client is disconnected
+        QByteArray buf;
+        qint64 RxCount = 0;
+        bool subscribed = false;
+    };
+    // the ids are not reused, the stream is kept until the buffered data is read
+    QMap<int, ClientStream> m_clientStreams;
+    QHash<QObject*, int> m_clientIds;
+    int m_nextClientId = 0;
+
+    // for broadcasting, the data is queued once and each client has a cursor in the queue
+    // a client is fed only when its socket buffer is nearly empty
+    struct BroadcastCursor
+    {
+        qint64 pos; // position in the broadcast data
+        qint64 chunk; // sequence number of the chunk where pos is
+        qint64 offset; // offset of pos in that chunk
+    };
+    QList<QByteArray> m_broadcastQueue;
+    qint64 m_broadcastBegin = 0; // position of m_broadcastQueue.first()
+    qint64 m_broadcastFirstChunk = 0; // sequence number of m_broadcastQueue.first()
+    qint64 m_broadcastEnd = 0;
+    QHash<QIODevice*, BroadcastCursor> m_broadcastCursors;
+    qint64 m_lagLimit = 1024 * 1024;
+    LagPolicy m_lagPolicy = Lag_Drop;
+    static const qint64 m_socketFeedSize = 64 * 1024;
 
     static const QMap<Connection::Type, QLatin1String> m_typeNameMap;
 
@@ -201,9 +399,22 @@ private:
     void BTServer_updateServicePort();
     void changeState(State newState);
     void Server_onClientDisconnectedHandler(QObject *clientObj);
+    void Server_addClientStream(QIODevice* socket);
+    void Server_removeClientStream(QObject* socket);
+    QString Server_clientName(QIODevice* socket) const;
+    qint64 Server_broadcast(const char *data, qint64 len);
+    void Server_feedClient(QIODevice* socket);
+    BroadcastCursor Server_broadcastEndCursor() const;
+    void Server_trimBroadcast();
+    void Server_setBroadcastEnabled(QIODevice* socket, bool enabled);
     void afterConnected();
+    void onDataArrived(const QByteArray& data);
+    DatagramRecord& UDP_addDatagramInfo(qint32 size, qint64 timestamp);
+    void UDP_setDatagramSender(DatagramRecord& record, const QHostAddress& sender, quint16 senderPort);
 signals:
     void readyRead();
+    void dataArrived(const QByteArray& data);
+    void bytesWritten(qint64 bytes);
     void connected();
     void disconnected();
     void connectFailed(const QString& info);
@@ -211,12 +422,18 @@ signals:
     // the slot can accept newState only
     void stateChanged(State newState, State oldState);
     void SP_signalsChanged(QSerialPort::PinoutSignals signal);
+    // the changes reported by the line watcher, in time order, including the pulses shorter than a wakeup
+    void SP_lineEdgesArrived(const QVector<ModemLineEdge>& edges);
+    void SP_RTTMeasured(qint64 nsecs);
     // for BT_Server
     void BT_clientConnected();
     void BT_clientDisconnected();
     // for TCP_Server
     void TCP_clientConnected();
     void TCP_clientDisconnected();
+    // for Unix_Server
+    void Unix_clientConnected();
+    void Unix_clientDisconnected();
 private slots:
     void onReadyRead();
     void onErrorOccurred();
@@ -227,7 +444,11 @@ private slots:
     // Server_onClientDisconnected() might be called more than once
     void Server_onClientDisconnected();
     void Server_onClientErrorOccurred();
+    void Server_onClientBytesWritten(qint64 bytes);
     void onPollingTimeout();
+    void SP_onLineEdgesAvailable();
+    void SP_onLineWatcherStopped();
+    void flushTxQueue();
     void blackhole();
     // BLE
     void BLEC_onServiceDiscovered(const QBluetoothUuid& serviceUUID);
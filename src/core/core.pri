@@ -0,0 +1,16 @@
+# include this in a project to link the core library
+# the project should be built as a part of SerialTest.pro, so the library is built first
+QT += core serialport bluetooth network
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
+
+CORE_LIB_DIR = $$shadowed($$PWD)
+win32 {
+    CONFIG(debug, debug|release): CORE_LIB_DIR = $$CORE_LIB_DIR/debug
+    else: CORE_LIB_DIR = $$CORE_LIB_DIR/release
+}
+
+LIBS += -L$$CORE_LIB_DIR -lSerialTestCore
+win32-msvc*: PRE_TARGETDEPS += $$CORE_LIB_DIR/SerialTestCore.lib
+else: PRE_TARGETDEPS += $$CORE_LIB_DIR/libSerialTestCore.a
@@ -0,0 +1,59 @@
+# Connection, file transfer and data parsing, no widgets
+# headless tools and benchmarks can link this under QCoreApplication, see core.pri
+TEMPLATE = lib
+CONFIG += staticlib c++11
+TARGET = SerialTestCore
+
+QT = core serialport bluetooth network
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    ../asynccrc.cpp \
+    ../asyncfilewriter.cpp \
+    ../bridge.cpp \
+    ../chunkprotocol.cpp \
+    ../connection.cpp \
+    ../datagenerator.cpp \
+    ../fddevice.cpp \
+    ../fifodevice.cpp \
+    ../fileprotocol.cpp \
+    ../filexceiver.cpp \
+    ../headlesssession.cpp \
+    ../metricsexporter.cpp \
+    ../modemlinewatcher.cpp \
+    ../mysettings.cpp \
+    ../pipelinemetrics.cpp \
+    ../plotparser.cpp \
+    ../ptydevice.cpp \
+    ../tracer.cpp \
+    ../unixdatagramsocket.cpp \
+    ../util.cpp \
+    ../xymodem.cpp \
+    ../zmodem.cpp
+
+HEADERS += \
+    ../asynccrc.h \
+    ../asyncfilewriter.h \
+    ../bridge.h \
+    ../chunkprotocol.h \
+    ../connection.h \
+    ../datagenerator.h \
+    ../fddevice.h \
+    ../fifodevice.h \
+    ../fileprotocol.h \
+    ../filexceiver.h \
+    ../headlesssession.h \
+    ../metricsexporter.h \
+    ../modemlinewatcher.h \
+    ../mysettings.h \
+    ../pipelinemetrics.h \
+    ../plotparser.h \
+    ../ptydevice.h \
+    ../tracer.h \
+    ../unixdatagramsocket.h \
+    ../util.h \
+    ../xymodem.h \
+    ../zmodem.h
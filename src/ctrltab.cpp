@@ -3,6 +3,7 @@
 
 #include "controlitem.h"
 #include "util.h"
+#include "guiutil.h"
 
 #include <QDateTime>
 #ifndef Q_OS_ANDROID
@@ -172,7 +173,7 @@ void CtrlTab::on_ctrl_exportButton_clicked()
         ui->ctrl_itemArea->setVisible(false);
         ui->ctrl_dataEdit->setVisible(true);
         ui->ctrl_exportButton->setText(tr("Done"));
-        Util::showToast(tr("Copied to clipboard"));
+        GuiUtil::showToast(tr("Copied to clipboard"));
         ui->ctrl_clearButton->setEnabled(false);
         ui->ctrl_importButton->setEnabled(false);
         ui->ctrl_addCMDButton->setEnabled(false);
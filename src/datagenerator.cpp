@@ -0,0 +1,162 @@
+#include "datagenerator.h"
+
+#include <QRandomGenerator>
+#include <QtMath>
+#include <string.h>
+
+// limit the burst after the event loop is blocked
+static const qint64 maxChunkSize = 1048576;
+
+DataGenerator::DataGenerator(QObject *parent)
+    : QIODevice{parent}
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(1);
+    connect(m_timer, &QTimer::timeout, this, &DataGenerator::onTimeout);
+}
+
+bool DataGenerator::start(Workload workload, qint64 rate, const QByteArray& frame)
+{
+    if(isOpen())
+        return false;
+    m_workload = workload;
+    m_rate = qMax(rate, 0LL);
+    m_pattern.clear();
+    m_patternPos = 0;
+    if(workload == SineCSV)
+    {
+        // plot_performance.ino, Serial.print() keeps 2 decimals
+        const int len = 512;
+        double sinTable[len];
+        for(int i = 0; i < len; i++)
+            sinTable[i] = qSin((double)i / len * 2 * M_PI) * 20;
+        for(int i = 0; i < len; i++)
+        {
+            m_pattern += QByteArray::number(i) + ','
+                         + QByteArray::number(sinTable[i], 'f', 2) + ','
+                         + QByteArray::number(sinTable[(i + len / 3) % len], 'f', 2) + ','
+                         + QByteArray::number(sinTable[(i + len / 3 * 2) % len], 'f', 2) + ','
+                         + QByteArray::number(i % (len / 4) + 20) + '\n';
+        }
+    }
+    else if(workload == LineText)
+    {
+        // the line number helps to find the lost data
+        for(int i = 0; i < 1000; i++)
+            m_pattern += QByteArray("Line ") + QByteArray::number(i).rightJustified(3, '0') + ": The quick brown fox jumps over the lazy dog.\r\n";
+    }
+    else if(workload == FixedFrame)
+    {
+        if(frame.isEmpty())
+        {
+            setErrorString(tr("The frame is empty"));
+            return false;
+        }
+        m_pattern = frame;
+    }
+    // RandomBinary has no pattern
+    m_buf.clear();
+    m_produced = 0;
+    m_elapsed = 0;
+    QIODevice::open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    m_elapsedTimer.start();
+    m_timer->start();
+    return true;
+}
+
+void DataGenerator::close()
+{
+    if(!isOpen())
+        return;
+    m_timer->stop();
+    m_elapsed = m_elapsedTimer.nsecsElapsed();
+    m_buf.clear();
+    QIODevice::close();
+}
+
+bool DataGenerator::isSequential() const
+{
+    return true;
+}
+
+qint64 DataGenerator::bytesAvailable() const
+{
+    return m_buf.size() + QIODevice::bytesAvailable();
+}
+
+qint64 DataGenerator::producedBytes() const
+{
+    return m_produced;
+}
+
+double DataGenerator::achievedRate() const
+{
+    qint64 elapsed = isOpen() ? m_elapsedTimer.nsecsElapsed() : m_elapsed;
+    if(elapsed <= 0)
+        return 0;
+    return m_produced * 1e9 / elapsed;
+}
+
+qint64 DataGenerator::readData(char *data, qint64 maxSize)
+{
+    qint64 len = qMin(maxSize, (qint64)m_buf.size());
+    memcpy(data, m_buf.constData(), len);
+    m_buf.remove(0, len);
+    return len;
+}
+
+qint64 DataGenerator::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    return maxSize;
+}
+
+void DataGenerator::onTimeout()
+{
+    // follow the wall clock rather than the timer ticks, so the average rate stays exact
+    qint64 len;
+    if(m_rate == 0)
+        len = maxChunkSize;
+    else
+    {
+        // split the elapsed time to avoid overflow
+        qint64 elapsed = m_elapsedTimer.nsecsElapsed();
+        qint64 target = m_rate * (elapsed / 1000000000) + m_rate * (elapsed % 1000000000) / 1000000000;
+        len = qMin(target - m_produced, maxChunkSize);
+    }
+    if(len <= 0)
+        return;
+    generate(len);
+    m_produced += len;
+    emit readyRead();
+}
+
+void DataGenerator::generate(qint64 len)
+{
+    qint64 oldSize = m_buf.size();
+    m_buf.resize(oldSize + len);
+    char* dest = m_buf.data() + oldSize;
+    if(m_workload == RandomBinary)
+    {
+        quint32 block[256];
+        while(len > 0)
+        {
+            QRandomGenerator::global()->fillRange(block);
+            qint64 n = qMin(len, (qint64)sizeof(block));
+            memcpy(dest, block, n);
+            dest += n;
+            len -= n;
+        }
+        return;
+    }
+    // copy the pattern, continue from where the last call stopped
+    while(len > 0)
+    {
+        qint64 n = qMin(len, m_pattern.size() - m_patternPos);
+        memcpy(dest, m_pattern.constData() + m_patternPos, n);
+        dest += n;
+        len -= n;
+        m_patternPos = (m_patternPos + n) % m_pattern.size();
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QIODevice>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// produce synthetic Rx data at a target rate, no hardware is needed
+// the written data is discarded
+class DataGenerator : public QIODevice
+{
+    Q_OBJECT
+public:
+    enum Workload
+    {
+        SineCSV = 0, // the same lines as demo/Arduino/plot_performance
+        LineText,
+        RandomBinary,
+        FixedFrame,
+    };
+    Q_ENUM(Workload)
+
+    explicit DataGenerator(QObject *parent = nullptr);
+
+    // rate: bytes per second, 0 for as fast as possible
+    // frame: for FixedFrame only
+    bool start(Workload workload, qint64 rate, const QByteArray& frame = QByteArray());
+    void close() override;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    // since the last start(), kept after close()
+    qint64 producedBytes() const;
+    double achievedRate() const;
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+private:
+    QTimer* m_timer;
+    QElapsedTimer m_elapsedTimer;
+    qint64 m_elapsed = 0;
+    Workload m_workload = SineCSV;
+    qint64 m_rate = 0;
+    qint64 m_produced = 0;
+    QByteArray m_pattern; // one period of the workload, repeated
+    qint64 m_patternPos = 0;
+    QByteArray m_buf;
+    void onTimeout();
+    void generate(qint64 len);
+};
+
+#endif // DATAGENERATOR_H
@@ -1,5 +1,6 @@
 ﻿#include "datatab.h"
 #include "util.h"
+#include "tracer.h"
 #include "ui_datatab.h"
 
 #include <QTimer>
@@ -39,6 +40,9 @@ DataTab::DataTab(QByteArray* RxBuf, QByteArray* TxBuf, QWidget *parent) :
     connect(repeatTimer, &QTimer::timeout, this, &DataTab::on_sendButton_clicked);
     connect(RxSlider, &QScrollBar::valueChanged, this, &DataTab::onRxSliderValueChanged);
     connect(RxSlider, &QScrollBar::sliderMoved, this, &DataTab::onRxSliderMoved);
+
+    setClientList(QMap<int, QString>());
+    connect(ui->receivedClientBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DataTab::RxClientChanged);
 }
 
 DataTab::~DataTab()
@@ -404,6 +408,38 @@ bool DataTab::getRxRealtimeState()
     return ui->receivedRealtimeBox->isChecked();
 }
 
+void DataTab::setRxRealtimeState(bool state)
+{
+    ui->receivedRealtimeBox->setChecked(state);
+}
+
+qint64 DataTab::receivedTextMemory()
+{
+    return ui->receivedEdit->document()->characterCount() * sizeof(QChar);
+}
+
+void DataTab::setClientList(const QMap<int, QString>& clientMap)
+{
+    int currId = ui->receivedClientBox->count() > 0 ? RxClientId() : -1;
+    ui->receivedClientBox->blockSignals(true);
+    ui->receivedClientBox->clear();
+    ui->receivedClientBox->addItem(tr("All clients"), -1);
+    for(auto it = clientMap.cbegin(); it != clientMap.cend(); ++it)
+        ui->receivedClientBox->addItem(it.value(), it.key());
+    int index = ui->receivedClientBox->findData(currId);
+    ui->receivedClientBox->setCurrentIndex(qMax(index, 0));
+    ui->receivedClientBox->blockSignals(false);
+    ui->receivedClientBox->setVisible(!clientMap.isEmpty());
+    // the selected client is disconnected
+    if(index < 0)
+        emit RxClientChanged();
+}
+
+int DataTab::RxClientId()
+{
+    return ui->receivedClientBox->currentData().toInt();
+}
+
 
 void DataTab::appendSendedData(const QByteArray& data)
 {
@@ -429,6 +465,8 @@ void DataTab::appendSendedData(const QByteArray& data)
 // void MainWindow::syncEditWithData()
 void DataTab::appendReceivedData(const QByteArray& data)
 {
+    TraceScope scope("DataTab::appendReceivedData");
+    scope.setArg(data.size());
     int cursorPos;
     int sliderPos;
 
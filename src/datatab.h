@@ -34,7 +34,11 @@ public:
 
     void setRepeat(bool state);
     bool getRxRealtimeState();
+    void setRxRealtimeState(bool state);
+    qint64 receivedTextMemory(); // estimated
     void initSettings();
+    void setClientList(const QMap<int, QString>& clientMap);
+    int RxClientId(); // -1: all clients
 
 public slots:
     void onConnTypeChanged(Connection::Type type);
@@ -109,6 +113,7 @@ signals:
     void clearReceivedData();
     void setTxDataRecording(bool enabled);
     void showUpTab(int id);
+    void RxClientChanged();
 };
 
 #endif // DATATAB_H
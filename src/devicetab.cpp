@@ -1,6 +1,6 @@
 ﻿#include "devicetab.h"
 #include "ui_devicetab.h"
-#include "util.h"
+#include "guiutil.h"
 
 #include <QDebug>
 #include <QMessageBox>
@@ -22,6 +22,18 @@ const QMap<QString, QString> DeviceTab::m_historyPrefix =
     {QLatin1String("TCPServer"), QLatin1String("SerialTest_History_TCP_Server")},
     {QLatin1String("TCPClient"), QLatin1String("SerialTest_History_TCP_Client")},
     {QLatin1String("UDP"), QLatin1String("SerialTest_History_UDP")},
+    {QLatin1String("PTY"), QLatin1String("SerialTest_History_PTY")},
+    {QLatin1String("UnixClient"), QLatin1String("SerialTest_History_Unix_Client")},
+    {QLatin1String("UnixServer"), QLatin1String("SerialTest_History_Unix_Server")},
+    {QLatin1String("Fifo"), QLatin1String("SerialTest_History_Fifo")},
+    {QLatin1String("Generator"), QLatin1String("SerialTest_History_Generator")},
+};
+
+const QMap<Connection::Type, QString> DeviceTab::m_localHistoryKey =
+{
+    {Connection::Unix_Client, QLatin1String("UnixClient")},
+    {Connection::Unix_Server, QLatin1String("UnixServer")},
+    {Connection::Fifo, QLatin1String("Fifo")},
 };
 
 DeviceTab::DeviceTab(QWidget *parent) :
@@ -39,10 +51,14 @@ DeviceTab::DeviceTab(QWidget *parent) :
     connect(ui->BLEC_RxServiceUUIDBox, &QComboBox::currentTextChanged, this, &DeviceTab::on_BLEC_ServiceUUIDBox_currentTextChanged);
     connect(ui->BLEC_TxServiceUUIDBox, &QComboBox::currentTextChanged, this, &DeviceTab::on_BLEC_ServiceUUIDBox_currentTextChanged);
     connect(ui->Net_addrPortList, &QTableWidget::cellClicked, this, &DeviceTab::onTargetListCellClicked);
+    connect(ui->Local_historyList, &QTableWidget::cellClicked, this, &DeviceTab::onTargetListCellClicked);
     connect(ui->Net_remoteAddrEdit, &QLineEdit::editingFinished, this, &DeviceTab::Net_onRemoteChanged);
     connect(ui->Net_remotePortEdit, &QLineEdit::editingFinished, this, &DeviceTab::Net_onRemoteChanged);
     ui->SP_baudRateBox->installEventFilter(this);
     ui->BLECentralListSplitter->handle(1)->installEventFilter(this);
+#ifndef Q_OS_LINUX
+    ui->SP_lowLatencyBox->hide();
+#endif
 
     initUI();
     refreshTargetList();
@@ -124,6 +140,27 @@ void DeviceTab::initSettings()
     }
     settings->endArray();
 
+    for(auto it = m_localHistoryKey.cbegin(); it != m_localHistoryKey.cend(); ++it)
+    {
+        const QString& prefix = m_historyPrefix[it.value()];
+        QList<Connection::LocalArgument>& history = m_localHistory[it.key()];
+        size = 0;
+        if(!groups.contains(prefix))
+            settings->beginWriteArray(prefix, 0);
+        else
+            size = settings->beginReadArray(prefix);
+        for(int i = 0; i < size; i++)
+        {
+            settings->setArrayIndex(i);
+
+            QStringList argList = settings->value("Arg").toStringList();
+            Connection::LocalArgument arg = Connection::stringList2LocalArg(argList);
+            if(!arg.path.isEmpty())
+                history.append(arg);
+        }
+        settings->endArray();
+    }
+
     if(m_SPArgHistory.isEmpty())
         loadSPPreference();
     else
@@ -135,6 +172,12 @@ void DeviceTab::initSettings()
     settings->beginGroup(m_historyPrefix["BTServer"]);
     ui->BTServer_serviceNameEdit->setText(settings->value("LastServiceName", "SerialTest_BT").toString());
     settings->endGroup();
+    settings->beginGroup(m_historyPrefix["PTY"]);
+    ui->PTY_linkPathEdit->setText(settings->value("LastLinkPath", "").toString());
+    settings->endGroup();
+    settings->beginGroup(m_historyPrefix["Generator"]);
+    loadGeneratorPreference(Connection::stringList2GeneratorArg(settings->value("LastArg").toStringList()));
+    settings->endGroup();
 
     // TCP server preference(last connected) is loaded in on_typeBox_currentIndexChanged()
 }
@@ -254,6 +297,7 @@ void DeviceTab::initUI()
     ui->BLEC_UUIDList->header()->setStretchLastSection(false); // when stretchLastSection is true, sectionResizeMode will be ignored
     ui->BLEC_UUIDList->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
     ui->Net_addrPortList->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->Local_historyList->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 
     ui->SP_flowControlBox->addItem(tr("NoFlowControl"), QSerialPort::NoFlowControl);
     ui->SP_flowControlBox->addItem(tr("HardwareControl"), QSerialPort::HardwareControl);
@@ -274,6 +318,13 @@ void DeviceTab::initUI()
     ui->SP_dataBitsBox->addItem("7", QSerialPort::Data7);
     ui->SP_dataBitsBox->addItem("8", QSerialPort::Data8);
 
+    ui->Gen_workloadBox->addItem(tr("Sine CSV"), DataGenerator::SineCSV);
+    ui->Gen_workloadBox->addItem(tr("Line Text"), DataGenerator::LineText);
+    ui->Gen_workloadBox->addItem(tr("Random Binary"), DataGenerator::RandomBinary);
+    ui->Gen_workloadBox->addItem(tr("Fixed Frame"), DataGenerator::FixedFrame);
+    // 8N1 UART rates, then beyond any UART
+    ui->Gen_rateBox->addItems({"11520", "92160", "400000", "1000000", "10000000", "0"});
+
     ui->Net_localPortEdit->setValidator(m_netPortValidator);
     ui->Net_remotePortEdit->setValidator(m_netPortValidator);
 
@@ -285,6 +336,7 @@ void DeviceTab::initUI()
     QScroller::grabGesture(ui->BLEC_deviceList);
     QScroller::grabGesture(ui->BLEC_UUIDList);
     QScroller::grabGesture(ui->Net_addrPortList);
+    QScroller::grabGesture(ui->Local_historyList);
 }
 
 void DeviceTab::getAvailableTypes(bool useFirstValid)
@@ -301,6 +353,12 @@ void DeviceTab::getAvailableTypes(bool useFirstValid)
 #endif
 #ifdef Q_OS_WINDOWS
     invalid += Connection::BLE_Peripheral;
+#endif
+#if !defined(Q_OS_UNIX) || defined(Q_OS_ANDROID)
+    invalid += Connection::PTY;
+    invalid += Connection::Unix_Client;
+    invalid += Connection::Unix_Server;
+    invalid += Connection::Fifo;
 #endif
     // check Bluetooth adapters, add adapter info into adapterBox
     num = updateBTAdapterList();
@@ -340,7 +398,7 @@ void DeviceTab::getAvailableTypes(bool useFirstValid)
         if(invalid.contains(it))
         {
             ui->typeBox->addItem("!" + Connection::getTypeName(it), it);
-            Util::disableItem(model, it);
+            GuiUtil::disableItem(model, it);
         }
         else
         {
@@ -478,6 +536,14 @@ void DeviceTab::onClientCountChanged()
     emit clientCountChanged();
 }
 
+void DeviceTab::PTY_updateSlaveName()
+{
+    if(m_connection->type() == Connection::PTY && m_connection->isConnected())
+        ui->PTY_slavePathEdit->setText(m_connection->PTY_slaveName());
+    else
+        ui->PTY_slavePathEdit->clear();
+}
+
 void DeviceTab::Net_onDeleteButtonClicked()
 {
     QPushButton* btn = qobject_cast<QPushButton*>(sender());
@@ -501,6 +567,18 @@ void DeviceTab::Net_onDeleteButtonClicked()
 
 }
 
+void DeviceTab::Local_onDeleteButtonClicked()
+{
+    QPushButton* btn = qobject_cast<QPushButton*>(sender());
+    Connection::Type currType = m_connection->type();
+    QVariant var = btn->property("ItemId");
+    if(!var.isValid() || !m_localHistoryKey.contains(currType))
+        return;
+    m_localHistory[currType].removeAt(var.toInt());
+    syncLocalPreference(currType);
+    showLocalArgumentHistory(currType);
+}
+
 bool DeviceTab::eventFilter(QObject *watched, QEvent *event)
 {
     if(watched == ui->SP_baudRateBox && event->type() == QEvent::FocusOut)
@@ -558,6 +636,7 @@ void DeviceTab::on_openButton_clicked()
         arg.stopBits = (QSerialPort::StopBits)ui->SP_stopBitsBox->currentData().toInt();
         arg.parity = (QSerialPort::Parity)ui->SP_parityBox->currentData().toInt();
         arg.flowControl = (QSerialPort::FlowControl)ui->SP_flowControlBox->currentData().toInt();
+        arg.lowLatency = ui->SP_lowLatencyBox->isChecked();
         QSerialPortInfo info(arg.name);
         if(info.vendorIdentifier() != 0 && info.productIdentifier() != 0)
             arg.id = QString::number(info.vendorIdentifier()) + "-" + QString::number(info.productIdentifier());
@@ -685,6 +764,66 @@ void DeviceTab::on_openButton_clicked()
         m_connection->setArgument(arg);
         m_connection->open();
     }
+    else if(currType == Connection::PTY)
+    {
+        if(m_connection->state() != Connection::Unconnected)
+        {
+            QMessageBox::warning(this, tr("Error"), tr("The pseudo-terminal has been created."));
+            return;
+        }
+        QString linkPath = ui->PTY_linkPathEdit->text().trimmed();
+        m_connection->PTY_setLinkPath(linkPath);
+        m_connection->open();
+
+        settings->beginGroup(m_historyPrefix["PTY"]);
+        settings->setValue("LastLinkPath", linkPath);
+        settings->endGroup();
+    }
+    else if(currType == Connection::Generator)
+    {
+        if(m_connection->state() != Connection::Unconnected)
+        {
+            QMessageBox::warning(this, tr("Error"), tr("The generator is running."));
+            return;
+        }
+        Connection::GeneratorArgument arg;
+        bool isOk;
+        arg.workload = ui->Gen_workloadBox->currentData().value<DataGenerator::Workload>();
+        arg.rate = ui->Gen_rateBox->currentText().toLongLong(&isOk);
+        if(!isOk || arg.rate < 0)
+        {
+            QMessageBox::warning(this, tr("Error"), tr("Invalid rate."));
+            return;
+        }
+        arg.frame = QByteArray::fromHex(ui->Gen_frameEdit->text().toLatin1());
+        m_connection->setArgument(arg);
+        m_connection->open();
+
+        settings->beginGroup(m_historyPrefix["Generator"]);
+        settings->setValue("LastArg", Connection::arg2StringList(arg));
+        settings->endGroup();
+    }
+    else if(currType == Connection::Unix_Client || currType == Connection::Unix_Server || currType == Connection::Fifo)
+    {
+        if(m_connection->state() != Connection::Unconnected)
+        {
+            QMessageBox::warning(this, tr("Error"), tr("Please close the current connection first."));
+            return;
+        }
+        Connection::LocalArgument arg;
+        arg.path = ui->Local_pathEdit->text().trimmed();
+        if(arg.path.isEmpty())
+        {
+            QMessageBox::warning(this, tr("Error"), tr("Please input the path."));
+            return;
+        }
+        if(currType == Connection::Fifo)
+            arg.writePath = ui->Local_writePathEdit->text().trimmed();
+        else
+            arg.datagram = ui->Local_datagramBox->isChecked();
+        m_connection->setArgument(arg);
+        m_connection->open();
+    }
 }
 
 void DeviceTab::on_closeButton_clicked()
@@ -738,6 +877,11 @@ void DeviceTab::onTargetListCellClicked(int row, int column)
         ui->Net_remoteAddrEdit->setText(ui->Net_addrPortList->item(row, 3)->text());
         ui->Net_remotePortEdit->setText(ui->Net_addrPortList->item(row, 4)->text());
     }
+    else if(m_localHistoryKey.contains(currType))
+    {
+        const QList<Connection::LocalArgument>& history = m_localHistory[currType];
+        loadLocalPreference(history[history.size() - 1 - row]);
+    }
 }
 
 // platform specific
@@ -805,6 +949,42 @@ void DeviceTab::syncUDPPreference()
     settings->endArray();
 }
 
+void DeviceTab::saveLocalPreference(const Connection::LocalArgument& arg)
+{
+    Connection::Type type = m_connection->type();
+    if(!m_localHistoryKey.contains(type))
+        return;
+    QList<Connection::LocalArgument>& history = m_localHistory[type];
+    int id;
+    Connection::LocalArgument newArg;
+    id = history.indexOf(arg);
+    if(id != -1)
+        newArg = history.takeAt(id);
+    else
+        newArg = arg;
+    history.append(newArg);
+
+    syncLocalPreference(type);
+    showLocalArgumentHistory(type);
+}
+
+void DeviceTab::syncLocalPreference(Connection::Type type)
+{
+    QList<Connection::LocalArgument>& history = m_localHistory[type];
+    int num;
+    num = (history.length() > m_maxHistoryNum) ? (history.length() - m_maxHistoryNum) : 0;
+    for(int i = 0; i < num; i++)
+        history.removeFirst();
+
+    settings->beginWriteArray(m_historyPrefix[m_localHistoryKey[type]], history.length());
+    for(int i = 0; i < history.length(); i++)
+    {
+        settings->setArrayIndex(i);
+        settings->setValue("Arg", Connection::arg2StringList(history[i]));
+    }
+    settings->endArray();
+}
+
 void DeviceTab::saveSPPreference(const Connection::SerialPortArgument& arg)
 {
     int removeNum = 0;
@@ -855,6 +1035,7 @@ void DeviceTab::loadSPPreference(const Connection::SerialPortArgument& arg)
     ui->SP_stopBitsBox->setCurrentIndex(ui->SP_stopBitsBox->findData(arg.stopBits));
     ui->SP_parityBox->setCurrentIndex(ui->SP_parityBox->findData(arg.parity));
     ui->SP_flowControlBox->setCurrentIndex(ui->SP_flowControlBox->findData(arg.flowControl));
+    ui->SP_lowLatencyBox->setChecked(arg.lowLatency);
 }
 
 void DeviceTab::loadNetPreference(const Connection::NetworkArgument& arg, Connection::Type type)
@@ -904,6 +1085,52 @@ void DeviceTab::showNetArgumentHistory(const QList<Connection::NetworkArgument>
     ui->Net_addrPortList->blockSignals(false);
 }
 
+void DeviceTab::loadLocalPreference(const Connection::LocalArgument& arg)
+{
+    ui->Local_pathEdit->setText(arg.path);
+    ui->Local_writePathEdit->setText(arg.writePath);
+    ui->Local_datagramBox->setChecked(arg.datagram);
+}
+
+void DeviceTab::loadGeneratorPreference(const Connection::GeneratorArgument& arg)
+{
+    ui->Gen_workloadBox->setCurrentIndex(ui->Gen_workloadBox->findData(arg.workload));
+    ui->Gen_rateBox->setEditText(QString::number(arg.rate));
+    ui->Gen_frameEdit->setText(QString::fromLatin1(arg.frame.toHex(' ')));
+}
+
+void DeviceTab::showLocalArgumentHistory(Connection::Type type)
+{
+    const QList<Connection::LocalArgument>& argList = m_localHistory[type];
+    ui->Local_historyList->setRowCount(0);
+    ui->Local_historyList->setRowCount(argList.size());
+    ui->Local_historyList->blockSignals(true); // avoid emitting cellChanged()
+    int size = argList.size();
+    for(int i = 0; i < size; i++)
+    {
+        // reversed order
+        QTableWidgetItem* tmpItem;
+        tmpItem = new QTableWidgetItem(argList[i].alias);
+        tmpItem->setFlags(tmpItem->flags() | Qt::ItemIsEditable);
+        ui->Local_historyList->setItem(size - i - 1, 0, tmpItem);
+        tmpItem = new QTableWidgetItem(argList[i].path);
+        tmpItem->setFlags(tmpItem->flags() & ~Qt::ItemIsEditable);
+        ui->Local_historyList->setItem(size - i - 1, 1, tmpItem);
+        tmpItem = new QTableWidgetItem(argList[i].writePath);
+        tmpItem->setFlags(tmpItem->flags() & ~Qt::ItemIsEditable);
+        ui->Local_historyList->setItem(size - i - 1, 2, tmpItem);
+        tmpItem = new QTableWidgetItem(type == Connection::Fifo ? "" : (argList[i].datagram ? tr("Datagram") : tr("Stream")));
+        tmpItem->setFlags(tmpItem->flags() & ~Qt::ItemIsEditable);
+        ui->Local_historyList->setItem(size - i - 1, 3, tmpItem);
+        QPushButton* deleteButton = new QPushButton;
+        deleteButton->setText(tr("Delete"));
+        deleteButton->setProperty("ItemId", i);
+        connect(deleteButton, &QPushButton::clicked, this, &DeviceTab::Local_onDeleteButtonClicked);
+        ui->Local_historyList->setIndexWidget(ui->Local_historyList->model()->index(size - i - 1, 4), deleteButton);
+    }
+    ui->Local_historyList->blockSignals(false);
+}
+
 void DeviceTab::BTdiscoverFinished()
 {
     ui->refreshButton->setText(tr("Refresh"));
@@ -1071,6 +1298,32 @@ void DeviceTab::on_typeBox_currentIndexChanged(int index)
             showNetArgumentHistory(m_UDPHistory, newType);
         }
     }
+    else if(newType == Connection::PTY)
+    {
+        ui->targetListStack->setCurrentWidget(ui->PTYListPage);
+        ui->argsStack->setCurrentWidget(ui->PTYArgsPage);
+        PTY_updateSlaveName();
+    }
+    else if(newType == Connection::Unix_Client || newType == Connection::Unix_Server || newType == Connection::Fifo)
+    {
+        bool isFifo = (newType == Connection::Fifo);
+        ui->Local_writePathLabel->setVisible(isFifo);
+        ui->Local_writePathEdit->setVisible(isFifo);
+        ui->Local_datagramBox->setVisible(!isFifo);
+        ui->Local_pathLabel->setText(isFifo ? tr("Read Path:") : tr("Path:"));
+        ui->Local_pathEdit->setPlaceholderText(isFifo ? "/tmp/SerialTest.fifo" : "/tmp/SerialTest.sock");
+        ui->targetListStack->setCurrentWidget(ui->LocalListPage);
+        ui->argsStack->setCurrentWidget(ui->LocalArgsPage);
+
+        const QList<Connection::LocalArgument>& history = m_localHistory[newType];
+        loadLocalPreference(history.isEmpty() ? Connection::LocalArgument() : history.last());
+        showLocalArgumentHistory(newType);
+    }
+    else if(newType == Connection::Generator)
+    {
+        ui->targetListStack->setCurrentWidget(ui->GeneratorListPage);
+        ui->argsStack->setCurrentWidget(ui->GeneratorArgsPage);
+    }
     emit connTypeChanged(newType);
     refreshTargetList();
 }
@@ -1423,6 +1676,27 @@ void DeviceTab::on_Net_addrPortList_cellChanged(int row, int column)
     }
 }
 
+void DeviceTab::on_Gen_workloadBox_currentIndexChanged(int index)
+{
+    Q_UNUSED(index)
+    bool isFrame = (ui->Gen_workloadBox->currentData().value<DataGenerator::Workload>() == DataGenerator::FixedFrame);
+    ui->Gen_frameLabel->setVisible(isFrame);
+    ui->Gen_frameEdit->setVisible(isFrame);
+}
+
+void DeviceTab::on_Local_historyList_cellChanged(int row, int column)
+{
+    Connection::Type type = m_connection->type();
+    if(m_localHistoryKey.contains(type) && column == 0)
+    {
+        // update alias
+        // 0:alias
+        QList<Connection::LocalArgument>& history = m_localHistory[type];
+        history[history.size() - 1 - row].alias = ui->Local_historyList->item(row, 0)->text();
+        syncLocalPreference(type);
+    }
+}
+
 void DeviceTab::on_BLEC_ServiceUUIDBox_currentTextChanged(const QString &arg1)
 {
     QComboBox* serviceBox = qobject_cast<QComboBox*>(sender());
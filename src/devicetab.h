@@ -34,11 +34,15 @@ public slots:
     void saveTCPClientPreference(const Connection::NetworkArgument &arg);
     void saveUDPPreference(const Connection::NetworkArgument &arg);
     void saveSPPreference(const Connection::SerialPortArgument& arg);
+    void saveLocalPreference(const Connection::LocalArgument& arg);
     void getAvailableTypes(bool useFirstValid = false);
     void onClientCountChanged();
+    void PTY_updateSlaveName();
     void Net_onDeleteButtonClicked();
     void syncUDPPreference();
     void syncTCPClientPreference();
+    void Local_onDeleteButtonClicked();
+    void syncLocalPreference(Connection::Type type);
 protected:
     bool eventFilter(QObject *watched, QEvent *event) override;
 private:
@@ -65,6 +69,9 @@ private:
     QList<Connection::BTArgument> m_BLECArgHistory;
     QMap<QString, int> m_BLECArgHistoryIndex;
     QList<Connection::NetworkArgument> m_TCPClientHistory, m_UDPHistory;
+    // Unix_Client, Unix_Server and Fifo
+    QMap<Connection::Type, QList<Connection::LocalArgument>> m_localHistory;
+    static const QMap<Connection::Type, QString> m_localHistoryKey;
 
     void initUI();
 #ifdef Q_OS_ANDROID
@@ -82,6 +89,9 @@ private:
     void loadSPPreference(const Connection::SerialPortArgument &arg = Connection::SerialPortArgument());
     void loadNetPreference(const Connection::NetworkArgument &arg, Connection::Type type);
     void showNetArgumentHistory(const QList<Connection::NetworkArgument> &arg, Connection::Type type);
+    void loadLocalPreference(const Connection::LocalArgument &arg);
+    void loadGeneratorPreference(const Connection::GeneratorArgument &arg);
+    void showLocalArgumentHistory(Connection::Type type);
 signals:
     void connTypeChanged(Connection::Type type);
     void argumentChanged();
@@ -110,6 +120,8 @@ private slots:
     void BLEC_onServiceDetailDiscovered(QLowEnergyService::ServiceState newState);
     void on_BTServer_deviceList_cellChanged(int row, int column);
     void on_Net_addrPortList_cellChanged(int row, int column);
+    void on_Local_historyList_cellChanged(int row, int column);
+    void on_Gen_workloadBox_currentIndexChanged(int index);
     void on_BLEC_ServiceUUIDBox_currentTextChanged(const QString &arg1);
 };
 
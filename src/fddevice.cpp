@@ -0,0 +1,157 @@
+#include "fddevice.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+FdDevice::FdDevice(QObject *parent)
+    : QIODevice{parent}
+{
+
+}
+
+FdDevice::~FdDevice()
+{
+    FdDevice::close();
+}
+
+bool FdDevice::openFds(int readFd, int writeFd)
+{
+#ifdef Q_OS_UNIX
+    if(isOpen() || (readFd < 0 && writeFd < 0))
+        return false;
+    m_readFd = readFd;
+    m_writeFd = writeFd;
+    OpenMode mode = QIODevice::Unbuffered;
+    if(m_readFd >= 0)
+    {
+        fcntl(m_readFd, F_SETFL, fcntl(m_readFd, F_GETFL) | O_NONBLOCK);
+        m_readNotifier = new QSocketNotifier(m_readFd, QSocketNotifier::Read, this);
+        // the data is read in the slots of readyRead()
+        connect(m_readNotifier, &QSocketNotifier::activated, this, &FdDevice::readyRead);
+        mode |= QIODevice::ReadOnly;
+    }
+    if(m_writeFd >= 0)
+    {
+        fcntl(m_writeFd, F_SETFL, fcntl(m_writeFd, F_GETFL) | O_NONBLOCK);
+        m_writeNotifier = new QSocketNotifier(m_writeFd, QSocketNotifier::Write, this);
+        m_writeNotifier->setEnabled(false);
+        connect(m_writeNotifier, &QSocketNotifier::activated, this, &FdDevice::writeBuffered);
+        mode |= QIODevice::WriteOnly;
+    }
+    return QIODevice::open(mode);
+#else
+    Q_UNUSED(readFd)
+    Q_UNUSED(writeFd)
+    return false;
+#endif
+}
+
+void FdDevice::close()
+{
+#ifdef Q_OS_UNIX
+    if(isOpen())
+        QIODevice::close();
+    delete m_readNotifier;
+    m_readNotifier = nullptr;
+    delete m_writeNotifier;
+    m_writeNotifier = nullptr;
+    m_writeBuffer.clear();
+    if(m_writeFd >= 0 && m_writeFd != m_readFd)
+        ::close(m_writeFd);
+    if(m_readFd >= 0)
+        ::close(m_readFd);
+    m_readFd = -1;
+    m_writeFd = -1;
+#endif
+}
+
+bool FdDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 FdDevice::bytesAvailable() const
+{
+    int len = 0;
+#ifdef Q_OS_UNIX
+    if(m_readFd >= 0)
+        ioctl(m_readFd, FIONREAD, &len);
+#endif
+    return len + QIODevice::bytesAvailable();
+}
+
+qint64 FdDevice::bytesToWrite() const
+{
+    return m_writeBuffer.size();
+}
+
+int FdDevice::readHandle() const
+{
+    return m_readFd;
+}
+
+int FdDevice::writeHandle() const
+{
+    return m_writeFd;
+}
+
+void FdDevice::setSystemError()
+{
+#ifdef Q_OS_UNIX
+    setErrorString(QString::fromLocal8Bit(strerror(errno)));
+#endif
+}
+
+qint64 FdDevice::readData(char *data, qint64 maxSize)
+{
+#ifdef Q_OS_UNIX
+    qint64 len = ::read(m_readFd, data, maxSize);
+    if(len < 0)
+    {
+        if(errno == EAGAIN || errno == EINTR)
+            return 0;
+        setSystemError();
+        return -1;
+    }
+    return len;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+#endif
+}
+
+qint64 FdDevice::writeData(const char *data, qint64 maxSize)
+{
+    m_writeBuffer.append(data, maxSize);
+    // try to write now, the rest is written when the descriptor is writable
+    if(m_writeBuffer.size() == maxSize)
+        writeBuffered();
+    return maxSize;
+}
+
+void FdDevice::writeBuffered()
+{
+#ifdef Q_OS_UNIX
+    qint64 len = ::write(m_writeFd, m_writeBuffer.constData(), m_writeBuffer.size());
+    if(len < 0 && errno != EAGAIN && errno != EINTR)
+    {
+        setSystemError();
+        m_writeBuffer.clear();
+        m_writeNotifier->setEnabled(false);
+        return;
+    }
+    if(len > 0)
+    {
+        m_writeBuffer.remove(0, len);
+        // bytesWritten() might be connected to a slot which writes more
+        QMetaObject::invokeMethod(this, "bytesWritten", Qt::QueuedConnection, Q_ARG(qint64, len));
+    }
+    m_writeNotifier->setEnabled(!m_writeBuffer.isEmpty());
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef FDDEVICE_H
+#define FDDEVICE_H
+
+#include <QIODevice>
+#include <QSocketNotifier>
+
+// a stream over Unix file descriptors, driven by the notifiers of the event loop
+// the base of the pseudo-terminal, FIFO and Unix datagram socket devices
+class FdDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit FdDevice(QObject *parent = nullptr);
+    ~FdDevice();
+
+    void close() override;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    qint64 bytesToWrite() const override;
+    int readHandle() const;
+    int writeHandle() const;
+protected:
+    // take the ownership of the descriptors, either can be -1, or both are the same one
+    bool openFds(int readFd, int writeFd);
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+    // set the error string from errno
+    void setSystemError();
+private:
+    int m_readFd = -1;
+    int m_writeFd = -1;
+    QSocketNotifier* m_readNotifier = nullptr;
+    QSocketNotifier* m_writeNotifier = nullptr;
+    QByteArray m_writeBuffer;
+    void writeBuffered();
+};
+
+#endif // FDDEVICE_H
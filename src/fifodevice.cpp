@@ -0,0 +1,74 @@
+#include "fifodevice.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <errno.h>
+#endif
+
+FifoDevice::FifoDevice(QObject *parent)
+    : FdDevice{parent}
+{
+
+}
+
+bool FifoDevice::openFifo(const QString& readPath, const QString& writePath)
+{
+#ifdef Q_OS_UNIX
+    if(isOpen())
+        return false;
+    if(readPath.isEmpty() && writePath.isEmpty())
+    {
+        setErrorString(tr("No FIFO is specified"));
+        return false;
+    }
+    int readFd = -1, writeFd = -1;
+    if(!readPath.isEmpty() && (readFd = openPath(readPath)) < 0)
+        return false;
+    if(writePath == readPath)
+        writeFd = readFd;
+    else if(!writePath.isEmpty() && (writeFd = openPath(writePath)) < 0)
+    {
+        if(readFd >= 0)
+            ::close(readFd);
+        return false;
+    }
+    return openFds(readFd, writeFd);
+#else
+    Q_UNUSED(readPath)
+    Q_UNUSED(writePath)
+    setErrorString(tr("FIFO is not supported on this platform"));
+    return false;
+#endif
+}
+
+int FifoDevice::openPath(const QString& path)
+{
+#ifdef Q_OS_UNIX
+    QByteArray name = path.toLocal8Bit();
+    struct stat st;
+    if(stat(name.constData(), &st) < 0)
+    {
+        if(errno != ENOENT || mkfifo(name.constData(), 0666) < 0)
+        {
+            setSystemError();
+            return -1;
+        }
+    }
+    else if(!S_ISFIFO(st.st_mode))
+    {
+        setErrorString(path + " " + tr("is not a FIFO"));
+        return -1;
+    }
+    // with O_RDWR, open() doesn't wait for the other side, and read() doesn't return EOF after the other side closes it
+    // POSIX leaves it undefined, but Linux and macOS support it
+    int fd = ::open(name.constData(), O_RDWR | O_NONBLOCK);
+    if(fd < 0)
+        setSystemError();
+    return fd;
+#else
+    Q_UNUSED(path)
+    return -1;
+#endif
+}
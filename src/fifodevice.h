@@ -0,0 +1,19 @@
+#ifndef FIFODEVICE_H
+#define FIFODEVICE_H
+
+#include "fddevice.h"
+
+// a pair of named pipes, one for Rx and one for Tx, Unix only
+class FifoDevice : public FdDevice
+{
+    Q_OBJECT
+public:
+    explicit FifoDevice(QObject *parent = nullptr);
+
+    // either path can be empty, the FIFO is created if it doesn't exist
+    bool openFifo(const QString& readPath, const QString& writePath);
+private:
+    int openPath(const QString& path);
+};
+
+#endif // FIFODEVICE_H
@@ -0,0 +1,104 @@
+#include "fileprotocol.h"
+
+#include <QFileInfo>
+#include <QDir>
+
+FileProtocol::FileProtocol(QObject *parent)
+    : QObject{parent}
+{
+    // for the queued connections and QSignalSpy, the engines are used without FileXceiver too
+    qRegisterMetaType<qsizetype>("qsizetype"); // qsizetype is an alias, so the typeName is compulsory
+    m_file.setParent(this); // for moveToThread()
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &FileProtocol::onTimeout);
+}
+
+void FileProtocol::setArgument(const Argument &arg)
+{
+    m_argument = arg;
+}
+
+void FileProtocol::stop()
+{
+    if(!m_isRunning)
+        return;
+    m_isRunning = false;
+    m_timer->stop();
+    m_file.close();
+    sendCancel();
+}
+
+void FileProtocol::onReconnected()
+{
+
+}
+
+bool FileProtocol::isRunning()
+{
+    return m_isRunning;
+}
+
+void FileProtocol::setPendingFiles(const QStringList &files)
+{
+    m_pendingFiles = files;
+}
+
+QStringList FileProtocol::takePendingFiles()
+{
+    QStringList files = m_pendingFiles;
+    m_pendingFiles.clear();
+    return files;
+}
+
+bool FileProtocol::openNextFile()
+{
+    while(!m_pendingFiles.isEmpty())
+    {
+        QString filename = m_pendingFiles.takeFirst();
+        m_file.close();
+        m_file.setFileName(filename);
+        if(m_file.open(QFile::ReadOnly))
+        {
+            emit fileStarted(filename, m_file.size());
+            return true;
+        }
+        emit message(tr("Failed to open") + " " + filename);
+    }
+    return false;
+}
+
+QString FileProtocol::receiveFilePath(const QString &name)
+{
+    // drop the directories in the name, the file should never be written outside
+    QString fileName = QFileInfo(name).fileName();
+    if(fileName.isEmpty())
+        fileName = "untitled";
+    QFileInfo pathInfo(m_receivePath);
+    QDir dir = pathInfo.isDir() ? QDir(m_receivePath) : pathInfo.absoluteDir();
+    return dir.filePath(fileName);
+}
+
+void FileProtocol::sendCancel()
+{
+    // the backspaces erase the CANs if the peer is in a command line
+    emit send(QByteArray(8, '\x18') + QByteArray(8, '\x08'));
+}
+
+void FileProtocol::complete()
+{
+    m_isRunning = false;
+    m_timer->stop();
+    m_file.close();
+    emit finished();
+}
+
+void FileProtocol::fail(const QString &info, bool cancelPeer)
+{
+    m_isRunning = false;
+    m_timer->stop();
+    m_file.close();
+    if(cancelPeer)
+        sendCancel();
+    emit error(info);
+}
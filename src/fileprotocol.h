@@ -0,0 +1,70 @@
+#ifndef FILEPROTOCOL_H
+#define FILEPROTOCOL_H
+
+#include <QObject>
+#include <QFile>
+#include <QStringList>
+#include <QTimer>
+
+// base class of the protocol engines
+// the engines are state machines driven by newData() and the timeout timer
+class FileProtocol : public QObject
+{
+    Q_OBJECT
+public:
+    struct Argument
+    {
+        int timeout = 10000; // ms
+        int retryNum = 10;
+        // ZMODEM: the sender waits for ZACK when the unacknowledged bytes reach the window
+        // Chunked: the sender asks for the missing blocks after sending the window
+        // 0: no window, stream the whole file
+        qsizetype window = 65536;
+        bool resume = false; // ZMODEM only
+        quint32 blockSize = 4096; // Chunked only
+    };
+
+    explicit FileProtocol(QObject *parent = nullptr);
+
+    void setArgument(const Argument& arg);
+    virtual bool startTransmit(const QString& filename) = 0;
+    // for batch protocols, the received files are saved in the directory of the path with their own names
+    virtual bool startReceive(const QString& path) = 0;
+    virtual void newData(const QByteArray& data) = 0;
+    // abort the transfer and notify the peer
+    virtual void stop();
+    // the connection is reopened, the data sent in between is lost
+    virtual void onReconnected();
+    bool isRunning();
+    // batch protocols send these files after the current one in the same session,
+    // others leave them to FileXceiver
+    void setPendingFiles(const QStringList& files);
+    QStringList takePendingFiles();
+protected:
+    Argument m_argument;
+    QTimer* m_timer;
+    int m_retryCount = 0;
+    QFile m_file;
+    QString m_receivePath;
+    QStringList m_pendingFiles;
+    bool m_isRunning = false;
+
+    virtual void onTimeout() = 0;
+    QString receiveFilePath(const QString& name);
+    bool openNextFile();
+    void sendCancel();
+    void complete();
+    void fail(const QString& info, bool cancelPeer = true);
+signals:
+    void send(const QByteArray& data);
+    void dataTransmitted(qsizetype num);
+    void dataReceived(qsizetype num);
+    void fileStarted(const QString& filename, qint64 size); // the next file in the batch
+    void message(const QString& msg);
+    void finished();
+    void error(const QString& info);
+};
+
+Q_DECLARE_METATYPE(FileProtocol::Argument)
+
+#endif // FILEPROTOCOL_H
@@ -8,6 +8,7 @@
 #include <QMimeData>
 #include <QElapsedTimer>
 #include <QDateTime>
+#include <QDirIterator>
 
 FileTab* FileTab::m_currInstance = nullptr;
 
@@ -17,26 +18,28 @@ FileTab::FileTab(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    m_checksumThread = new QThread(this);
     m_checksumCalc = new AsyncCRC();
-    m_fileXceiverThread = new QThread(this);
     m_fileXceiver = new FileXceiver();
     m_intValidator = new QIntValidator(this);
     m_intValidator->setBottom(0);
 
     m_checksumCalc->setNotify(true);
     m_checksumCalc->setParam(32, 0x04C11DB7ULL, 0xFFFFFFFFULL, true, true, 0xFFFFFFFFULL); // CRC-32
-    m_checksumCalc->moveToThread(m_checksumThread);
-    m_checksumThread->start();
+    m_checksumCalc->moveToThread(Util::workerThread(Util::ChecksumWorker));
     connect(m_checksumCalc, &AsyncCRC::result, this, &FileTab::onChecksumUpdated);
     connect(m_checksumCalc, &AsyncCRC::fileError, this, &FileTab::onChecksumError);
 
-    m_fileXceiver->moveToThread(m_fileXceiverThread);
-    m_fileXceiverThread->start();
+    m_fileXceiver->moveToThread(Util::workerThread(Util::TransceiverWorker));
     connect(m_fileXceiver, &FileXceiver::startResult, this, &FileTab::onStartResultArrived);
     connect(m_fileXceiver, &FileXceiver::dataTransmitted, this, &FileTab::onDataTransmitted);
     connect(m_fileXceiver, &FileXceiver::dataReceived, this, &FileTab::onDataReceived);
     connect(m_fileXceiver, &FileXceiver::finished, this, &FileTab::onFinished);
+    connect(m_fileXceiver, &FileXceiver::error, this, &FileTab::onXceiverError);
+    connect(m_fileXceiver, &FileXceiver::message, this, &FileTab::showMessage);
+    connect(m_fileXceiver, &FileXceiver::checksumUpdated, this, &FileTab::onChecksumUpdated);
+    connect(m_fileXceiver, &FileXceiver::fileStarted, this, &FileTab::onFileStarted);
+    connect(m_fileXceiver, &FileXceiver::fileFinished, this, &FileTab::onFileFinished);
+    connect(m_fileXceiver, &FileXceiver::fileChecksumReady, this, &FileTab::onFileChecksumReady);
 
 
     m_currInstance = this;
@@ -56,10 +59,23 @@ FileTab::FileTab(QWidget *parent) :
 
     ui->centralLayout->setStretchFactor(ui->statusEdit, 1);
     ui->protoBox->addItem(tr("Raw"), QVariant::fromValue(FileXceiver::RawProtocol));
+    ui->protoBox->addItem("XMODEM", QVariant::fromValue(FileXceiver::XModemProtocol));
+    ui->protoBox->addItem("XMODEM-1K", QVariant::fromValue(FileXceiver::XModem1KProtocol));
+    ui->protoBox->addItem("YMODEM", QVariant::fromValue(FileXceiver::YModemProtocol));
+    ui->protoBox->addItem("ZMODEM", QVariant::fromValue(FileXceiver::ZModemProtocol));
+    ui->protoBox->addItem(tr("Chunked"), QVariant::fromValue(FileXceiver::ChunkedProtocol));
     ui->RawTx_throttleByteBox->setValidator(m_intValidator);
     ui->RawTx_throttleMsBox->setValidator(m_intValidator);
     ui->RawTx_throttleWaitMsBox->setValidator(m_intValidator);
+    ui->RawTx_lowWatermarkBox->setValidator(m_intValidator);
+    ui->RawTx_highWatermarkBox->setValidator(m_intValidator);
     ui->RawRx_autostopByteBox->setValidator(m_intValidator);
+    ui->RawRx_bufferBox->setValidator(m_intValidator);
+    ui->RawRx_syncMsBox->setValidator(m_intValidator);
+    ui->Modem_timeoutBox->setValidator(m_intValidator);
+    ui->ZModem_windowBox->setValidator(m_intValidator);
+    ui->Chunk_blockBox->setValidator(m_intValidator);
+    ui->Chunk_roundBox->setValidator(m_intValidator);
 
     on_tipsBackButton_clicked();
 
@@ -75,14 +91,15 @@ FileTab::FileTab(QWidget *parent) :
 
 FileTab::~FileTab()
 {
-    QMetaObject::invokeMethod(m_fileXceiver, "stop", Qt::QueuedConnection);
+    // write the received data before deleting
+    QMetaObject::invokeMethod(m_fileXceiver, "stop", Qt::BlockingQueuedConnection);
     delete ui;
-    delete m_checksumCalc;
-    m_checksumThread->terminate();
-    m_checksumThread->wait(1000);
-    delete m_fileXceiver;
-    m_fileXceiverThread->terminate();
-    m_fileXceiverThread->wait(2000);
+    // the threads are shared by all sessions, delete the objects in their own threads
+    m_checksumCalc->deleteLater();
+    QMetaObject::invokeMethod(m_fileXceiver, [ = ]()
+    {
+        delete m_fileXceiver;
+    }, Qt::BlockingQueuedConnection);
 }
 
 void FileTab::initSettings()
@@ -100,10 +117,24 @@ void FileTab::initSettings()
     connect(ui->RawTx_throttleByteBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
     connect(ui->RawTx_throttleMsBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
     connect(ui->RawTx_throttleWaitMsBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawTx_lowWatermarkBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawTx_highWatermarkBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawTx_recordBox, &QCheckBox::clicked, this, &FileTab::saveFilePreference);
 
     connect(ui->RawRx_autostopNoneButton, &QRadioButton::clicked, this, &FileTab::saveFilePreference);
     connect(ui->RawRx_autostopByteButton, &QRadioButton::clicked, this, &FileTab::saveFilePreference);
     connect(ui->RawRx_autostopByteBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawRx_bufferBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawRx_syncBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &FileTab::saveFilePreference);
+    connect(ui->RawRx_syncMsBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->RawRx_verifyBox, &QCheckBox::clicked, this, &FileTab::saveFilePreference);
+    connect(ui->RawRx_verifyEdit, &QLineEdit::editingFinished, this, &FileTab::saveFilePreference);
+
+    connect(ui->Modem_timeoutBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->ZModem_windowBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->ZModem_resumeBox, &QCheckBox::clicked, this, &FileTab::saveFilePreference);
+    connect(ui->Chunk_blockBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
+    connect(ui->Chunk_roundBox, &QComboBox::currentTextChanged, this, &FileTab::saveFilePreference);
 
     connect(ui->filePathEdit, &QLineEdit::editingFinished, this, &FileTab::saveFilePreference);
 }
@@ -137,12 +168,27 @@ void FileTab::on_RawTx_throttleGrp_buttonClicked(QAbstractButton* button)
     ui->RawTx_throttleByteBox->setEnabled(ui->RawTx_throttleByteButton->isChecked());
     ui->RawTx_throttleMsBox->setEnabled(ui->RawTx_throttleMsButton->isChecked());
     ui->RawTx_throttleWaitMsBox->setEnabled(!ui->RawTx_throttleNoneButton->isChecked());
+    ui->RawTx_lowWatermarkBox->setEnabled(ui->RawTx_throttleNoneButton->isChecked());
+    ui->RawTx_highWatermarkBox->setEnabled(ui->RawTx_throttleNoneButton->isChecked());
 }
 
 void FileTab::on_RawRx_autostopGrp_buttonClicked(QAbstractButton* button)
 {
     Q_UNUSED(button)
     ui->RawRx_autostopByteBox->setEnabled(ui->RawRx_autostopByteButton->isChecked());
+    ui->RawRx_verifyBox->setEnabled(ui->RawRx_autostopByteButton->isChecked());
+    ui->RawRx_verifyEdit->setEnabled(ui->RawRx_autostopByteButton->isChecked() && ui->RawRx_verifyBox->isChecked());
+}
+
+void FileTab::on_RawRx_verifyBox_toggled(bool checked)
+{
+    Q_UNUSED(checked)
+    on_RawRx_autostopGrp_buttonClicked(nullptr);
+}
+
+void FileTab::on_RawRx_syncBox_currentIndexChanged(int index)
+{
+    ui->RawRx_syncMsBox->setEnabled(index == FileXceiver::SyncPeriodically);
 }
 
 void FileTab::on_checksumButton_clicked()
@@ -170,15 +216,131 @@ void FileTab::dragEnterEvent(QDragEnterEvent *event)
     QList<QUrl> urlList = event->mimeData()->urls();
     if(urlList.size() == 1 && !Util::getValidLocalFilename(urlList).isEmpty())
         event->acceptProposedAction();
+    // multiple files or a folder, for the queue
+    else if(ui->sendModeButton->isChecked() && !m_working && !urlList.isEmpty() && urlList.first().isLocalFile())
+        event->acceptProposedAction();
 }
 
 void FileTab::dropEvent(QDropEvent *event)
 {
-    QString filename = Util::getValidLocalFilename(event->mimeData()->urls());
+    QList<QUrl> urlList = event->mimeData()->urls();
+    if(urlList.size() > 1 || (urlList.size() == 1 && QFileInfo(urlList.first().toLocalFile()).isDir()))
+    {
+        for(auto url : urlList)
+        {
+            if(url.isLocalFile())
+                addToQueue(url.toLocalFile());
+        }
+        return;
+    }
+    QString filename = Util::getValidLocalFilename(urlList);
     if(!filename.isEmpty())
         onFilePathSet(filename);
 }
 
+void FileTab::addToQueue(const QString& path)
+{
+    QStringList files;
+    if(QFileInfo(path).isDir())
+    {
+        QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+        while(it.hasNext())
+            files.append(it.next());
+        files.sort();
+    }
+    else if(QFileInfo(path).isFile())
+        files.append(path);
+    for(auto file : files)
+    {
+        QListWidgetItem* item = new QListWidgetItem(file, ui->queueList);
+        item->setData(Qt::UserRole, file);
+    }
+    updateFileSize();
+}
+
+QStringList FileTab::transmitFileList()
+{
+    QStringList files;
+    for(int i = 0; i < ui->queueList->count(); i++)
+        files.append(ui->queueList->item(i)->data(Qt::UserRole).toString());
+    if(files.isEmpty())
+        files.append(ui->filePathEdit->text());
+    return files;
+}
+
+QString FileTab::speedText(qint64 size, qint64 elapsed)
+{
+    return QLocale(QLocale::English).toString(size * 1000.0 / qMax(elapsed, 1LL) / 1024.0, 'f', 1) + " KiB/s";
+}
+
+void FileTab::on_queueAddButton_clicked()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this);
+    for(auto file : files)
+        addToQueue(file);
+}
+
+void FileTab::on_queueAddDirButton_clicked()
+{
+    QString dir = QFileDialog::getExistingDirectory(this);
+    if(!dir.isEmpty())
+        addToQueue(dir);
+}
+
+void FileTab::on_queueRemoveButton_clicked()
+{
+    qDeleteAll(ui->queueList->selectedItems());
+    updateFileSize();
+}
+
+void FileTab::on_queueClearButton_clicked()
+{
+    ui->queueList->clear();
+    updateFileSize();
+}
+
+void FileTab::on_pauseButton_clicked()
+{
+    m_paused = !m_paused;
+    ui->pauseButton->setText(m_paused ? tr("Resume") : tr("Pause"));
+    QMetaObject::invokeMethod(m_fileXceiver, "setPaused", Qt::QueuedConnection, Q_ARG(bool, m_paused));
+    showMessage(m_paused ? tr("Paused") : tr("Resumed"));
+}
+
+void FileTab::onFileStarted(const QString& filename, qint64 size)
+{
+    Q_UNUSED(size)
+    if(!m_working)
+        return;
+    showMessage(tr("Sending") + " " + filename);
+    for(int i = 0; i < ui->queueList->count(); i++)
+    {
+        if(ui->queueList->item(i)->data(Qt::UserRole).toString() == filename)
+        {
+            ui->queueList->setCurrentRow(i);
+            break;
+        }
+    }
+}
+
+void FileTab::onFileFinished(const QString& filename, qint64 size, qint64 elapsed)
+{
+    showMessage(tr("Sent") + " " + filename + ", " + QLocale(QLocale::English).toString(size) + " Bytes, " + speedText(size, elapsed));
+}
+
+void FileTab::onFileChecksumReady(const QString& filename, quint64 checksum)
+{
+    QString checksumText = QString("%1").arg(checksum, 8, 16, QLatin1Char('0'));
+    for(int i = 0; i < ui->queueList->count(); i++)
+    {
+        QListWidgetItem* item = ui->queueList->item(i);
+        if(item->data(Qt::UserRole).toString() == filename)
+            item->setText(filename + "  (CRC32: " + checksumText + ")");
+    }
+    if(ui->queueList->count() == 0 && filename == ui->filePathEdit->text())
+        ui->checksumLabel->setText(checksumText);
+}
+
 void FileTab::showUpTabHelper(int id)
 {
     emit showUpTab(id);
@@ -221,17 +383,44 @@ void FileTab::on_startStopButton_clicked()
     if(!m_working)
     {
         // precheck
-        if(ui->receiveModeButton->isChecked() && QFileInfo::exists(ui->filePathEdit->text()))
+        // YMODEM, ZMODEM and Chunked take the file name from the sender
+        bool batch = (currentProtocol() == FileXceiver::YModemProtocol || currentProtocol() == FileXceiver::ZModemProtocol || currentProtocol() == FileXceiver::ChunkedProtocol);
+        if(ui->receiveModeButton->isChecked() && !batch && QFileInfo::exists(ui->filePathEdit->text()))
         {
             if(QMessageBox::warning(this, tr("Receive"), tr("File already exists\nContinue?"), QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::No)
                 return;
         }
+        qint64 expectedChecksum = -1;
+        if(ui->receiveModeButton->isChecked() && currentProtocol() == FileXceiver::RawProtocol && ui->RawRx_autostopByteButton->isChecked() && ui->RawRx_verifyBox->isChecked())
+        {
+            bool ok;
+            expectedChecksum = ui->RawRx_verifyEdit->text().toLongLong(&ok, 16);
+            if(!ok || expectedChecksum < 0 || expectedChecksum > 0xFFFFFFFFLL)
+            {
+                QMessageBox::warning(this, tr("Receive"), tr("Invalid CRC-32 value"));
+                return;
+            }
+        }
 
 
         ui->progressBar->reset();
         m_handledSize = 0;
         QMetaObject::invokeMethod(m_fileXceiver, "setProtocol", Qt::QueuedConnection, Q_ARG(FileXceiver::Protocol, currentProtocol()));
         updateFileSize();
+        if(currentProtocol() != FileXceiver::RawProtocol)
+        {
+            FileProtocol::Argument arg;
+            arg.timeout = qMax(ui->Modem_timeoutBox->currentText().toInt(), 1) * 1000;
+            if(currentProtocol() == FileXceiver::ChunkedProtocol)
+            {
+                arg.window = qMax(ui->Chunk_roundBox->currentText().toLongLong(), 0LL);
+                arg.blockSize = qBound(64LL, ui->Chunk_blockBox->currentText().toLongLong(), 65536LL);
+            }
+            else
+                arg.window = qMax(ui->ZModem_windowBox->currentText().toLongLong(), 0LL);
+            arg.resume = ui->ZModem_resumeBox->isChecked();
+            QMetaObject::invokeMethod(m_fileXceiver, "setModemArgument", Qt::QueuedConnection, Q_ARG(FileProtocol::Argument, arg));
+        }
 
         if(ui->sendModeButton->isChecked())
         {
@@ -242,9 +431,11 @@ void FileTab::on_startStopButton_clicked()
                 FileXceiver::ThrottleArgument arg;
                 arg.waitTime = waitTime;
                 arg.batchByteNum = batchByteNum;
+                arg.highWatermark = qMax(ui->RawTx_highWatermarkBox->currentText().toLongLong(), 1LL);
+                arg.lowWatermark = qBound(0LL, ui->RawTx_lowWatermarkBox->currentText().toLongLong(), (long long)arg.highWatermark - 1);
                 QMetaObject::invokeMethod(m_fileXceiver, "setThrottleArgument", Qt::QueuedConnection, Q_ARG(FileXceiver::ThrottleArgument, arg));
             }
-            QMetaObject::invokeMethod(m_fileXceiver, "startTransmit", Qt::QueuedConnection, Q_ARG(QString, ui->filePathEdit->text()));
+            QMetaObject::invokeMethod(m_fileXceiver, "startQueue", Qt::QueuedConnection, Q_ARG(QStringList, transmitFileList()));
         }
         else
         {
@@ -252,8 +443,15 @@ void FileTab::on_startStopButton_clicked()
             {
                 qsizetype num = ui->RawRx_autostopNoneButton->isChecked() ? -1 : ui->RawRx_autostopByteBox->currentText().toLongLong();
                 QMetaObject::invokeMethod(m_fileXceiver, "setAutostop", Qt::QueuedConnection, Q_ARG(qsizetype, num));
-                QMetaObject::invokeMethod(m_fileXceiver, "startReceive", Qt::QueuedConnection, Q_ARG(QString, ui->filePathEdit->text()));
+                FileXceiver::WriterArgument arg;
+                arg.bufferSize = qMax(ui->RawRx_bufferBox->currentText().toLongLong(), 1LL);
+                arg.syncPolicy = (FileXceiver::SyncPolicy)ui->RawRx_syncBox->currentIndex();
+                arg.syncInterval = qMax(ui->RawRx_syncMsBox->currentText().toInt(), 1);
+                QMetaObject::invokeMethod(m_fileXceiver, "setWriterArgument", Qt::QueuedConnection, Q_ARG(FileXceiver::WriterArgument, arg));
+                QMetaObject::invokeMethod(m_fileXceiver, "setExpectedChecksum", Qt::QueuedConnection, Q_ARG(qint64, expectedChecksum));
+                ui->checksumLabel->clear(); // show the running checksum of the received data
             }
+            QMetaObject::invokeMethod(m_fileXceiver, "startReceive", Qt::QueuedConnection, Q_ARG(QString, ui->filePathEdit->text()));
         }
     }
     // "Stop" button
@@ -288,6 +486,26 @@ bool FileTab::receiving()
     return (ui->receiveModeButton->isChecked() && m_working);
 }
 
+bool FileTab::transmitting()
+{
+    return (ui->sendModeButton->isChecked() && m_working);
+}
+
+bool FileTab::protocolRunning()
+{
+    return (m_working && currentProtocol() != FileXceiver::RawProtocol);
+}
+
+bool FileTab::resumable()
+{
+    return (m_working && currentProtocol() == FileXceiver::ChunkedProtocol);
+}
+
+bool FileTab::TxRecordingEnabled()
+{
+    return ui->RawTx_recordBox->isChecked();
+}
+
 void FileTab::showMessage(const QString& msg)
 {
     ui->statusEdit->appendPlainText(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") + " " + msg);
@@ -299,6 +517,17 @@ void FileTab::onFinished()
     {
         stop();
         showMessage(tr("Finished"));
+        if(ui->sendModeButton->isChecked() && ui->queueList->count() > 1)
+            showMessage(tr("Total") + ": " + QLocale(QLocale::English).toString(m_handledSize) + " Bytes, " + speedText(m_handledSize, m_queueTimer.elapsed()));
+    }
+}
+
+void FileTab::onXceiverError(const QString& info)
+{
+    if(m_working)
+    {
+        stop();
+        showMessage(tr("Error") + ": " + info);
     }
 }
 
@@ -307,9 +536,13 @@ void FileTab::onStartResultArrived(bool result)
     m_working = result;
     if(result)
     {
-        if(ui->receiveModeButton->isChecked() && currentProtocol() == FileXceiver::RawProtocol && ui->RawRx_autostopNoneButton->isChecked())
+        if(ui->receiveModeButton->isChecked() && (currentProtocol() != FileXceiver::RawProtocol || ui->RawRx_autostopNoneButton->isChecked()))
             ui->progressBar->setMaximum(0);
         setParameterWidgetEnabled(false);
+        m_paused = false;
+        m_queueTimer.start();
+        ui->pauseButton->setText(tr("Pause"));
+        ui->pauseButton->setEnabled(ui->sendModeButton->isChecked());
         ui->startStopButton->setText(tr("Stop"));
         showMessage(tr("Started"));
     }
@@ -325,8 +558,10 @@ void FileTab::stop()
     m_working = false;
     QMetaObject::invokeMethod(m_fileXceiver, "stop", Qt::QueuedConnection);
     ui->startStopButton->setText(tr("Start"));
+    ui->pauseButton->setText(tr("Pause"));
+    ui->pauseButton->setEnabled(false);
     setParameterWidgetEnabled(true);
-    ui->progressBar->setMaximum(100); // for Raw receive
+    ui->progressBar->setMaximum(100); // for receiving without a known size
 }
 
 void FileTab::updateFileSize()
@@ -344,7 +579,9 @@ void FileTab::updateFileSize()
     }
     else
     {
-        m_fileSize = QFileInfo(ui->filePathEdit->text()).size();
+        m_fileSize = 0;
+        for(auto file : transmitFileList())
+            m_fileSize += QFileInfo(file).size();
     }
 
     if(m_fileSize == -1)
@@ -360,6 +597,7 @@ void FileTab::setParameterWidgetEnabled(bool state)
     ui->filePathEdit->setEnabled(state);
     ui->fileBrowseButton->setEnabled(state);
     ui->checksumButton->setEnabled(state);
+    ui->queueWidget->setEnabled(state);
 }
 
 FileXceiver::Protocol FileTab::currentProtocol()
@@ -380,21 +618,16 @@ void FileTab::on_tipsBackButton_clicked()
 
 void FileTab::onModeProtocolChanged()
 {
-    QWidget* widget = ui->protoParamWidget->currentWidget();
-    if(ui->sendModeButton->isChecked())
-    {
-        if(currentProtocol() == FileXceiver::RawProtocol)
-        {
-            widget = ui->rawTxParamWidget;
-        }
-    }
+    QWidget* widget;
+    ui->zmodemParamWidget->setVisible(currentProtocol() == FileXceiver::ZModemProtocol);
+    ui->chunkParamWidget->setVisible(currentProtocol() == FileXceiver::ChunkedProtocol);
+    ui->queueWidget->setVisible(ui->sendModeButton->isChecked());
+    if(currentProtocol() != FileXceiver::RawProtocol)
+        widget = ui->modemParamWidget;
+    else if(ui->sendModeButton->isChecked())
+        widget = ui->rawTxParamWidget;
     else
-    {
-        if(currentProtocol() == FileXceiver::RawProtocol)
-        {
-            widget = ui->rawRxParamWidget;
-        }
-    }
+        widget = ui->rawRxParamWidget;
     ui->protoParamWidget->setCurrentWidget(widget);
 }
 
@@ -414,10 +647,24 @@ void FileTab::loadPreference()
     ui->RawTx_throttleByteBox->setCurrentText(m_settings->value("RawTx_throttleByteNum", "1048576").toString());
     ui->RawTx_throttleMsBox->setCurrentText(m_settings->value("RawTx_throttleTimeMs", "0").toString());
     ui->RawTx_throttleWaitMsBox->setCurrentText(m_settings->value("RawTx_throttleWaitMs", "20").toString());
+    ui->RawTx_lowWatermarkBox->setCurrentText(m_settings->value("RawTx_lowWatermark", "8192").toString());
+    ui->RawTx_highWatermarkBox->setCurrentText(m_settings->value("RawTx_highWatermark", "32768").toString());
+    ui->RawTx_recordBox->setChecked(m_settings->value("RawTx_record", true).toBool());
 
     ui->RawRx_autostopNoneButton->setChecked(!(m_settings->value("RawTx_autostopEnabled", false).toBool()));
     ui->RawRx_autostopByteButton->setChecked(m_settings->value("RawTx_autostopEnabled", false).toBool());
     ui->RawRx_autostopByteBox->setCurrentText(m_settings->value("RawTx_autostopByteNum", "1048576").toString());
+    ui->RawRx_bufferBox->setCurrentText(m_settings->value("RawRx_bufferSize", "1048576").toString());
+    ui->RawRx_syncBox->setCurrentIndex(m_settings->value("RawRx_syncPolicy", FileXceiver::SyncOnStop).toInt());
+    ui->RawRx_syncMsBox->setCurrentText(m_settings->value("RawRx_syncMs", "1000").toString());
+    ui->RawRx_verifyBox->setChecked(m_settings->value("RawRx_verify", false).toBool());
+    ui->RawRx_verifyEdit->setText(m_settings->value("RawRx_expectedChecksum", "").toString());
+
+    ui->Modem_timeoutBox->setCurrentText(m_settings->value("Modem_timeout", "10").toString());
+    ui->ZModem_windowBox->setCurrentText(m_settings->value("ZModem_window", "65536").toString());
+    ui->ZModem_resumeBox->setChecked(m_settings->value("ZModem_resume", false).toBool());
+    ui->Chunk_blockBox->setCurrentText(m_settings->value("Chunk_blockSize", "4096").toString());
+    ui->Chunk_roundBox->setCurrentText(m_settings->value("Chunk_roundSize", "65536").toString());
 
     ui->filePathEdit->setText(m_settings->value("FilePath", "").toString());
     m_settings->endGroup();
@@ -441,9 +688,23 @@ void FileTab::saveFilePreference()
     m_settings->setValue("RawTx_throttleByteNum", ui->RawTx_throttleByteBox->currentText());
     m_settings->setValue("RawTx_throttleTimeMs", ui->RawTx_throttleMsBox->currentText());
     m_settings->setValue("RawTx_throttleWaitMs", ui->RawTx_throttleWaitMsBox->currentText());
+    m_settings->setValue("RawTx_lowWatermark", ui->RawTx_lowWatermarkBox->currentText());
+    m_settings->setValue("RawTx_highWatermark", ui->RawTx_highWatermarkBox->currentText());
+    m_settings->setValue("RawTx_record", ui->RawTx_recordBox->isChecked());
 
     m_settings->setValue("RawTx_autostopEnabled", ui->RawRx_autostopByteButton->isChecked());
     m_settings->setValue("RawTx_autostopByteNum", ui->RawRx_autostopByteBox->currentText());
+    m_settings->setValue("RawRx_bufferSize", ui->RawRx_bufferBox->currentText());
+    m_settings->setValue("RawRx_syncPolicy", ui->RawRx_syncBox->currentIndex());
+    m_settings->setValue("RawRx_syncMs", ui->RawRx_syncMsBox->currentText());
+    m_settings->setValue("RawRx_verify", ui->RawRx_verifyBox->isChecked());
+    m_settings->setValue("RawRx_expectedChecksum", ui->RawRx_verifyEdit->text());
+
+    m_settings->setValue("Modem_timeout", ui->Modem_timeoutBox->currentText());
+    m_settings->setValue("ZModem_window", ui->ZModem_windowBox->currentText());
+    m_settings->setValue("ZModem_resume", ui->ZModem_resumeBox->isChecked());
+    m_settings->setValue("Chunk_blockSize", ui->Chunk_blockBox->currentText());
+    m_settings->setValue("Chunk_roundSize", ui->Chunk_roundBox->currentText());
 
     m_settings->setValue("FilePath", ui->filePathEdit->text());
     m_settings->endGroup();
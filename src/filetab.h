@@ -5,6 +5,7 @@
 #include <QRadioButton>
 #include <QThread>
 #include <QIntValidator>
+#include <QElapsedTimer>
 
 #ifdef Q_OS_ANDROID
 #include <QAndroidJniEnvironment>
@@ -31,13 +32,21 @@ public:
     void initSettings();
     FileXceiver* fileXceiver();
     bool receiving();
+    bool transmitting();
+    bool protocolRunning();
+    bool resumable();
+    bool TxRecordingEnabled();
 public slots:
     void onChecksumUpdated(quint64 checksum);
     void onChecksumError(AsyncCRC::CRCFileError error);
     void onDataTransmitted(qsizetype num);
     void onDataReceived(qsizetype num);
     void onFinished();
+    void onXceiverError(const QString& info);
     void onStartResultArrived(bool result);
+    void onFileStarted(const QString& filename, qint64 size);
+    void onFileFinished(const QString& filename, qint64 size, qint64 elapsed);
+    void onFileChecksumReady(const QString& filename, quint64 checksum);
     void stop();
 protected:
     void dragEnterEvent(QDragEnterEvent *event) override;
@@ -47,12 +56,20 @@ private slots:
 
     void on_RawTx_throttleGrp_buttonClicked(QAbstractButton *button);
     void on_RawRx_autostopGrp_buttonClicked(QAbstractButton *button);
+    void on_RawRx_syncBox_currentIndexChanged(int index);
+    void on_RawRx_verifyBox_toggled(bool checked);
 
     void on_checksumButton_clicked();
 
     void on_clearButton_clicked();
 
     void on_startStopButton_clicked();
+    void on_pauseButton_clicked();
+
+    void on_queueAddButton_clicked();
+    void on_queueAddDirButton_clicked();
+    void on_queueRemoveButton_clicked();
+    void on_queueClearButton_clicked();
 
     void showMessage(const QString &msg);
     void on_tipsButton_clicked();
@@ -67,11 +84,11 @@ private:
 
     qsizetype m_fileSize = -1;
     qsizetype m_handledSize = -1;
-    QThread* m_checksumThread = nullptr;
     AsyncCRC* m_checksumCalc = nullptr;
-    QThread* m_fileXceiverThread = nullptr;
     FileXceiver* m_fileXceiver = nullptr;
     bool m_working = false;
+    bool m_paused = false;
+    QElapsedTimer m_queueTimer;
     static FileTab* m_currInstance;
     MySettings *m_settings;
     QIntValidator *m_intValidator;
@@ -80,6 +97,9 @@ private:
     void onFilePathSet(const QString &path);
     void updateFileSize();
     void setParameterWidgetEnabled(bool state);
+    void addToQueue(const QString& path);
+    QStringList transmitFileList();
+    QString speedText(qint64 size, qint64 elapsed);
 
 #ifdef Q_OS_ANDROID
     static void onSharedFileReceived(JNIEnv *env, jobject thiz, jstring text);
@@ -1,7 +1,17 @@
 #include "filexceiver.h"
+#include "xymodem.h"
+#include "zmodem.h"
+#include "chunkprotocol.h"
+#include "util.h"
+#include "tracer.h"
+#include "pipelinemetrics.h"
 
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QFileInfo>
+
+// for the slices refused by the receiver
+static const int requeueRetryInterval = 10;
 
 FileXceiver::FileXceiver(QObject *parent)
     : QObject{parent}
@@ -9,26 +19,97 @@ FileXceiver::FileXceiver(QObject *parent)
     qRegisterMetaType<qsizetype>("qsizetype"); // qsizetype is an alias, so the typeName is compulsory
     qRegisterMetaType<FileXceiver::Protocol>();
     qRegisterMetaType<FileXceiver::ThrottleArgument>();
+    qRegisterMetaType<FileXceiver::WriterArgument>();
+    qRegisterMetaType<FileProtocol::Argument>();
     m_file.setParent(this); // for moveToThread()
+
+    m_writer = new AsyncFileWriter();
+    m_writer->moveToThread(Util::workerThread(Util::WriterWorker));
+    connect(m_writer, &AsyncFileWriter::written, this, &FileXceiver::dataReceived);
+    connect(m_writer, &AsyncFileWriter::error, this, &FileXceiver::error);
+    connect(m_writer, &AsyncFileWriter::closed, this, &FileXceiver::onWriterClosed);
+
+    m_rawTimer = new QTimer(this);
+    m_rawTimer->setSingleShot(true);
+    connect(m_rawTimer, &QTimer::timeout, this, [ = ]
+    {
+        m_rawBlocked = false;
+        RawTransmitProgress();
+    });
+    m_handoffTimer = new QTimer(this);
+    m_handoffTimer->setInterval(100);
+    connect(m_handoffTimer, &QTimer::timeout, this, &FileXceiver::handoffBuffer);
+    m_syncTimer = new QTimer(this);
+    connect(m_syncTimer, &QTimer::timeout, m_writer, &AsyncFileWriter::sync);
+
+    m_protocolChecksum = new AsyncCRC(32, 0x04C11DB7ULL, 0xFFFFFFFFULL, true, true, 0xFFFFFFFFULL); // CRC-32
+    m_protocolChecksum->setNotify(true);
+    m_protocolChecksum->moveToThread(Util::workerThread(Util::ChecksumWorker));
+    connect(m_protocolChecksum, &AsyncCRC::result, this, &FileXceiver::checksumUpdated);
 }
 
 FileXceiver::~FileXceiver()
 {
     stop();
+    // the worker threads are shared, delete the workers after the queued data is handled
+    QMetaObject::invokeMethod(m_writer, [ = ]()
+    {
+        delete m_writer;
+    }, Qt::BlockingQueuedConnection);
+    QMetaObject::invokeMethod(m_protocolChecksum, [ = ]()
+    {
+        delete m_protocolChecksum;
+    }, Qt::BlockingQueuedConnection);
+    // the receiver is gone, nobody will release the slices
+    delete m_mapFile;
+    qDeleteAll(m_retiredMapFiles);
+}
+
+void FileXceiver::setMetrics(PipelineMetrics* metrics)
+{
+    m_metrics = metrics;
 }
 
 bool FileXceiver::startTransmit(const QString& filename)
 {
-    m_file.close();
-    m_file.setFileName(filename);
-    if(!m_file.open(QFile::ReadOnly))
+    return startQueue(QStringList(filename));
+}
+
+// the files are sent back-to-back
+// for batch protocols(YMODEM, ZMODEM), they are sent in one session
+bool FileXceiver::startQueue(const QStringList& files)
+{
+    m_queue = files;
+    m_queueIndex = -1;
+    m_queueFileName.clear();
+    m_heldFiles.clear();
+    m_paused = false;
+    m_rawStalled = false;
+    clearRequeuedSlices();
+    if(files.isEmpty())
+    {
+        emit startResult(false);
+        return false;
+    }
+    if(m_protocol != RawProtocol)
+    {
+        bool result = startProtocol(true, files.first(), files.mid(1));
+        emit startResult(result);
+        if(result)
+            onQueueFileStarted(files.first(), QFileInfo(files.first()).size());
+        return result;
+    }
+
+    if(!openRawFile(files.first()))
     {
         emit startResult(false);
         return false;
     }
 
     m_isRunning = true;
+    m_isTransmitting = true;
     m_handledNum = 0;
+    m_deviceBacklog = 0;
     if(m_protocol == RawProtocol)
     {
         if(m_throttleArgument.waitTime != -1)
@@ -42,24 +123,165 @@ bool FileXceiver::startTransmit(const QString& filename)
             m_waitTime = 0;
         }
         m_speedAdjustTimer.start();
-        QTimer::singleShot(0, this, &FileXceiver::RawTransmitProgress);
+        m_rawTimer->start(0);
     }
     emit startResult(true);
+    onQueueFileStarted(files.first(), m_fileSize);
     return true;
 }
 
-bool FileXceiver::startReceive(const QString &filename)
+bool FileXceiver::openRawFile(const QString& filename)
 {
     m_file.close();
-    m_file.setFileName(filename);
-    if(!m_file.open(QFile::WriteOnly | QFile::Unbuffered))
+    retireMap();
+    // use read() if the file cannot be mapped(empty file, sequential device, etc.)
+    if(!mapFile(filename))
+    {
+        m_file.setFileName(filename);
+        if(!m_file.open(QFile::ReadOnly))
+            return false;
+        m_fileSize = m_file.size();
+    }
+    return true;
+}
+
+bool FileXceiver::nextRawFile()
+{
+    while(m_queueIndex + 1 < m_queue.size())
+    {
+        QString filename = m_queue[m_queueIndex + 1];
+        if(openRawFile(filename))
+        {
+            m_handledNum = 0;
+            onQueueFileStarted(filename, m_fileSize);
+            return true;
+        }
+        m_queueIndex++;
+        emit message(tr("Failed to open") + " " + filename);
+    }
+    return false;
+}
+
+void FileXceiver::onQueueFileStarted(const QString& filename, qint64 size)
+{
+    finishQueueFile();
+    int index = m_queue.indexOf(filename, m_queueIndex + 1);
+    if(index != -1)
+        m_queueIndex = index;
+    m_queueFileName = filename;
+    m_queueFileSize = size;
+    m_queueFileTimer.start();
+    emit fileStarted(filename, size);
+    if(m_queueIndex == 0)
+        calcFileChecksum(filename);
+    // calculate the checksum of the next file while this one is being sent
+    if(m_queueIndex + 1 < m_queue.size())
+        calcFileChecksum(m_queue[m_queueIndex + 1]);
+}
+
+void FileXceiver::finishQueueFile()
+{
+    if(m_queueFileName.isEmpty())
+        return;
+    emit fileFinished(m_queueFileName, m_queueFileSize, m_queueFileTimer.elapsed());
+    m_queueFileName.clear();
+}
+
+void FileXceiver::calcFileChecksum(const QString& filename)
+{
+    QMetaObject::invokeMethod(m_protocolChecksum, [ = ]()
+    {
+        // use a separate one, the running checksum of receiving is not touched
+        AsyncCRC crc(32, 0x04C11DB7ULL, 0xFFFFFFFFULL, true, true, 0xFFFFFFFFULL); // CRC-32
+        bool ok = true;
+        connect(&crc, &AsyncCRC::fileError, [&ok]()
+        {
+            ok = false;
+        });
+        crc.loadFile(filename);
+        if(ok)
+            emit fileChecksumReady(filename, crc.getResult());
+    }, Qt::QueuedConnection);
+}
+
+// Raw: pause immediately
+// protocols: the session can't be held, pause after the current file
+void FileXceiver::setPaused(bool paused)
+{
+    if(!m_isRunning || !m_isTransmitting || paused == m_paused)
+        return;
+    m_paused = paused;
+    if(m_protocol == RawProtocol)
+    {
+        if(!paused && m_rawStalled)
+        {
+            m_rawStalled = false;
+            m_rawTimer->start(0);
+        }
+    }
+    else if(paused)
+    {
+        m_heldFiles = m_protocolEngine->takePendingFiles() + m_heldFiles;
+        if(m_protocolEngine->isRunning() && !m_heldFiles.isEmpty())
+            emit message(tr("The queue will be paused after the current file"));
+    }
+    else if(m_protocolEngine->isRunning())
+    {
+        m_protocolEngine->setPendingFiles(m_heldFiles);
+        m_heldFiles.clear();
+    }
+    else
+        QTimer::singleShot(0, this, &FileXceiver::startNextSession);
+}
+
+void FileXceiver::startNextSession()
+{
+    if(!m_isRunning || m_paused)
+        return;
+    while(!m_heldFiles.isEmpty())
+    {
+        QString filename = m_heldFiles.takeFirst();
+        if(startProtocol(true, filename, m_heldFiles))
+        {
+            m_heldFiles.clear();
+            onQueueFileStarted(filename, QFileInfo(filename).size());
+            return;
+        }
+        emit message(tr("Failed to open") + " " + filename);
+    }
+    finishQueueFile();
+    m_isRunning = false;
+    emit finished();
+}
+
+bool FileXceiver::startReceive(const QString &filename)
+{
+    if(m_protocol != RawProtocol)
+    {
+        bool result = startProtocol(false, filename);
+        emit startResult(result);
+        return result;
+    }
+
+    bool result;
+    m_writeBuf.clear();
+    m_finishPending = false;
+    m_verifyPending = false;
+    // the previous close() is queued before open(), so the data will not be mixed
+    QMetaObject::invokeMethod(m_writer, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, result), Q_ARG(QString, filename));
+    if(!result)
     {
         emit startResult(false);
         return false;
     }
 
     m_isRunning = true;
+    m_isTransmitting = false;
     m_handledNum = 0;
+    QMetaObject::invokeMethod(m_protocolChecksum, "reset", Qt::QueuedConnection);
+    m_handoffTimer->start();
+    if(m_writerArgument.syncPolicy == SyncPeriodically)
+        m_syncTimer->start(m_writerArgument.syncInterval);
     emit startResult(true);
     return true;
 }
@@ -79,31 +301,285 @@ void FileXceiver::setAutostop(qsizetype num)
     m_expectedNum = num;
 }
 
+void FileXceiver::setWriterArgument(WriterArgument arg)
+{
+    m_writerArgument = arg;
+}
+
+void FileXceiver::setModemArgument(FileProtocol::Argument arg)
+{
+    m_modemArgument = arg;
+}
+
+// compared with the CRC-32 of the received data at autostop
+void FileXceiver::setExpectedChecksum(qint64 checksum)
+{
+    m_expectedChecksum = checksum;
+}
+
+bool FileXceiver::startProtocol(bool transmit, const QString &path, const QStringList &pendingFiles)
+{
+    // the engine is idle there, it's safe to delete it
+    delete m_protocolEngine;
+    if(m_protocol == ChunkedProtocol)
+        m_protocolEngine = new ChunkProtocol(this);
+    else if(m_protocol == ZModemProtocol)
+        m_protocolEngine = new ZModem(this);
+    else if(m_protocol == YModemProtocol)
+        m_protocolEngine = new XYModem(XYModem::YModem, this);
+    else if(m_protocol == XModem1KProtocol)
+        m_protocolEngine = new XYModem(XYModem::XModem1K, this);
+    else
+        m_protocolEngine = new XYModem(XYModem::XModem, this);
+    m_protocolEngine->setArgument(m_modemArgument);
+    connect(m_protocolEngine, &FileProtocol::send, this, &FileXceiver::send);
+    connect(m_protocolEngine, &FileProtocol::dataTransmitted, this, &FileXceiver::dataTransmitted);
+    connect(m_protocolEngine, &FileProtocol::dataReceived, this, &FileXceiver::dataReceived);
+    connect(m_protocolEngine, &FileProtocol::message, this, &FileXceiver::message);
+    connect(m_protocolEngine, &FileProtocol::finished, this, &FileXceiver::onProtocolFinished);
+    connect(m_protocolEngine, &FileProtocol::error, this, &FileXceiver::onProtocolError);
+    connect(m_protocolEngine, &FileProtocol::fileStarted, this, &FileXceiver::onQueueFileStarted);
+
+    m_isTransmitting = transmit;
+    m_handledNum = 0;
+    m_protocolEngine->setPendingFiles(pendingFiles);
+    m_isRunning = transmit ? m_protocolEngine->startTransmit(path) : m_protocolEngine->startReceive(path);
+    return m_isRunning;
+}
+
+void FileXceiver::onReconnected()
+{
+    if(m_isRunning && m_protocolEngine != nullptr && m_protocol != RawProtocol)
+        m_protocolEngine->onReconnected();
+}
+
+void FileXceiver::onProtocolFinished()
+{
+    if(m_isTransmitting)
+    {
+        // the non-batch protocols leave the rest of the queue
+        m_heldFiles += m_protocolEngine->takePendingFiles();
+        if(!m_heldFiles.isEmpty())
+        {
+            // the engine is emitting the signal, don't delete it there
+            QTimer::singleShot(0, this, &FileXceiver::startNextSession);
+            return;
+        }
+        finishQueueFile();
+    }
+    m_isRunning = false;
+    emit finished();
+}
+
+void FileXceiver::onProtocolError(const QString &info)
+{
+    m_isRunning = false;
+    emit error(info);
+}
+
+// call it after the data from send() is handled
+void FileXceiver::releaseSlice(qsizetype num)
+{
+    m_pendingSliceNum -= num;
+    if(m_pendingSliceNum > 0)
+    {
+        checkBacklog();
+        return;
+    }
+    m_pendingSliceNum = 0;
+    // no slice is referenced now, unmap the retired files
+    qDeleteAll(m_retiredMapFiles);
+    m_retiredMapFiles.clear();
+    checkBacklog();
+}
+
+// the receiver couldn't write the whole slice(e.g. Lag_Block of the servers), send the rest later
+// call it before releaseSlice() of the same slice
+void FileXceiver::requeueSlice(const QByteArray& data)
+{
+    if(!m_isRunning || !m_isTransmitting || m_protocol != RawProtocol || data.isEmpty())
+        return;
+    // the slice stays referenced until it's sent again
+    m_pendingSliceNum += data.size();
+    m_requeuedNum += data.size();
+    m_requeuedSlices.append(data);
+    // retry when the device reports a write, or after a while if it never does
+    m_rawBlocked = true;
+    m_rawTimer->start(qMax(m_waitTime, (qsizetype)requeueRetryInterval));
+}
+
+void FileXceiver::clearRequeuedSlices()
+{
+    m_pendingSliceNum -= m_requeuedNum;
+    m_requeuedSlices.clear();
+    m_requeuedNum = 0;
+    m_rawBlocked = false;
+    m_rawFinishPending = false;
+    m_rawTimer->stop();
+}
+
+// enable it only if the connection emits bytesWritten()
+void FileXceiver::setBackpressureEnabled(bool enabled)
+{
+    m_backpressureEnabled = enabled;
+}
+
+// call it with Connection::bytesToWrite() after writing and on bytesWritten()
+void FileXceiver::setDeviceBacklog(qint64 num)
+{
+    m_deviceBacklog = num;
+    if(m_rawBlocked)
+    {
+        m_rawBlocked = false;
+        m_rawTimer->start(0);
+        return;
+    }
+    checkBacklog();
+}
+
+bool FileXceiver::isBackpressureMode()
+{
+    return m_backpressureEnabled && m_throttleArgument.waitTime == -1;
+}
+
+void FileXceiver::checkBacklog()
+{
+    if(!m_isRunning || !m_isTransmitting || m_protocol != RawProtocol || m_rawBlocked)
+        return;
+    // the slices in flight are settled, continue with the requeued ones
+    if(!m_requeuedSlices.isEmpty() || m_rawFinishPending)
+    {
+        if(m_pendingSliceNum <= m_requeuedNum)
+            m_rawTimer->start(0);
+        return;
+    }
+    if(!isBackpressureMode())
+        return;
+    if(m_pendingSliceNum + m_deviceBacklog <= m_throttleArgument.lowWatermark)
+        RawTransmitProgress();
+}
+
+bool FileXceiver::mapFile(const QString &filename)
+{
+    QFile* file = new QFile(filename);
+    if(file->open(QFile::ReadOnly) && file->size() > 0)
+        m_fileMap = file->map(0, file->size());
+    if(m_fileMap == nullptr)
+    {
+        delete file;
+        return false;
+    }
+    // the mapping is still valid after close()
+    m_fileSize = file->size();
+    file->close();
+    m_mapFile = file;
+    return true;
+}
+
+void FileXceiver::retireMap()
+{
+    if(m_mapFile == nullptr)
+        return;
+    // the slices might be queued in the receiver's thread
+    // QFile will unmap the file in its destructor
+    m_retiredMapFiles.append(m_mapFile);
+    m_mapFile = nullptr;
+    m_fileMap = nullptr;
+    releaseSlice(0);
+}
+
 void FileXceiver::newData(const QByteArray &data)
 {
+    TraceScope scope("FileXceiver::newData");
+    scope.setArg(data.size());
     if(!m_isRunning)
     {
         // emit signal?
         return;
     }
-    if(m_protocol == RawProtocol)
+    QElapsedTimer timer;
+    timer.start();
+    if(m_protocol != RawProtocol)
+    {
+        // the responses in send mode are handled there too
+        m_protocolEngine->newData(data);
+    }
+    else
     {
-        qsizetype num;
-        qsizetype limit = -1, currNum = -1;
+        qsizetype num = data.size();
         if(m_expectedNum != -1)
+            num = qMin(num, m_expectedNum - m_handledNum);
+        m_writeBuf.append(data.constData(), num);
+        m_handledNum += num;
+        // dataReceived() is emitted after the data is written
+        if(m_writeBuf.size() >= m_writerArgument.bufferSize)
+            handoffBuffer();
+        if(m_expectedNum != -1 && m_handledNum >= m_expectedNum)
         {
-            limit = m_expectedNum - m_handledNum;
-            currNum = limit < data.size() ? limit : data.size();
-            num = m_file.write(data.constData(), currNum);
+            m_finishPending = true;
+            closeWriter();
         }
-        else
-            num = m_file.write(data);
-        m_file.flush();
-        m_handledNum += num;
-        emit dataReceived(num);
-        if(m_expectedNum != -1 && currNum == limit)
-            emit finished();
     }
+    if(m_metrics != nullptr)
+        m_metrics->addConsumerTime(PipelineMetrics::FileXceiver, timer.nsecsElapsed());
+}
+
+void FileXceiver::handoffBuffer()
+{
+    if(m_writeBuf.isEmpty())
+        return;
+    TraceScope scope("FileXceiver::handoffBuffer");
+    scope.setArg(m_writeBuf.size());
+    // m_writeBuf is shared with the queued event, then detached
+    QMetaObject::invokeMethod(m_writer, "write", Qt::QueuedConnection, Q_ARG(QByteArray, m_writeBuf));
+    // the same buffer is shared with the checksum thread, no extra read from the disk
+    QMetaObject::invokeMethod(m_protocolChecksum, "addData", Qt::QueuedConnection, Q_ARG(QByteArray, m_writeBuf));
+    m_writeBuf = QByteArray();
+}
+
+void FileXceiver::closeWriter()
+{
+    m_isRunning = false;
+    m_handoffTimer->stop();
+    m_syncTimer->stop();
+    handoffBuffer();
+    QMetaObject::invokeMethod(m_writer, "close", Qt::QueuedConnection, Q_ARG(bool, m_writerArgument.syncPolicy != SyncNever));
+}
+
+void FileXceiver::onWriterClosed()
+{
+    if(!m_finishPending)
+        return;
+    m_finishPending = false;
+    if(m_expectedChecksum == -1)
+    {
+        emit finished();
+        return;
+    }
+    // the checksum thread handles the data in order, get the result after the queued data
+    m_verifyPending = true;
+    QMetaObject::invokeMethod(m_protocolChecksum, [ = ]()
+    {
+        quint64 checksum = m_protocolChecksum->getResult();
+        QMetaObject::invokeMethod(this, [ = ]()
+        {
+            verifyChecksum(checksum);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void FileXceiver::verifyChecksum(quint64 checksum)
+{
+    if(!m_verifyPending)
+        return;
+    m_verifyPending = false;
+    if(checksum == (quint64)m_expectedChecksum)
+    {
+        emit message(tr("Checksum matched"));
+        emit finished();
+    }
+    else
+        emit error(tr("Checksum mismatch") + ", " + tr("expected") + " " + QString("%1").arg(m_expectedChecksum, 8, 16, QLatin1Char('0')) + ", " + tr("got") + " " + QString("%1").arg(checksum, 8, 16, QLatin1Char('0')));
 }
 
 void FileXceiver::RawTransmitProgress()
@@ -113,11 +589,62 @@ void FileXceiver::RawTransmitProgress()
         // emit signal?
         return;
     }
-    QByteArray buf = m_file.read(m_batchSize);
+    if(m_paused)
+    {
+        m_rawStalled = true; // restarted by setPaused(false)
+        return;
+    }
+    if(isBackpressureMode())
+    {
+        // fill the buffer up to the high watermark, then wait for checkBacklog()
+        qint64 backlog = m_pendingSliceNum + m_deviceBacklog;
+        if(backlog >= m_throttleArgument.highWatermark)
+            return;
+        m_batchSize = m_throttleArgument.highWatermark - backlog;
+    }
+    TraceScope scope("FileXceiver::RawTransmitProgress");
+    if(!m_requeuedSlices.isEmpty())
+    {
+        // the slices in flight might be refused too, wait for them to keep the order
+        // restarted by checkBacklog()
+        if(m_pendingSliceNum > m_requeuedNum)
+            return;
+        // already counted in m_pendingSliceNum and dataTransmitted()
+        QByteArray buf = m_requeuedSlices.takeFirst();
+        m_requeuedNum -= buf.size();
+        scope.setArg(buf.length());
+        emit resending();
+        emit send(buf);
+        // continue the timer chain, the new data is refused as well if this slice is refused
+        if(m_requeuedSlices.isEmpty() && !m_rawFinishPending && !isBackpressureMode())
+            m_rawTimer->start(qMax(m_waitTime, (qsizetype)requeueRetryInterval));
+        return;
+    }
+    if(m_rawFinishPending)
+    {
+        if(m_pendingSliceNum > 0)
+            return;
+        m_rawFinishPending = false;
+        finishQueueFile();
+        m_isRunning = false;
+        emit finished();
+        return;
+    }
+    QByteArray buf;
+    if(m_fileMap != nullptr)
+    {
+        // no copy there, the slice points to the mapped file
+        qint64 len = qMin((qint64)m_batchSize, m_fileSize - m_handledNum);
+        buf = QByteArray::fromRawData((const char*)m_fileMap + m_handledNum, len);
+    }
+    else
+        buf = m_file.read(m_batchSize);
     m_handledNum += buf.length();
+    m_pendingSliceNum += buf.length();
+    scope.setArg(buf.length());
     emit send(buf);
     emit dataTransmitted(buf.length());
-    if(m_throttleArgument.waitTime == -1)
+    if(m_throttleArgument.waitTime == -1 && !isBackpressureMode())
     {
         qsizetype tick = m_speedAdjustTimer.restart();
         // expected responce time is 200ms
@@ -137,18 +664,44 @@ void FileXceiver::RawTransmitProgress()
             m_batchSize++; // m_batchSize != 0
         }
     }
-    if(!m_file.atEnd())
-        QTimer::singleShot(m_waitTime, this, &FileXceiver::RawTransmitProgress);
+    bool atEnd = (m_fileMap != nullptr) ? (m_handledNum >= m_fileSize) : m_file.atEnd();
+    if(!atEnd)
+    {
+        if(!isBackpressureMode())
+            m_rawTimer->start(m_waitTime);
+    }
+    else if(nextRawFile())
+    {
+        // no gap between the files, the backlog might be low already
+        m_rawTimer->start(isBackpressureMode() ? 0 : m_waitTime);
+    }
     else
     {
+        // finish after the receiver handles all slices, a part of them might be refused
+        m_rawFinishPending = true;
         m_file.close();
+        retireMap();
+        if(m_pendingSliceNum > 0)
+            return;
+        m_rawTimer->stop();
+        m_rawFinishPending = false;
+        finishQueueFile();
+        m_isRunning = false;
         emit finished();
     }
 }
 
 void FileXceiver::stop()
 {
+    if(m_isRunning && m_protocolEngine != nullptr && m_protocol != RawProtocol)
+        m_protocolEngine->stop(); // notify the peer
+    else if(m_isRunning && !m_isTransmitting)
+        closeWriter();
     m_isRunning = false;
-    m_file.close(); // for receiving
+    m_verifyPending = false;
+    m_heldFiles.clear();
+    clearRequeuedSlices();
+    m_file.close(); // for transmitting with read()
+    retireMap();
 }
 
@@ -5,8 +5,13 @@
 #include <QFile>
 #include <QElapsedTimer>
 #include <QThread>
+#include <QTimer>
 
 #include "asynccrc.h"
+#include "asyncfilewriter.h"
+#include "fileprotocol.h"
+
+class PipelineMetrics;
 
 class FileXceiver : public QObject
 {
@@ -16,6 +21,11 @@ public:
     enum Protocol
     {
         RawProtocol = 0,
+        XModemProtocol,
+        XModem1KProtocol,
+        YModemProtocol,
+        ZModemProtocol,
+        ChunkedProtocol,
     };
     Q_ENUM(Protocol)
 
@@ -26,17 +36,50 @@ public:
 
         qsizetype batchByteNum = -1;
         // qsizetype  batchTime = -1;
+
+        // for no throttle, if the connection reports its write progress
+        // stop sending at highWatermark, resume at lowWatermark
+        qsizetype lowWatermark = 8192;
+        qsizetype highWatermark = 32768;
+    };
+
+    enum SyncPolicy
+    {
+        SyncPeriodically = 0,
+        SyncOnStop,
+        SyncNever,
+    };
+    Q_ENUM(SyncPolicy)
+
+    struct WriterArgument
+    {
+        // the received data is written when the buffer is full or every 100ms
+        qsizetype bufferSize = 1024 * 1024;
+        SyncPolicy syncPolicy = SyncOnStop;
+        int syncInterval = 1000; // for SyncPeriodically
     };
 
     explicit FileXceiver(QObject *parent = nullptr);
     ~FileXceiver();
 
+    // call it before the thread receives any data, the counters are thread-safe
+    void setMetrics(PipelineMetrics* metrics);
     Q_INVOKABLE void stop();
     Q_INVOKABLE bool startTransmit(const QString &filename);
+    Q_INVOKABLE bool startQueue(const QStringList &files);
+    Q_INVOKABLE void setPaused(bool paused);
     Q_INVOKABLE bool startReceive(const QString &filename);
     Q_INVOKABLE void setProtocol(FileXceiver::Protocol p);
     Q_INVOKABLE void setThrottleArgument(FileXceiver::ThrottleArgument arg);
     Q_INVOKABLE void setAutostop(qsizetype num);
+    Q_INVOKABLE void setWriterArgument(FileXceiver::WriterArgument arg);
+    Q_INVOKABLE void setModemArgument(FileProtocol::Argument arg);
+    Q_INVOKABLE void setExpectedChecksum(qint64 checksum);
+    Q_INVOKABLE void releaseSlice(qsizetype num);
+    Q_INVOKABLE void requeueSlice(const QByteArray& data);
+    Q_INVOKABLE void setBackpressureEnabled(bool enabled);
+    Q_INVOKABLE void setDeviceBacklog(qint64 num);
+    Q_INVOKABLE void onReconnected();
 
 public slots:
     void newData(const QByteArray& data);
@@ -46,14 +89,72 @@ protected:
     qsizetype m_waitTime = 0;
     qsizetype m_expectedNum = -1; // -1: infinite
     QElapsedTimer m_speedAdjustTimer;
+    PipelineMetrics* m_metrics = nullptr;
 
     QFile m_file;
+    // for transmitting, the file is mapped and sent in read-only slices
+    QFile* m_mapFile = nullptr;
+    uchar* m_fileMap = nullptr;
+    qint64 m_fileSize = 0;
+    // bytes emitted by send() but not released by the receiver yet
+    qsizetype m_pendingSliceNum = 0;
+    QList<QFile*> m_retiredMapFiles;
+    // bytes written to the connection but not sent out yet
+    qint64 m_deviceBacklog = 0;
+    bool m_backpressureEnabled = false;
     bool m_isRunning = false;
+    bool m_isTransmitting = false;
+    // for receiving, the data is aggregated in m_writeBuf then written in the writer thread
+    AsyncFileWriter* m_writer;
+    QByteArray m_writeBuf;
+    QTimer* m_handoffTimer;
+    QTimer* m_syncTimer;
+    WriterArgument m_writerArgument;
+    bool m_finishPending = false; // emit finished() after the file is closed
+    // for transmitting multiple files
+    QStringList m_queue;
+    int m_queueIndex = -1; // the current file
+    QString m_queueFileName;
+    qint64 m_queueFileSize = 0;
+    QElapsedTimer m_queueFileTimer;
+    QStringList m_heldFiles; // the rest of the queue for the next protocol session
+    bool m_paused = false;
+    bool m_rawStalled = false; // RawTransmitProgress() returned because of pausing
+    // the single pending call of RawTransmitProgress()
+    QTimer* m_rawTimer;
+    // the parts refused by the receiver, sent again before the new data
+    QList<QByteArray> m_requeuedSlices;
+    qsizetype m_requeuedNum = 0;
+    bool m_rawBlocked = false; // wait for the device to drain after a refused write
+    bool m_rawFinishPending = false; // emit finished() after all slices are released
+    // for XMODEM/YMODEM/ZMODEM/Chunked
+    FileProtocol* m_protocolEngine = nullptr;
+    FileProtocol::Argument m_modemArgument;
     Protocol m_protocol = RawProtocol;
     ThrottleArgument m_throttleArgument;
+    // CRC-32 of the received data, calculated while the data is written
     AsyncCRC* m_protocolChecksum;
-    QThread* m_protocolChecksumThread;
+    qint64 m_expectedChecksum = -1; // -1: don't verify
+    bool m_verifyPending = false;
 
+    bool mapFile(const QString &filename);
+    void retireMap();
+    bool isBackpressureMode();
+    void checkBacklog();
+    void clearRequeuedSlices();
+    void handoffBuffer();
+    void closeWriter();
+    void onWriterClosed();
+    void verifyChecksum(quint64 checksum);
+    bool openRawFile(const QString& filename);
+    bool nextRawFile();
+    void onQueueFileStarted(const QString& filename, qint64 size);
+    void finishQueueFile();
+    void calcFileChecksum(const QString& filename);
+    void startNextSession();
+    bool startProtocol(bool transmit, const QString& path, const QStringList& pendingFiles = QStringList());
+    void onProtocolFinished();
+    void onProtocolError(const QString& info);
     void RawTransmitProgress();
     void RawReceiveProgress(const QByteArray& data);
 
@@ -61,12 +162,21 @@ signals:
     void dataTransmitted(qsizetype num);
     void dataReceived(qsizetype num);
     void send(const QByteArray& data);
+    // the receiver should accept the data again, the requeued slices follow
+    void resending();
     void finished();
     void startResult(bool result);
+    void error(const QString& info);
+    void message(const QString& msg);
+    void checksumUpdated(quint64 checksum);
+    void fileStarted(const QString& filename, qint64 size);
+    void fileFinished(const QString& filename, qint64 size, qint64 elapsed);
+    void fileChecksumReady(const QString& filename, quint64 checksum);
 };
 
 Q_DECLARE_METATYPE(qsizetype)
 Q_DECLARE_METATYPE(FileXceiver::Protocol)
 Q_DECLARE_METATYPE(FileXceiver::ThrottleArgument)
+Q_DECLARE_METATYPE(FileXceiver::WriterArgument)
 
 #endif // FILEXCEIVER_H
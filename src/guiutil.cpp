@@ -0,0 +1,65 @@
+#include "guiutil.h"
+
+#include "QDebug"
+#include <QGestureEvent>
+#include <QTouchEvent>
+#include <QContextMenuEvent>
+#include <QApplication>
+#include <QPlainTextEdit>
+#include <QLineEdit>
+#ifdef Q_OS_ANDROID
+#include <QtAndroid>
+#include <QAndroidJniEnvironment>
+#endif
+
+void GuiUtil::disableItem(QStandardItemModel* model, int id, bool enabled)
+{
+    if(model == nullptr)
+        return;
+    QStandardItem *item = model->item(id);
+    Qt::ItemFlags flags = item->flags();
+    flags.setFlag(Qt::ItemIsEnabled, enabled);
+    item->setFlags(flags);
+}
+
+
+#ifdef Q_OS_ANDROID
+void GuiUtil::showToast(const QString& message, bool isLong)
+{
+    // all the magic must happen on Android UI thread
+    // don't capture by reference there
+    QtAndroid::runOnAndroidThread([ = ]
+    {
+        QAndroidJniObject javaString = QAndroidJniObject::fromString(message);
+        QAndroidJniObject toast = QAndroidJniObject::callStaticObjectMethod("android/widget/Toast", "makeText",
+                "(Landroid/content/Context;Ljava/lang/CharSequence;I)Landroid/widget/Toast;",
+                QtAndroid::androidActivity().object(),
+                javaString.object(),
+                jint(isLong ? 1 : 0));
+        toast.callMethod<void>("show");
+    });
+}
+#endif
+
+// use TapAndHold gesture to show the context menu
+// call widget->grabGesture(Qt::TapAndHoldGesture) then use the event filter
+// for QLineEdit, the edit menu will be shown
+// for QPlainTextEdit, the parent's context menu will be shown
+// useless now...
+
+bool GestureConverter::eventFilter(QObject *obj, QEvent *event)
+{
+    qDebug() << obj->objectName() << event->type();
+    if(event->type() == QEvent::Gesture || event->type() == QEvent::GestureOverride)
+    {
+        QGestureEvent *ge = static_cast<QGestureEvent*>(event);
+        qDebug() << obj->objectName() << ge->gestures();
+        QGesture *ges = ge->gesture(Qt::TapAndHoldGesture);
+        if(ges->state() == Qt::GestureFinished)
+        {
+            QContextMenuEvent newEvent(QContextMenuEvent::Mouse, ge->mapToGraphicsScene(ges->hotSpot()).toPoint());
+            QApplication::sendEvent(obj, &newEvent);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,25 @@
+#ifndef GUIUTIL_H
+#define GUIUTIL_H
+
+#include <QString>
+#include <QStandardItemModel>
+
+// the helpers which need QtGui/QtWidgets, the others are in Util
+class GuiUtil
+{
+public:
+    static void disableItem(QStandardItemModel* model, int id, bool enabled = false);
+#ifdef Q_OS_ANDROID
+    static void showToast(const QString &message, bool isLong = false);
+#endif
+};
+
+class GestureConverter : public QObject
+{
+    Q_OBJECT
+
+protected:
+    bool eventFilter(QObject* obj, QEvent *event) override;
+};
+
+#endif // GUIUTIL_H
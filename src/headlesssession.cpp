@@ -0,0 +1,566 @@
+#include "headlesssession.h"
+#include "mysettings.h"
+#include "tracer.h"
+#include "metricsexporter.h"
+#include "util.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <stdio.h>
+#include <string.h>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+static const QMap<QString, Connection::Type> typeMap =
+{
+    {"serial", Connection::SerialPort},
+    {"tcp-client", Connection::TCP_Client},
+    {"tcp-server", Connection::TCP_Server},
+    {"udp", Connection::UDP},
+    {"pty", Connection::PTY},
+    {"unix-client", Connection::Unix_Client},
+    {"unix-server", Connection::Unix_Server},
+    {"fifo", Connection::Fifo},
+    {"generator", Connection::Generator},
+};
+
+static void printMessage(const QString& msg)
+{
+    fputs(qPrintable(msg + "\n"), stderr);
+    fflush(stderr);
+}
+
+// the "Arg" of each history entry, saved by the GUI
+static QList<QStringList> readHistory(const QString& prefix)
+{
+    QList<QStringList> result;
+    MySettings* settings = MySettings::defaultSettings();
+    if(!settings->childGroups().contains(prefix))
+        return result;
+    int size = settings->beginReadArray(prefix);
+    for(int i = 0; i < size; i++)
+    {
+        settings->setArrayIndex(i);
+        result.append(settings->value("Arg").toStringList());
+    }
+    settings->endArray();
+    return result;
+}
+
+static QVariant readLastValue(const QString& prefix, const QString& key)
+{
+    MySettings* settings = MySettings::defaultSettings();
+    settings->beginGroup(prefix);
+    QVariant result = settings->value(key);
+    settings->endGroup();
+    return result;
+}
+
+HeadlessSession::HeadlessSession(QObject *parent)
+    : QObject{parent}
+{
+    m_connection = new Connection(this);
+    m_connection->setRxBuffered(false); // nothing calls readAll()
+    m_output = new QFile(this);
+    m_statsTimer = new QTimer(this);
+    m_durationTimer = new QTimer(this);
+    m_durationTimer->setSingleShot(true);
+    m_metrics = new PipelineMetrics(this);
+    m_metrics->watchConnection(m_connection);
+    connect(m_connection, &Connection::connected, this, &HeadlessSession::onConnected);
+    connect(m_connection, &Connection::connectFailed, this, &HeadlessSession::onConnectFailed);
+    connect(m_connection, &Connection::disconnected, this, &HeadlessSession::onDisconnected);
+    connect(m_connection, &Connection::dataArrived, this, &HeadlessSession::onDataArrived);
+    // the servers can send after a client is connected
+    connect(m_connection, &Connection::stateChanged, this, &HeadlessSession::scheduleSend);
+    connect(m_connection, &Connection::bytesWritten, this, &HeadlessSession::scheduleSend);
+    connect(m_statsTimer, &QTimer::timeout, this, &HeadlessSession::printStats);
+    connect(m_durationTimer, &QTimer::timeout, this, [ = ]
+    {
+        quit(0);
+    });
+}
+
+HeadlessSession::~HeadlessSession()
+{
+    MetricsExporter::removeSession(m_metrics);
+    closeInput();
+}
+
+bool HeadlessSession::isRequested(int argc, char *argv[])
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+    return false;
+}
+
+void HeadlessSession::addOptions(QCommandLineParser& parser)
+{
+    parser.addOption({"headless", "Run without UI, Rx is written to stdout or the output file"});
+    parser.addOption({"type", "(headless)Connection type: " + QStringList(typeMap.keys()).join(", "), "type"});
+    parser.addOption({"port", "(headless)Serial port name", "name"});
+    parser.addOption({"baud", "(headless)Serial port baud rate", "rate"});
+    parser.addOption({"data-bits", "(headless)5, 6, 7 or 8", "bits"});
+    parser.addOption({"parity", "(headless)none, even, odd, space or mark", "parity"});
+    parser.addOption({"stop-bits", "(headless)1, 1.5 or 2", "bits"});
+    parser.addOption({"flow-control", "(headless)none, hardware or software", "mode"});
+    parser.addOption({"local", "(headless)Local address of TCP/UDP", "[address:]port"});
+    parser.addOption({"remote", "(headless)Remote address of TCP/UDP", "host:port"});
+    parser.addOption({"path", "(headless)Unix socket or FIFO path, or the link path of PTY", "path"});
+    parser.addOption({"write-path", "(headless)The FIFO to write", "path"});
+    parser.addOption({"datagram", "(headless)Use datagram Unix socket"});
+    parser.addOption({"workload", "(headless)Generator workload: sine, text, random or frame", "workload"});
+    parser.addOption({"rate", "(headless)Generator rate in bytes/s, 0 for max", "rate"});
+    parser.addOption({"frame", "(headless)Generator frame in hex", "hex"});
+    parser.addOption({"output", "(headless)Write Rx to the file instead of stdout", "file"});
+    parser.addOption({"send", "(headless)Send the file after connected, - for stdin, can be repeated", "file"});
+    parser.addOption({"stats", "(headless)Stats interval in seconds, 0 to disable, 1 by default", "seconds"});
+    parser.addOption({"duration", "(headless)Stop after the specified time", "seconds"});
+    parser.addOption({"verbose", "(headless)Show debug messages"});
+    parser.addOption({"trace", "(headless)Record the pipeline stages, then save them in the Chrome trace format", "file"});
+}
+
+bool HeadlessSession::start(const QCommandLineParser& parser)
+{
+    if(!parser.isSet("verbose"))
+        QLoggingCategory::setFilterRules("*.debug=false");
+
+    QString typeName = parser.value("type");
+    if(!typeMap.contains(typeName))
+    {
+        printMessage("Unknown connection type: " + typeName);
+        printMessage("Available: " + QStringList(typeMap.keys()).join(", "));
+        return false;
+    }
+    Connection::Type type = typeMap[typeName];
+    m_connection->setType(type);
+    if(!setArgument(parser, type))
+        return false;
+
+    bool isOk = true;
+    if(parser.isSet("output"))
+    {
+        m_output->setFileName(parser.value("output"));
+        isOk = m_output->open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+    else
+        isOk = m_output->open(fileno(stdout), QIODevice::WriteOnly | QIODevice::Unbuffered);
+    if(!isOk)
+    {
+        printMessage("Cannot open the output: " + m_output->errorString());
+        return false;
+    }
+
+    m_sendList = parser.values("send");
+#ifndef Q_OS_UNIX
+    if(m_sendList.contains("-"))
+    {
+        printMessage("Sending from stdin is not supported on this platform");
+        return false;
+    }
+#endif
+
+    double interval = parser.isSet("stats") ? parser.value("stats").toDouble() : 1;
+    if(interval > 0)
+        m_statsTimer->setInterval(interval * 1000);
+    double duration = parser.value("duration").toDouble();
+    if(duration > 0)
+    {
+        m_durationTimer->setInterval(duration * 1000);
+        m_durationTimer->start();
+    }
+
+    m_tracePath = parser.value("trace");
+    if(!m_tracePath.isEmpty())
+        Tracer::setEnabled(true);
+
+    if(MetricsExporter::isRunning())
+    {
+        QTimer* gaugeTimer = new QTimer(this);
+        connect(gaugeTimer, &QTimer::timeout, m_metrics, &PipelineMetrics::updateConnectionGauges);
+        gaugeTimer->start(1000);
+        MetricsExporter::addSession(m_metrics);
+    }
+
+    m_clock.start();
+    // connectFailed() might be emitted there
+    m_connection->open();
+    return true;
+}
+
+bool HeadlessSession::setArgument(const QCommandLineParser& parser, Connection::Type type)
+{
+    QString host;
+    quint16 port;
+    if(type == Connection::SerialPort)
+    {
+        QList<QStringList> history = readHistory("SerialTest_History_SerialPort");
+        Connection::SerialPortArgument arg;
+        arg.baudRate = 115200;
+        if(!history.isEmpty())
+            arg = Connection::stringList2SPArg(history.last());
+        if(parser.isSet("port"))
+        {
+            // use the preference of this port if it's used before
+            QString name = parser.value("port");
+            for(auto it = history.crbegin(); it != history.crend(); ++it)
+            {
+                Connection::SerialPortArgument item = Connection::stringList2SPArg(*it);
+                if(item.name == name)
+                {
+                    arg = item;
+                    break;
+                }
+            }
+            arg.name = name;
+            arg.id = name;
+        }
+        if(arg.name.isEmpty())
+        {
+            printMessage("--port is required");
+            return false;
+        }
+        if(parser.isSet("baud"))
+            arg.baudRate = parser.value("baud").toInt();
+        if(parser.isSet("data-bits"))
+        {
+            int bits = parser.value("data-bits").toInt();
+            if(bits < 5 || bits > 8)
+            {
+                printMessage("Invalid data bits");
+                return false;
+            }
+            arg.dataBits = (QSerialPort::DataBits)bits;
+        }
+        if(parser.isSet("parity"))
+        {
+            static const QMap<QString, QSerialPort::Parity> parityMap =
+            {
+                {"none", QSerialPort::NoParity},
+                {"even", QSerialPort::EvenParity},
+                {"odd", QSerialPort::OddParity},
+                {"space", QSerialPort::SpaceParity},
+                {"mark", QSerialPort::MarkParity},
+            };
+            if(!parityMap.contains(parser.value("parity")))
+            {
+                printMessage("Invalid parity");
+                return false;
+            }
+            arg.parity = parityMap[parser.value("parity")];
+        }
+        if(parser.isSet("stop-bits"))
+        {
+            static const QMap<QString, QSerialPort::StopBits> stopBitsMap =
+            {
+                {"1", QSerialPort::OneStop},
+                {"1.5", QSerialPort::OneAndHalfStop},
+                {"2", QSerialPort::TwoStop},
+            };
+            if(!stopBitsMap.contains(parser.value("stop-bits")))
+            {
+                printMessage("Invalid stop bits");
+                return false;
+            }
+            arg.stopBits = stopBitsMap[parser.value("stop-bits")];
+        }
+        if(parser.isSet("flow-control"))
+        {
+            static const QMap<QString, QSerialPort::FlowControl> flowControlMap =
+            {
+                {"none", QSerialPort::NoFlowControl},
+                {"hardware", QSerialPort::HardwareControl},
+                {"software", QSerialPort::SoftwareControl},
+            };
+            if(!flowControlMap.contains(parser.value("flow-control")))
+            {
+                printMessage("Invalid flow control");
+                return false;
+            }
+            arg.flowControl = flowControlMap[parser.value("flow-control")];
+        }
+        m_connection->setArgument(arg);
+    }
+    else if(type == Connection::TCP_Client || type == Connection::TCP_Server || type == Connection::UDP)
+    {
+        Connection::NetworkArgument arg;
+        if(type == Connection::TCP_Server)
+            arg.localPort = readLastValue("SerialTest_History_TCP_Server", "LastPort").toUInt();
+        else
+        {
+            QList<QStringList> history = readHistory(type == Connection::TCP_Client ? "SerialTest_History_TCP_Client" : "SerialTest_History_UDP");
+            if(!history.isEmpty())
+                arg = Connection::stringList2NetArg(history.last());
+        }
+        if(parser.isSet("local"))
+        {
+            if(!Util::parseAddress(parser.value("local"), host, port))
+            {
+                printMessage("Invalid local address");
+                return false;
+            }
+            arg.localAddress = host.isEmpty() ? QHostAddress(QHostAddress::Any) : QHostAddress(host);
+            arg.localPort = port;
+        }
+        if(arg.localAddress.isNull())
+            arg.localAddress = QHostAddress::Any;
+        if(parser.isSet("remote"))
+        {
+            if(!Util::parseAddress(parser.value("remote"), host, port) || host.isEmpty())
+            {
+                printMessage("Invalid remote address");
+                return false;
+            }
+            arg.remoteName = host;
+            arg.remotePort = port;
+        }
+        if(type == Connection::TCP_Client && arg.remoteName.isEmpty())
+        {
+            printMessage("--remote is required");
+            return false;
+        }
+        m_connection->setArgument(arg);
+    }
+    else if(type == Connection::PTY)
+    {
+        if(parser.isSet("path"))
+            m_connection->PTY_setLinkPath(parser.value("path"));
+        else
+            m_connection->PTY_setLinkPath(readLastValue("SerialTest_History_PTY", "LastLinkPath").toString());
+    }
+    else if(type == Connection::Unix_Client || type == Connection::Unix_Server || type == Connection::Fifo)
+    {
+        static const QMap<Connection::Type, QString> prefixMap =
+        {
+            {Connection::Unix_Client, "SerialTest_History_Unix_Client"},
+            {Connection::Unix_Server, "SerialTest_History_Unix_Server"},
+            {Connection::Fifo, "SerialTest_History_Fifo"},
+        };
+        QList<QStringList> history = readHistory(prefixMap[type]);
+        Connection::LocalArgument arg;
+        if(!history.isEmpty())
+            arg = Connection::stringList2LocalArg(history.last());
+        if(parser.isSet("path"))
+            arg.path = parser.value("path");
+        if(parser.isSet("write-path"))
+            arg.writePath = parser.value("write-path");
+        if(parser.isSet("datagram"))
+            arg.datagram = true;
+        if(arg.path.isEmpty())
+        {
+            printMessage("--path is required");
+            return false;
+        }
+        m_connection->setArgument(arg);
+    }
+    else if(type == Connection::Generator)
+    {
+        Connection::GeneratorArgument arg = Connection::stringList2GeneratorArg(readLastValue("SerialTest_History_Generator", "LastArg").toStringList());
+        if(parser.isSet("workload"))
+        {
+            static const QMap<QString, DataGenerator::Workload> workloadMap =
+            {
+                {"sine", DataGenerator::SineCSV},
+                {"text", DataGenerator::LineText},
+                {"random", DataGenerator::RandomBinary},
+                {"frame", DataGenerator::FixedFrame},
+            };
+            if(!workloadMap.contains(parser.value("workload")))
+            {
+                printMessage("Invalid workload");
+                return false;
+            }
+            arg.workload = workloadMap[parser.value("workload")];
+        }
+        if(parser.isSet("rate"))
+            arg.rate = parser.value("rate").toLongLong();
+        if(parser.isSet("frame"))
+            arg.frame = QByteArray::fromHex(parser.value("frame").toLatin1());
+        m_connection->setArgument(arg);
+    }
+    return true;
+}
+
+void HeadlessSession::onConnected()
+{
+    QString msg = "Connected: " + Connection::getTypeName(m_connection->type());
+    if(m_connection->type() == Connection::PTY)
+        msg += ", slave: " + m_connection->PTY_slaveName();
+    printMessage(msg);
+    m_lastStatsTime = m_clock.elapsed();
+    if(m_statsTimer->interval() > 0 && !m_statsTimer->isActive())
+        m_statsTimer->start();
+    scheduleSend();
+}
+
+void HeadlessSession::onConnectFailed(const QString& info)
+{
+    printMessage("Failed to connect: " + info);
+    quit(1);
+}
+
+void HeadlessSession::onDisconnected()
+{
+    printMessage("Disconnected");
+    quit(0);
+}
+
+void HeadlessSession::onDataArrived(const QByteArray& data)
+{
+    m_output->write(data);
+    m_RxCount += data.size();
+}
+
+void HeadlessSession::scheduleSend()
+{
+    if(m_sendScheduled || (m_input == nullptr && m_sendList.isEmpty()))
+        return;
+    m_sendScheduled = true;
+    QTimer::singleShot(0, this, &HeadlessSession::sendNext);
+}
+
+void HeadlessSession::sendNext()
+{
+    m_sendScheduled = false;
+    if(!m_connection->isConnected())
+        return; // resumed by stateChanged()
+    bool hasFeedback = m_connection->hasWriteFeedback();
+    // each write is a datagram for UDP
+    qint64 chunkSize = hasFeedback ? 65536 : 1024;
+    while(m_input != nullptr || nextInput())
+    {
+        if(hasFeedback && m_connection->bytesToWrite() >= chunkSize)
+        {
+            // resumed by bytesWritten()
+            if(m_stdinNotifier != nullptr)
+                m_stdinNotifier->setEnabled(false);
+            return;
+        }
+        QByteArray data;
+        if(m_stdinNotifier != nullptr)
+        {
+#ifdef Q_OS_UNIX
+            data.resize(chunkSize);
+            qint64 len = ::read(STDIN_FILENO, data.data(), chunkSize);
+            if(len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // resumed by the notifier
+                m_stdinNotifier->setEnabled(true);
+                return;
+            }
+            data.resize(qMax(len, 0LL));
+#endif
+        }
+        else
+            data = m_input->read(chunkSize);
+        if(data.isEmpty())
+        {
+            closeInput();
+            continue;
+        }
+        m_connection->write(data);
+        m_TxCount += data.size();
+        m_metrics->addTx(data.size());
+        if(!hasFeedback)
+        {
+            // no backpressure, yield to the event loop between the writes
+            scheduleSend();
+            return;
+        }
+    }
+}
+
+bool HeadlessSession::nextInput()
+{
+    while(!m_sendList.isEmpty())
+    {
+        QString name = m_sendList.takeFirst();
+        m_input = new QFile(this);
+        if(name == "-")
+        {
+#ifdef Q_OS_UNIX
+            // non-blocking, so the event loop keeps running while waiting for the input
+            fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+            m_input->open(STDIN_FILENO, QIODevice::ReadOnly);
+            m_stdinNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+            connect(m_stdinNotifier, &QSocketNotifier::activated, this, &HeadlessSession::sendNext);
+            return true;
+#endif
+        }
+        else
+        {
+            m_input->setFileName(name);
+            if(m_input->open(QIODevice::ReadOnly))
+                return true;
+            printMessage("Cannot open " + name + ": " + m_input->errorString());
+        }
+        delete m_input;
+        m_input = nullptr;
+    }
+    return false;
+}
+
+void HeadlessSession::closeInput()
+{
+    if(m_stdinNotifier != nullptr)
+    {
+#ifdef Q_OS_UNIX
+        // stdin might be shared with the shell
+        fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) & ~O_NONBLOCK);
+#endif
+        delete m_stdinNotifier;
+        m_stdinNotifier = nullptr;
+    }
+    delete m_input;
+    m_input = nullptr;
+}
+
+void HeadlessSession::printStats()
+{
+    qint64 currTime = m_clock.elapsed();
+    double interval = qMax(currTime - m_lastStatsTime, 1LL) / 1000.0;
+    printMessage(QString("[%1s] Rx: %2 (%3 B/s) Tx: %4 (%5 B/s)")
+                 .arg(currTime / 1000.0, 0, 'f', 1)
+                 .arg(m_RxCount)
+                 .arg((m_RxCount - m_lastRxCount) / interval, 0, 'f', 0)
+                 .arg(m_TxCount)
+                 .arg((m_TxCount - m_lastTxCount) / interval, 0, 'f', 0));
+    m_lastRxCount = m_RxCount;
+    m_lastTxCount = m_TxCount;
+    m_lastStatsTime = currTime;
+}
+
+void HeadlessSession::quit(int returnCode)
+{
+    if(m_quitting)
+        return;
+    m_quitting = true;
+    closeInput();
+    m_statsTimer->stop();
+    m_durationTimer->stop();
+    if(m_connection->state() != Connection::Unconnected)
+        m_connection->close();
+    if(m_RxCount > 0 || m_TxCount > 0)
+    {
+        double seconds = qMax(m_clock.elapsed(), 1LL) / 1000.0;
+        printMessage(QString("Total Rx: %1 (%2 B/s) Tx: %3 (%4 B/s)")
+                     .arg(m_RxCount)
+                     .arg(m_RxCount / seconds, 0, 'f', 0)
+                     .arg(m_TxCount)
+                     .arg(m_TxCount / seconds, 0, 'f', 0));
+    }
+    if(!m_tracePath.isEmpty())
+    {
+        Tracer::setEnabled(false);
+        if(!Tracer::dump(m_tracePath))
+            printMessage("Cannot save the trace: " + m_tracePath);
+    }
+    // might be called before the event loop is started
+    QMetaObject::invokeMethod(QCoreApplication::instance(), "exit", Qt::QueuedConnection, Q_ARG(int, returnCode));
+}
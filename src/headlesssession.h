@@ -0,0 +1,59 @@
+#ifndef HEADLESSSESSION_H
+#define HEADLESSSESSION_H
+
+#include <QObject>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include "connection.h"
+#include "pipelinemetrics.h"
+
+// run a connection without any UI, for --headless
+// Rx is written to a file or stdout, Tx is read from files or stdin, the stats are printed to stderr
+class HeadlessSession : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HeadlessSession(QObject *parent = nullptr);
+    ~HeadlessSession();
+
+    // check argv before any QCoreApplication is created
+    static bool isRequested(int argc, char *argv[]);
+    static void addOptions(QCommandLineParser& parser);
+    // the omitted arguments are taken from the history in the config file
+    bool start(const QCommandLineParser& parser);
+private slots:
+    void onConnected();
+    void onConnectFailed(const QString& info);
+    void onDisconnected();
+    void onDataArrived(const QByteArray& data);
+    void sendNext();
+    void printStats();
+private:
+    Connection* m_connection;
+    QFile* m_output;
+    QStringList m_sendList; // "-" for stdin
+    QFile* m_input = nullptr;
+    QSocketNotifier* m_stdinNotifier = nullptr;
+    bool m_sendScheduled = false;
+    bool m_quitting = false;
+    QTimer* m_statsTimer;
+    QTimer* m_durationTimer;
+    PipelineMetrics* m_metrics;
+    QElapsedTimer m_clock;
+    qint64 m_RxCount = 0, m_TxCount = 0;
+    qint64 m_lastRxCount = 0, m_lastTxCount = 0;
+    qint64 m_lastStatsTime = 0;
+    QString m_tracePath;
+
+    bool setArgument(const QCommandLineParser& parser, Connection::Type type);
+    bool nextInput();
+    void closeInput();
+    void scheduleSend();
+    void quit(int returnCode);
+};
+
+#endif // HEADLESSSESSION_H
@@ -1,5 +1,9 @@
 ﻿#include "mainwindow.h"
 #include "mysettings.h"
+#include "util.h"
+#include "headlesssession.h"
+#include "perfharness.h"
+#include "metricsexporter.h"
 
 #include <QApplication>
 #include <QDir>
@@ -8,6 +12,34 @@
 #include <QStandardPaths>
 #include <QCommandLineParser>
 
+#ifndef Q_OS_ANDROID
+static void initConfig(const QCommandLineParser& parser)
+{
+    // on PC, store preferences in files for portable use
+    if(parser.isSet("config-path"))
+    {
+        qDebug() << "Config file path:" << parser.value("config-path");
+        MySettings::init(QSettings::IniFormat, parser.value("config-path"));
+    }
+    else
+    {
+        // Firstly, find it in current working directory
+        QString configPath = "preference.ini";
+        if(!QFileInfo::exists(configPath))
+        {
+            // Then, find it in AppConfigLocation
+            configPath = QStandardPaths::locate(QStandardPaths::AppConfigLocation, "preference.ini");
+            if(configPath.isEmpty() || !QFileInfo::exists(configPath))
+            {
+                // If no config file is found, create one in current working directory
+                configPath = "preference.ini";
+            }
+        }
+        MySettings::init(QSettings::IniFormat, configPath);
+    }
+}
+#endif
+
 int main(int argc, char *argv[])
 {
 #ifndef Q_OS_ANDROID
@@ -21,6 +53,38 @@ int main(int argc, char *argv[])
         qputenv("QT_PLUGIN_PATH", pluginDir->absolutePath().toLocal8Bit());
     }
     delete pluginDir;
+
+    // no display, widgets, translator or style sheet
+    if(HeadlessSession::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        QCommandLineParser parser;
+        parser.addHelpOption();
+        parser.addOption({"config-path",
+                          "Use specified file as config file",
+                          "file path"});
+        HeadlessSession::addOptions(parser);
+        MetricsExporter::addOptions(parser);
+        parser.process(a);
+        initConfig(parser);
+
+        QString errorString;
+        if(parser.isSet("metrics-listen") && !MetricsExporter::start(parser.value("metrics-listen"), &errorString))
+        {
+            qCritical("Cannot serve the metrics: %s", qPrintable(errorString));
+            Util::stopWorkerThreads();
+            return 1;
+        }
+        int result = 1;
+        {
+            HeadlessSession session;
+            if(session.start(parser))
+                result = a.exec();
+        }
+        MetricsExporter::stop();
+        Util::stopWorkerThreads();
+        return result;
+    }
 #endif
 
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
@@ -37,29 +101,17 @@ int main(int argc, char *argv[])
     parser.addOption({"config-path",
                       "Use specified file as config file",
                       "file path"});
+    // the headless options are shown in --help
+    HeadlessSession::addOptions(parser);
+    PerfHarness::addOptions(parser);
+    MetricsExporter::addOptions(parser);
     parser.process(a);
-
-    // on PC, store preferences in files for portable use
-    if(parser.isSet("config-path"))
+    initConfig(parser);
+    if(parser.isSet("metrics-listen"))
     {
-        qDebug() << "Config file path:" << parser.value("config-path");
-        MySettings::init(QSettings::IniFormat, parser.value("config-path"));
-    }
-    else
-    {
-        // Firstly, find it in current working directory
-        QString configPath = "preference.ini";
-        if(!QFileInfo::exists(configPath))
-        {
-            // Then, find it in AppConfigLocation
-            configPath = QStandardPaths::locate(QStandardPaths::AppConfigLocation, "preference.ini");
-            if(configPath.isEmpty() || !QFileInfo::exists(configPath))
-            {
-                // If no config file is found, create one in current working directory
-                configPath = "preference.ini";
-            }
-        }
-        MySettings::init(QSettings::IniFormat, configPath);
+        QString errorString;
+        if(!MetricsExporter::start(parser.value("metrics-listen"), &errorString))
+            qWarning("Cannot serve the metrics: %s", qPrintable(errorString));
     }
 
 #endif
@@ -124,7 +176,27 @@ int main(int argc, char *argv[])
 
     m_settings = nullptr;
 
-    MainWindow w;
-    w.show();
-    return a.exec();
+    MainWindow* w = new MainWindow();
+    w->show();
+#ifndef Q_OS_ANDROID
+    if(parser.isSet("perf-scenario"))
+    {
+        PerfHarness* harness = new PerfHarness(w);
+        harness->start(parser);
+    }
+#endif
+    int result = a.exec();
+
+    // delete all sessions before stopping the worker threads they share
+    QList<MainWindow*> sessions;
+    for(QWidget* widget : QApplication::topLevelWidgets())
+    {
+        MainWindow* session = qobject_cast<MainWindow*>(widget);
+        if(session != nullptr)
+            sessions.append(session);
+    }
+    qDeleteAll(sessions);
+    MetricsExporter::stop();
+    Util::stopWorkerThreads();
+    return result;
 }
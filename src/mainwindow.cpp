@@ -1,21 +1,38 @@
 ﻿#include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include "util.h"
+#include "guiutil.h"
 #include "filexceiver.h"
+#include "tracer.h"
+#include "metricsexporter.h"
 
 #include <QBluetoothLocalDevice>
 #ifdef Q_OS_ANDROID
 #include <QAndroidJniEnvironment>
 #endif
 
+QTimer* MainWindow::m_renderTimer = nullptr;
+int MainWindow::m_renderClientNum = 0;
+int MainWindow::m_sessionNum = 0;
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
+    m_sessionId = ++m_sessionNum;
     ui->setupUi(this);
     contextMenu = new QMenu();
 
     IOConnection = new Connection();
+    m_metrics = new PipelineMetrics(this);
+    m_metrics->watchConnection(IOConnection);
+    if(MetricsExporter::isRunning())
+    {
+        // the scrapes only read the gauges, refresh them there
+        QTimer* gaugeTimer = new QTimer(this);
+        connect(gaugeTimer, &QTimer::timeout, this, &MainWindow::updatePipelineGauges);
+        gaugeTimer->start(1000);
+        MetricsExporter::addSession(m_metrics);
+    }
     connect(IOConnection, &Connection::connected, this, &MainWindow::onIODeviceConnected);
     connect(IOConnection, &Connection::disconnected, this, &MainWindow::onIODeviceDisconnected);
     connect(IOConnection, &Connection::connectFailed, this, &MainWindow::onIODeviceConnectFailed);
@@ -32,9 +49,16 @@ MainWindow::MainWindow(QWidget *parent)
     TxLabel = new QLabel();
     RxLabel = new QLabel();
     connArgsLabel = new QLabel;
+    RTTLabel = new QLabel;
     serialPinout = new SerialPinout();
     connect(IOConnection, &Connection::SP_signalsChanged, serialPinout, &SerialPinout::setPinout);
+    connect(IOConnection, &Connection::SP_lineEdgesArrived, serialPinout, &SerialPinout::addEdges);
     connect(serialPinout, &SerialPinout::enableStateChanged, IOConnection, &Connection::setPolling);
+    // updated with the Rx UI
+    connect(IOConnection, &Connection::SP_RTTMeasured, this, [ = ]
+    {
+        m_RTTUpdated = true;
+    });
     serialPinout->initSettings();
 
     deviceTab = new DeviceTab();
@@ -47,6 +71,10 @@ MainWindow::MainWindow(QWidget *parent)
     connect(IOConnection, &Connection::TCP_clientConnected, deviceTab, &DeviceTab::onClientCountChanged);
     connect(IOConnection, &Connection::BT_clientDisconnected, deviceTab, &DeviceTab::onClientCountChanged);
     connect(IOConnection, &Connection::TCP_clientDisconnected, deviceTab, &DeviceTab::onClientCountChanged);
+    connect(IOConnection, &Connection::Unix_clientConnected, deviceTab, &DeviceTab::onClientCountChanged);
+    connect(IOConnection, &Connection::Unix_clientDisconnected, deviceTab, &DeviceTab::onClientCountChanged);
+    connect(IOConnection, &Connection::connected, deviceTab, &DeviceTab::PTY_updateSlaveName);
+    connect(IOConnection, &Connection::disconnected, deviceTab, &DeviceTab::PTY_updateSlaveName);
     ui->funcTab->insertTab(0, deviceTab, tr("Connect"));
 
     dataTab = new DataTab(&rawReceivedData, &rawSendedData);
@@ -61,9 +89,21 @@ MainWindow::MainWindow(QWidget *parent)
     ui->funcTab->insertTab(1, dataTab, tr("Data"));
 
     plotTab = new PlotTab();
+    plotTab->setMetrics(m_metrics);
     connect(dataTab, &DataTab::setPlotDecoder, plotTab, &PlotTab::setDecoder);
     ui->funcTab->insertTab(2, plotTab, tr("Plot"));
 
+    // the Data/Plot tab can show a single client of the server
+    connect(IOConnection, &Connection::BT_clientConnected, this, &MainWindow::updateClientList);
+    connect(IOConnection, &Connection::TCP_clientConnected, this, &MainWindow::updateClientList);
+    connect(IOConnection, &Connection::BT_clientDisconnected, this, &MainWindow::updateClientList);
+    connect(IOConnection, &Connection::TCP_clientDisconnected, this, &MainWindow::updateClientList);
+    connect(IOConnection, &Connection::Unix_clientConnected, this, &MainWindow::updateClientList);
+    connect(IOConnection, &Connection::Unix_clientDisconnected, this, &MainWindow::updateClientList);
+    connect(deviceTab, &DeviceTab::connTypeChanged, this, &MainWindow::updateClientList);
+    connect(dataTab, &DataTab::RxClientChanged, this, &MainWindow::updateRxSubscription);
+    connect(plotTab, &PlotTab::RxClientChanged, this, &MainWindow::updateRxSubscription);
+
     ctrlTab = new CtrlTab();
     connect(ctrlTab, &CtrlTab::send, this, &MainWindow::sendData);
     connect(dataTab, &DataTab::setDataCodec, ctrlTab, &CtrlTab::setDataCodec);
@@ -71,22 +111,26 @@ MainWindow::MainWindow(QWidget *parent)
 
     fileTab = new FileTab();
     connect(fileTab, &FileTab::showUpTab, this, &MainWindow::showUpTab);
-    connect(fileTab->fileXceiver(), &FileXceiver::send, this, &MainWindow::sendData);
+    fileTab->fileXceiver()->setMetrics(m_metrics);
+    connect(fileTab->fileXceiver(), &FileXceiver::send, this, &MainWindow::sendFileData);
+    connect(fileTab->fileXceiver(), &FileXceiver::resending, this, [ = ]
+    {
+        m_fileSliceRefused = false;
+    });
     ui->funcTab->insertTab(4, fileTab, tr("File"));
 
     settingsTab = new SettingsTab();
     connect(settingsTab, &SettingsTab::opacityChanged, this, &MainWindow::onOpacityChanged); // not a slot function, but works fine.
     connect(settingsTab, &SettingsTab::fullScreenStateChanged, this, &MainWindow::setFullScreen);
+    connect(settingsTab, &SettingsTab::serverLagChanged, IOConnection, &Connection::Server_setLagLimit);
+    connect(settingsTab, &SettingsTab::TxCoalescingChanged, IOConnection, &Connection::setTxCoalescing);
     ui->funcTab->insertTab(5, settingsTab, tr("Settings"));
 
     deviceTab->getAvailableTypes(true);
     initTabs();
 
-    updateUITimer = new QTimer();
-    updateUITimer->setInterval(20);
-
     connect(IOConnection, &Connection::readyRead, this, &MainWindow::readData, Qt::QueuedConnection);
-    connect(updateUITimer, &QTimer::timeout, this, &MainWindow::updateRxUI);
+    connect(IOConnection, &Connection::bytesWritten, this, &MainWindow::onIODeviceBytesWritten);
     connect(stateButton, &QPushButton::clicked, this, &MainWindow::onStateButtonClicked);
 
     initUI();
@@ -99,6 +143,33 @@ MainWindow::MainWindow(QWidget *parent)
             dockList[i]->setFloating(false);
     });
     contextMenu->addAction(dockAllWindows);
+    bridge = new Bridge(IOConnection, this);
+    bridgeAction = new QAction(tr("Bridge"), this);
+    connect(bridgeAction, &QAction::triggered, [ = ]()
+    {
+        if(bridgeDialog == nullptr)
+            bridgeDialog = new BridgeDialog(bridge, this);
+        bridgeDialog->show();
+        bridgeDialog->raise();
+    });
+    contextMenu->addAction(bridgeAction);
+    metricsAction = new QAction(tr("Pipeline Metrics"), this);
+    connect(metricsAction, &QAction::triggered, [ = ]()
+    {
+        if(metricsDialog == nullptr)
+        {
+            metricsDialog = new MetricsDialog(m_metrics, this);
+            connect(metricsDialog, &MetricsDialog::aboutToSample, this, &MainWindow::updatePipelineGauges);
+        }
+        metricsDialog->show();
+        metricsDialog->raise();
+    });
+    contextMenu->addAction(metricsAction);
+#ifndef Q_OS_ANDROID
+    newSessionAction = new QAction(tr("New Session"), this);
+    connect(newSessionAction, &QAction::triggered, this, &MainWindow::newSession);
+    contextMenu->addAction(newSessionAction);
+#endif
     contextMenu->addSeparator();
 
     myInfo = new QAction("wh201906", this);
@@ -122,9 +193,59 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    setRendering(false);
+    MetricsExporter::removeSession(m_metrics);
+    // the bridge is deleted with the children, after the connection
+    bridge->stop();
+    IOConnection->disconnect(this);
+    // close() joins the line watcher thread
+    // deleteLater() never runs if the event loop has exited
+    IOConnection->close();
+    delete IOConnection;
+    delete contextMenu;
     delete ui;
 }
 
+Connection* MainWindow::connection()
+{
+    return IOConnection;
+}
+
+qsizetype MainWindow::RxCount()
+{
+    return m_RxCount;
+}
+
+void MainWindow::setRxViews(bool textView, bool plot)
+{
+    dataTab->setRxRealtimeState(textView);
+    plotTab->setPlotEnabled(plot);
+}
+
+void MainWindow::setRendering(bool enabled)
+{
+    if(enabled == m_rendering)
+        return;
+    m_rendering = enabled;
+    if(enabled)
+    {
+        if(m_renderTimer == nullptr)
+        {
+            m_renderTimer = new QTimer(qApp);
+            m_renderTimer->setInterval(20);
+        }
+        connect(m_renderTimer, &QTimer::timeout, this, &MainWindow::updateRxUI);
+        if(m_renderClientNum++ == 0)
+            m_renderTimer->start();
+    }
+    else
+    {
+        disconnect(m_renderTimer, &QTimer::timeout, this, &MainWindow::updateRxUI);
+        if(--m_renderClientNum == 0)
+            m_renderTimer->stop();
+    }
+}
+
 void MainWindow::initTabs()
 {
     // these functions must be called after class initialization with fixed order
@@ -152,11 +273,11 @@ void MainWindow::keyReleaseEvent(QKeyEvent* e)
         {
             // block the first release of Key_Back
             m_keyBackTick = currTick;
-            Util::showToast(tr("Press Back again to exit."));
+            GuiUtil::showToast(tr("Press Back again to exit."));
         }
         else // exit
         {
-            Util::showToast(tr("Closing...")); // exit might be blocked by FileTab for 3s
+            GuiUtil::showToast(tr("Closing...")); // exit might be blocked by FileTab for 3s
             QMainWindow::keyReleaseEvent(e);
         }
 #endif
@@ -187,6 +308,7 @@ void MainWindow::initUI()
     statusBar()->addPermanentWidget(connArgsLabel, 1);
     statusBar()->addPermanentWidget(RxLabel, 0);
     statusBar()->addPermanentWidget(TxLabel, 0);
+    statusBar()->addPermanentWidget(RTTLabel, 0);
     statusBar()->addPermanentWidget(serialPinout, 0);
 #ifdef Q_OS_ANDROID
 
@@ -316,6 +438,38 @@ void MainWindow::updateStatusBar()
         }
         connArgsText.append((tr("Remote") + ": (%1, %2) ").arg(netArg.remoteName).arg(netArg.remotePort));
     }
+    else if(type == Connection::PTY)
+    {
+        serialPinout->hide();
+        if(IOConnection->isConnected())
+        {
+            connArgsText.append((tr("Slave") + ": %1 ").arg(IOConnection->PTY_slaveName()));
+            if(!IOConnection->PTY_linkPath().isEmpty())
+                connArgsText.append((tr("Link") + ": %1 ").arg(IOConnection->PTY_linkPath()));
+        }
+    }
+    else if(type == Connection::Unix_Client || type == Connection::Unix_Server || type == Connection::Fifo)
+    {
+        serialPinout->hide();
+        Connection::LocalArgument localArg = IOConnection->getLocalArgument();
+        if(IOConnection->state() != Connection::Unconnected)
+        {
+            connArgsText.append((tr("Path") + ": %1 ").arg(localArg.path));
+            if(type == Connection::Fifo && !localArg.writePath.isEmpty())
+                connArgsText.append((tr("Write Path") + ": %1 ").arg(localArg.writePath));
+        }
+        if(type == Connection::Unix_Server && !localArg.datagram)
+            connArgsText.append((tr("Connected Clients") + ": %1 ").arg(IOConnection->UnixServer_clientCount()));
+    }
+    else if(type == Connection::Generator)
+    {
+        serialPinout->hide();
+        Connection::GeneratorArgument genArg = IOConnection->getGeneratorArgument();
+        connArgsText.append((tr("Target") + ": %1 ").arg(genArg.rate == 0 ? tr("Max") : QString::number(genArg.rate) + "B/s"));
+        // the average of the last run, lower than the target if the receiver can't keep up
+        if(!IOConnection->isConnected() && IOConnection->Generator_producedBytes() > 0)
+            connArgsText.append((tr("Achieved") + ": %1B/s ").arg(IOConnection->Generator_achievedRate(), 0, 'f', 0));
+    }
     connArgsLabel->setText(connArgsText);
     Connection::State currState = IOConnection->state();
     if(currState == Connection::Connected)
@@ -325,11 +479,15 @@ void MainWindow::updateStatusBar()
     else
         stateButton->setText(tr("State") + ": X");
     updateRxTxLen();
+    updateRTTLabel();
 }
 
 void MainWindow::updateWindowTitle(Connection::Type type)
 {
-    setWindowTitle("SerialTest - " + Connection::getTypeName(type));
+    if(m_sessionId > 1)
+        setWindowTitle("SerialTest [" + QString::number(m_sessionId) + "] - " + Connection::getTypeName(type));
+    else
+        setWindowTitle("SerialTest - " + Connection::getTypeName(type));
 }
 
 void MainWindow::clearSendedData()
@@ -388,7 +546,10 @@ void MainWindow::updateRxTxLen(bool updateRx, bool updateTx)
 void MainWindow::onIODeviceConnected()
 {
     qDebug() << "IODevice Connected";
-    updateUITimer->start();
+    setRendering(true);
+    QMetaObject::invokeMethod(fileTab->fileXceiver(), "setBackpressureEnabled", Qt::QueuedConnection, Q_ARG(bool, IOConnection->hasWriteFeedback()));
+    if(fileTab->protocolRunning())
+        QMetaObject::invokeMethod(fileTab->fileXceiver(), "onReconnected", Qt::QueuedConnection);
     Connection::Type type = IOConnection->type();
     if(type == Connection::SerialPort)
     {
@@ -413,6 +574,10 @@ void MainWindow::onIODeviceConnected()
         arg = IOConnection->getNetworkArgument(false, false);
         deviceTab->saveUDPPreference(arg);
     }
+    else if(type == Connection::Unix_Client || type == Connection::Unix_Server || type == Connection::Fifo)
+    {
+        deviceTab->saveLocalPreference(IOConnection->getLocalArgument());
+    }
     updateStatusBar();
     dataTab->onConnEstablished();
 }
@@ -420,9 +585,12 @@ void MainWindow::onIODeviceConnected()
 void MainWindow::onIODeviceDisconnected()
 {
     qDebug() << "IODevice Disconnected";
-    updateUITimer->stop();
+    setRendering(false);
     updateStatusBar();
     updateRxUI();
+    // wake up FileXceiver if it's waiting for the buffer, the next slice will stop it
+    if(fileTab->transmitting())
+        QMetaObject::invokeMethod(fileTab->fileXceiver(), "setDeviceBacklog", Qt::QueuedConnection, Q_ARG(qint64, 0));
 }
 
 void MainWindow::onIODeviceConnectFailed(const QString& info)
@@ -437,7 +605,7 @@ void MainWindow::onIODeviceConnectFailed(const QString& info)
     {
         msg = tr("Cannot establish the connection.");
     }
-    else if(type == Connection::BT_Server || type == Connection::TCP_Server)
+    else if(type == Connection::BT_Server || type == Connection::TCP_Server || type == Connection::Unix_Server)
     {
         msg = tr("Cannot start the server.");
     }
@@ -445,6 +613,22 @@ void MainWindow::onIODeviceConnectFailed(const QString& info)
     {
         msg = tr("Cannot bind to the specified address and port.");
     }
+    else if(type == Connection::PTY)
+    {
+        msg = tr("Cannot create the pseudo-terminal.");
+    }
+    else if(type == Connection::Unix_Client)
+    {
+        msg = tr("Cannot connect to the socket.");
+    }
+    else if(type == Connection::Fifo)
+    {
+        msg = tr("Cannot open the FIFO.");
+    }
+    else if(type == Connection::Generator)
+    {
+        msg = tr("Cannot start the generator.");
+    }
     if(!info.isEmpty())
         msg += "\n" + info;
     QMessageBox::warning(this, tr("Error"), msg);
@@ -458,10 +642,28 @@ void MainWindow::readData()
     QByteArray newData = IOConnection->readAll();
     if(newData.isEmpty())
         return;
-    rawReceivedData += newData;
+    TraceScope scope("MainWindow::readData");
+    scope.setArg(newData.length());
     m_RxCount += newData.length();
     updateRxTxLen(true, false);
-    RxUIBuf += newData;
+    // in server mode, only the subscribed streams are handled
+    QByteArray RxData = newData, plotData = newData;
+    int RxClientId = dataTab->RxClientId(), plotClientId = plotTab->RxClientId();
+    if(RxClientId >= 0)
+        RxData = IOConnection->Server_readAll(RxClientId);
+    if(plotClientId == RxClientId)
+        plotData = RxData;
+    else if(plotClientId >= 0)
+        plotData = IOConnection->Server_readAll(plotClientId);
+    PlotUIBuf += plotData;
+    if(!RxData.isEmpty())
+    {
+        rawReceivedData += RxData;
+        RxUIBuf += RxData;
+        // the protocols wait for the responses, feed them without the UI delay
+        if(fileTab->protocolRunning())
+            QMetaObject::invokeMethod(fileTab->fileXceiver(), "newData", Qt::QueuedConnection, Q_ARG(QByteArray, RxData));
+    }
     QApplication::processEvents();
 }
 
@@ -485,25 +687,152 @@ void MainWindow::sendData(const QByteArray& data)
         dataTab->appendSendedData(data);
     }
     m_TxCount += len;
+    m_metrics->addTx(len);
     updateRxTxLen(false, true);
 }
 
+void MainWindow::sendFileData(const QByteArray& data)
+{
+    // the data might be a slice of the file mapped by FileXceiver,
+    // release it after it's handled, even if it's not written
+    if(!IOConnection->isConnected())
+    {
+        // the chunked transfer survives reopen(), the lost blocks will be requested again
+        if(!fileTab->resumable())
+            sendData(data); // show the warning then stop FileTab
+    }
+    else
+    {
+        // the slices sent before FileXceiver knows the refusal are refused as well, to keep the order
+        qint64 len = m_fileSliceRefused ? 0 : IOConnection->write(data);
+        if(len > 0)
+        {
+            if(m_TxDataRecording && fileTab->TxRecordingEnabled())
+            {
+                QByteArray written = data.left(len);
+                rawSendedData += written; // deep copy for raw data
+                dataTab->appendSendedData(written);
+            }
+            m_TxCount += len;
+            m_metrics->addTx(len);
+            updateRxTxLen(false, true);
+        }
+        if(len >= 0 && len < data.size())
+        {
+            // the servers refuse the data under Lag_Block, FileXceiver sends the rest after the clients catch up
+            m_fileSliceRefused = true;
+            QMetaObject::invokeMethod(fileTab->fileXceiver(), "requeueSlice", Qt::QueuedConnection, Q_ARG(QByteArray, data.mid(len)));
+        }
+        else
+        {
+            // update the backlog before releasing the slice, or FileXceiver might see an underestimated one
+            QMetaObject::invokeMethod(fileTab->fileXceiver(), "setDeviceBacklog", Qt::QueuedConnection, Q_ARG(qint64, IOConnection->bytesToWrite()));
+        }
+    }
+    QMetaObject::invokeMethod(fileTab->fileXceiver(), "releaseSlice", Qt::QueuedConnection, Q_ARG(qsizetype, data.size()));
+}
+
+void MainWindow::onIODeviceBytesWritten()
+{
+    if(fileTab->transmitting())
+        QMetaObject::invokeMethod(fileTab->fileXceiver(), "setDeviceBacklog", Qt::QueuedConnection, Q_ARG(qint64, IOConnection->bytesToWrite()));
+}
+
 // TODO:
 // use the same RxDecoder for edit/plot
 // maybe standalone decoder?
 void MainWindow::updateRxUI()
 {
+    TraceScope scope("MainWindow::updateRxUI");
+    scope.setArg(RxUIBuf.size());
+    if(m_RTTUpdated)
+        updateRTTLabel();
+    QElapsedTimer timer;
+    if(!PlotUIBuf.isEmpty())
+    {
+        if(plotTab->enabled())
+        {
+            timer.start();
+            plotTab->newData(PlotUIBuf);
+            m_metrics->addConsumerTime(PipelineMetrics::PlotFeed, timer.nsecsElapsed());
+        }
+        PlotUIBuf.clear();
+    }
     if(RxUIBuf.isEmpty())
         return;
     if(dataTab->getRxRealtimeState())
+    {
+        timer.start();
         dataTab->appendReceivedData(RxUIBuf);
-    if(plotTab->enabled())
-        plotTab->newData(RxUIBuf);
-    if(fileTab->receiving())
-        fileTab->fileXceiver()->newData(RxUIBuf);
+        m_metrics->addConsumerTime(PipelineMetrics::TextView, timer.nsecsElapsed());
+    }
+    // FileXceiver measures itself in its thread
+    if(fileTab->receiving() && !fileTab->protocolRunning())
+        QMetaObject::invokeMethod(fileTab->fileXceiver(), "newData", Qt::QueuedConnection, Q_ARG(QByteArray, RxUIBuf));
     RxUIBuf.clear();
 }
 
+void MainWindow::updatePipelineGauges()
+{
+    m_metrics->setBacklog(PipelineMetrics::RxUIBacklog, RxUIBuf.size());
+    m_metrics->setBacklog(PipelineMetrics::PlotUIBacklog, PlotUIBuf.size());
+    m_metrics->setBacklog(PipelineMetrics::PlotBufBacklog, plotTab->parserBacklog());
+    m_metrics->setStoreSize(PipelineMetrics::RawRx, rawReceivedData.capacity());
+    m_metrics->setStoreSize(PipelineMetrics::RawTx, rawSendedData.capacity());
+    m_metrics->setStoreSize(PipelineMetrics::RxUIBuf, RxUIBuf.capacity());
+    m_metrics->setStoreSize(PipelineMetrics::PlotUIBuf, PlotUIBuf.capacity());
+    m_metrics->setStoreSize(PipelineMetrics::PlotBuf, plotTab->parserMemory());
+    m_metrics->setStoreSize(PipelineMetrics::TextDocument, dataTab->receivedTextMemory());
+    m_metrics->setStoreSize(PipelineMetrics::PlotGraph, plotTab->graphMemory());
+    m_metrics->updateConnectionGauges();
+}
+
+void MainWindow::updateRTTLabel()
+{
+    m_RTTUpdated = false;
+    Connection::RTTStats stats = IOConnection->SP_RTTStats(IOConnection->SP_isLowLatency());
+    RTTLabel->setVisible(IOConnection->type() == Connection::SerialPort && stats.count > 0);
+    if(stats.count == 0)
+        return;
+    RTTLabel->setText(tr("RTT") + QString(": %1ms").arg(stats.last / 1e6, 0, 'f', 3));
+    // both modes are shown for comparison
+    QString toolTip;
+    for(int i = 0; i < 2; i++)
+    {
+        stats = IOConnection->SP_RTTStats(i);
+        if(stats.count == 0)
+            continue;
+        if(!toolTip.isEmpty())
+            toolTip += "\n";
+        toolTip += (i ? tr("Low latency") : tr("Normal")) + QString(": %1 %2, %3 %4ms, %5 %6ms, %7 %8ms")
+                   .arg(stats.count).arg(tr("samples"))
+                   .arg(tr("min")).arg(stats.min / 1e6, 0, 'f', 3)
+                   .arg(tr("avg")).arg(stats.sum / stats.count / 1e6, 0, 'f', 3)
+                   .arg(tr("max")).arg(stats.max / 1e6, 0, 'f', 3);
+    }
+    RTTLabel->setToolTip(toolTip);
+}
+
+void MainWindow::updateClientList()
+{
+    QMap<int, QString> clientMap;
+    Connection::Type type = IOConnection->type();
+    if(type == Connection::BT_Server || type == Connection::TCP_Server || type == Connection::Unix_Server)
+        clientMap = IOConnection->Server_clientMap();
+    dataTab->setClientList(clientMap);
+    plotTab->setClientList(clientMap);
+}
+
+void MainWindow::updateRxSubscription()
+{
+    QList<int> clientIdList;
+    if(dataTab->RxClientId() >= 0)
+        clientIdList.append(dataTab->RxClientId());
+    if(plotTab->RxClientId() >= 0)
+        clientIdList.append(plotTab->RxClientId());
+    IOConnection->Server_setRxSubscription(clientIdList);
+}
+
 
 void MainWindow::onOpacityChanged(qreal value)
 {
@@ -554,6 +883,14 @@ void MainWindow::onDockTopLevelChanged(bool topLevel)
 
 #ifndef Q_OS_ANDROID
 
+// the sessions share the worker threads and the UI timer
+void MainWindow::newSession()
+{
+    MainWindow* session = new MainWindow();
+    session->setAttribute(Qt::WA_DeleteOnClose);
+    session->show();
+}
+
 void MainWindow::onTopBoxClicked()
 {
     if(onTopBox == nullptr)
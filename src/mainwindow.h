@@ -28,6 +28,10 @@
 #include "settingstab.h"
 #include "serialpinout.h"
 #include "connection.h"
+#include "bridge.h"
+#include "bridgedialog.h"
+#include "pipelinemetrics.h"
+#include "metricsdialog.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -44,8 +48,14 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // for PerfHarness
+    Connection* connection();
+    qsizetype RxCount();
+    void setRxViews(bool textView, bool plot);
+
 public slots:
     void sendData(const QByteArray &data);
+    void sendFileData(const QByteArray &data);
     void updateStatusBar();
     void updateWindowTitle(Connection::Type type);
     void updateRxTxLen(bool updateRx = true, bool updateTx = true);
@@ -56,6 +66,9 @@ public slots:
     void setFullScreen(bool isFullScreen);
     void onOpacityChanged(qreal value);
     void onDockTopLevelChanged(bool topLevel); // for opacity
+#ifndef Q_OS_ANDROID
+    void newSession();
+#endif
 
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
@@ -64,6 +77,10 @@ private slots:
     void readData();
     void onStateButtonClicked();
     void updateRxUI();
+    void updateClientList();
+    void updateRxSubscription();
+    void updateRTTLabel();
+    void updatePipelineGauges();
 
 #ifndef Q_OS_ANDROID
     void onTopBoxClicked();
@@ -72,32 +89,52 @@ private slots:
     void onIODeviceConnected();
     void onIODeviceDisconnected();
     void onIODeviceConnectFailed(const QString& info);
+    void onIODeviceBytesWritten();
 private:
     Ui::MainWindow *ui;
     void initUI();
 
     QMenu* contextMenu;
     QAction* dockAllWindows;
+    QAction* bridgeAction;
+    QAction* metricsAction;
+#ifndef Q_OS_ANDROID
+    QAction* newSessionAction;
+#endif
     QAction* myInfo;
     QAction* currVersion;
     QAction* checkUpdate;
 
     Connection* IOConnection = nullptr;
+    Bridge* bridge;
+    BridgeDialog* bridgeDialog = nullptr;
+    PipelineMetrics* m_metrics;
+    MetricsDialog* metricsDialog = nullptr;
 
     QPushButton* stateButton;
     QLabel* TxLabel;
     QLabel* RxLabel;
     QLabel* connArgsLabel;
+    QLabel* RTTLabel;
+    bool m_RTTUpdated = false;
     SerialPinout* serialPinout;
 
     bool m_TxDataRecording = true;
+    bool m_fileSliceRefused = false; // until FileXceiver resends the refused slices
     QByteArray rawReceivedData;
     qsizetype m_RxCount = 0;
     QByteArray rawSendedData;
     qsizetype m_TxCount = 0;
     QByteArray RxUIBuf;
+    QByteArray PlotUIBuf;
 
-    QTimer* updateUITimer;
+    // each window is a session with its own connection and tabs,
+    // the UI of all connected sessions is updated by one timer
+    static QTimer* m_renderTimer;
+    static int m_renderClientNum;
+    static int m_sessionNum;
+    int m_sessionId;
+    bool m_rendering = false;
 
     MySettings* settings;
     PlotTab* plotTab;
@@ -117,5 +154,6 @@ private:
 
     void dockInit();
     void initTabs();
+    void setRendering(bool enabled);
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,144 @@
+#include "metricsdialog.h"
+#include "ui_metricsdialog.h"
+#include "tracer.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+
+MetricsDialog::MetricsDialog(PipelineMetrics* metrics, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::MetricsDialog)
+{
+    ui->setupUi(this);
+    m_metrics = metrics;
+    m_timer = new QTimer(this);
+    m_timer->setInterval(1000);
+    connect(m_timer, &QTimer::timeout, this, &MetricsDialog::updateMetrics);
+
+    QTreeWidgetItem* group;
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Rx")});
+    m_RxBytesItem = addItem(group, tr("Bytes/s"));
+    m_RxChunksItem = addItem(group, tr("Chunks/s"));
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Tx")});
+    m_TxBytesItem = addItem(group, tr("Bytes/s"));
+    m_TxChunksItem = addItem(group, tr("Chunks/s"));
+
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Backlog")});
+    m_backlogItems.append(addItem(group, "RxUIBuf"));
+    m_backlogItems.append(addItem(group, "PlotUIBuf"));
+    m_backlogItems.append(addItem(group, "plotBuf"));
+    m_backlogItems.append(addItem(group, tr("Tx queue")));
+
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Consumer time(ms/s)")});
+    m_consumerItems.append(addItem(group, tr("Text view")));
+    m_consumerItems.append(addItem(group, tr("Plot feed")));
+    m_consumerItems.append(addItem(group, tr("Plot parse")));
+    m_consumerItems.append(addItem(group, tr("File transceiver")));
+
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Plot")});
+    m_replotTimeItem = addItem(group, tr("Replot time(ms)"));
+    m_replotRateItem = addItem(group, tr("Replots/s"));
+    m_droppedFramesItem = addItem(group, tr("Dropped frames"));
+
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Memory")});
+    m_storeItems.append(addItem(group, tr("Received data")));
+    m_storeItems.append(addItem(group, tr("Sent data")));
+    m_storeItems.append(addItem(group, "RxUIBuf"));
+    m_storeItems.append(addItem(group, "PlotUIBuf"));
+    m_storeItems.append(addItem(group, "plotBuf"));
+    m_storeItems.append(addItem(group, tr("Text view")));
+    m_storeItems.append(addItem(group, tr("Plot graphs")));
+
+    group = new QTreeWidgetItem(ui->metricsTree, {tr("Rx chunk size")});
+    for(int i = 0; i < PipelineMetrics::histogramSize; i++)
+    {
+        QString name = QString::number(1 << i);
+        if(i == PipelineMetrics::histogramSize - 1)
+            name = ">= " + name;
+        else if(i > 0)
+            name += "~" + QString::number((1 << (i + 1)) - 1);
+        m_histogramItems.append(addItem(group, name));
+    }
+
+    ui->metricsTree->expandAll();
+    ui->metricsTree->resizeColumnToContents(0);
+}
+
+MetricsDialog::~MetricsDialog()
+{
+    delete ui;
+}
+
+void MetricsDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    // drop the data collected while hidden
+    m_metrics->sample();
+    m_timer->start();
+}
+
+void MetricsDialog::hideEvent(QHideEvent *event)
+{
+    QDialog::hideEvent(event);
+    m_timer->stop();
+}
+
+void MetricsDialog::on_resetButton_clicked()
+{
+    m_metrics->reset();
+}
+
+void MetricsDialog::on_traceButton_clicked(bool checked)
+{
+    if(checked)
+    {
+        Tracer::clear();
+        Tracer::setEnabled(true);
+        ui->traceButton->setText(tr("Stop and Save"));
+        return;
+    }
+    Tracer::setEnabled(false);
+    ui->traceButton->setText(tr("Record Trace"));
+    QString path = QFileDialog::getSaveFileName(this, tr("Save Trace"), "trace.json", "JSON (*.json)");
+    if(path.isEmpty())
+        return;
+    if(!Tracer::dump(path))
+        QMessageBox::warning(this, tr("Error"), tr("Cannot save the trace."));
+}
+
+void MetricsDialog::updateMetrics()
+{
+    emit aboutToSample();
+    PipelineMetrics::Sample sample = m_metrics->sample();
+
+    m_RxBytesItem->setText(1, QString::number(sample.RxBytesRate, 'f', 0));
+    m_RxChunksItem->setText(1, QString::number(sample.RxChunksRate, 'f', 0));
+    m_TxBytesItem->setText(1, QString::number(sample.TxBytesRate, 'f', 0));
+    m_TxChunksItem->setText(1, QString::number(sample.TxChunksRate, 'f', 0));
+    for(int i = 0; i < m_backlogItems.size(); i++)
+        m_backlogItems[i]->setText(1, QString::number(sample.backlog[i]));
+    for(int i = 0; i < m_consumerItems.size(); i++)
+        m_consumerItems[i]->setText(1, QString::number(sample.consumerLoad[i], 'f', 2));
+    m_replotTimeItem->setText(1, QString::number(sample.replotTime, 'f', 2));
+    m_replotRateItem->setText(1, QString::number(sample.replotRate, 'f', 1));
+    m_droppedFramesItem->setText(1, QString::number(sample.droppedFrames));
+    for(int i = 0; i < m_storeItems.size(); i++)
+        m_storeItems[i]->setText(1, sizeToString(sample.storeSize[i]));
+    for(int i = 0; i < m_histogramItems.size(); i++)
+        m_histogramItems[i]->setText(1, QString::number(sample.RxHistogram[i]));
+}
+
+QTreeWidgetItem* MetricsDialog::addItem(QTreeWidgetItem* parent, const QString& name)
+{
+    return new QTreeWidgetItem(parent, {name});
+}
+
+QString MetricsDialog::sizeToString(qint64 size)
+{
+    if(size < 1024)
+        return QString::number(size) + " B";
+    else if(size < 1024 * 1024)
+        return QString::number(size / 1024.0, 'f', 1) + " KiB";
+    else
+        return QString::number(size / 1024.0 / 1024.0, 'f', 1) + " MiB";
+}
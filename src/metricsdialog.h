@@ -0,0 +1,54 @@
+#ifndef METRICSDIALOG_H
+#define METRICSDIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+#include <QTreeWidgetItem>
+
+#include "pipelinemetrics.h"
+
+namespace Ui
+{
+class MetricsDialog;
+}
+
+// show the PipelineMetrics of a session, sampled once a second while visible
+class MetricsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsDialog(PipelineMetrics* metrics, QWidget *parent = nullptr);
+    ~MetricsDialog();
+
+signals:
+    void aboutToSample(); // update the backlog and the store sizes there
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+private slots:
+    void on_resetButton_clicked();
+    void on_traceButton_clicked(bool checked);
+    void updateMetrics();
+private:
+    Ui::MetricsDialog *ui;
+    PipelineMetrics* m_metrics;
+    QTimer* m_timer;
+
+    QTreeWidgetItem* m_RxBytesItem;
+    QTreeWidgetItem* m_RxChunksItem;
+    QTreeWidgetItem* m_TxBytesItem;
+    QTreeWidgetItem* m_TxChunksItem;
+    QList<QTreeWidgetItem*> m_backlogItems;
+    QList<QTreeWidgetItem*> m_consumerItems;
+    QTreeWidgetItem* m_replotTimeItem;
+    QTreeWidgetItem* m_replotRateItem;
+    QTreeWidgetItem* m_droppedFramesItem;
+    QList<QTreeWidgetItem*> m_storeItems;
+    QList<QTreeWidgetItem*> m_histogramItems;
+
+    QTreeWidgetItem* addItem(QTreeWidgetItem* parent, const QString& name);
+    static QString sizeToString(qint64 size);
+};
+
+#endif // METRICSDIALOG_H
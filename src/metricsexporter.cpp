@@ -0,0 +1,343 @@
+#include "metricsexporter.h"
+#include "util.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMetaEnum>
+#include <QMutex>
+#include <QTimer>
+
+// the request line and the headers
+static const int maxRequestSize = 8192;
+// drop the idle clients
+static const int clientTimeout = 5000;
+
+static QMutex sessionMutex;
+static QList<QPair<int, PipelineMetrics*>> sessionList;
+static int nextSessionId = 1;
+
+MetricsExporter* MetricsExporter::m_instance = nullptr;
+
+static QByteArray escapeLabel(const QString& value)
+{
+    QByteArray result = value.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    result.replace('\n', "\\n");
+    return result;
+}
+
+static void addFamily(QByteArray& buf, const QByteArray& name, const char* type, const char* help)
+{
+    buf += "# HELP " + name + ' ' + help + '\n';
+    buf += "# TYPE " + name + ' ' + type + '\n';
+}
+
+static void addValue(QByteArray& buf, const QByteArray& name, const QByteArray& labels, qint64 value)
+{
+    buf += name + '{' + labels + "} " + QByteArray::number(value) + '\n';
+}
+
+static void addValue(QByteArray& buf, const QByteArray& name, const QByteArray& labels, double value)
+{
+    buf += name + '{' + labels + "} " + QByteArray::number(value, 'g', 15) + '\n';
+}
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject{parent}
+{
+
+}
+
+void MetricsExporter::addOptions(QCommandLineParser& parser)
+{
+    parser.addOption({"metrics-listen", "Serve the metrics at /metrics in the Prometheus format, address: port, host:port or unix:path", "address"});
+}
+
+bool MetricsExporter::start(const QString& address, QString* errorString)
+{
+    if(m_instance != nullptr)
+        return false;
+    MetricsExporter* exporter = new MetricsExporter;
+    exporter->moveToThread(Util::workerThread(Util::MetricsWorker));
+    // the servers are created in the worker thread
+    bool isOk = false;
+    QMetaObject::invokeMethod(exporter, "listen", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, isOk), Q_ARG(QString, address));
+    if(!isOk)
+    {
+        if(errorString != nullptr)
+            *errorString = exporter->m_errorString;
+        exporter->deleteLater();
+        return false;
+    }
+    m_instance = exporter;
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if(m_instance == nullptr)
+        return;
+    // deleted in the worker thread
+    m_instance->deleteLater();
+    m_instance = nullptr;
+}
+
+bool MetricsExporter::isRunning()
+{
+    return m_instance != nullptr;
+}
+
+void MetricsExporter::addSession(PipelineMetrics* metrics)
+{
+    sessionMutex.lock();
+    sessionList.append({nextSessionId++, metrics});
+    sessionMutex.unlock();
+}
+
+void MetricsExporter::removeSession(PipelineMetrics* metrics)
+{
+    sessionMutex.lock();
+    for(int i = 0; i < sessionList.size(); i++)
+    {
+        if(sessionList[i].second == metrics)
+        {
+            sessionList.removeAt(i);
+            break;
+        }
+    }
+    sessionMutex.unlock();
+}
+
+bool MetricsExporter::listen(const QString& address)
+{
+    if(address.startsWith("unix:"))
+    {
+        QString path = address.mid(5);
+        m_localServer = new QLocalServer(this);
+        // the socket file might be left by a crashed process
+        QLocalServer::removeServer(path);
+        if(!m_localServer->listen(path))
+        {
+            m_errorString = m_localServer->errorString();
+            return false;
+        }
+        connect(m_localServer, &QLocalServer::newConnection, this, [ = ]
+        {
+            while(m_localServer->hasPendingConnections())
+            {
+                QLocalSocket* socket = m_localServer->nextPendingConnection();
+                connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+                onNewClient(socket);
+            }
+        });
+        return true;
+    }
+
+    QString host;
+    quint16 port;
+    bool isOk = Util::parseAddress(address, host, port);
+    QHostAddress hostAddress = host.isEmpty() ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(host);
+    if(!isOk || hostAddress.isNull())
+    {
+        m_errorString = "Invalid address: " + address;
+        return false;
+    }
+    m_TCPServer = new QTcpServer(this);
+    if(!m_TCPServer->listen(hostAddress, port))
+    {
+        m_errorString = m_TCPServer->errorString();
+        return false;
+    }
+    connect(m_TCPServer, &QTcpServer::newConnection, this, [ = ]
+    {
+        while(m_TCPServer->hasPendingConnections())
+        {
+            QTcpSocket* socket = m_TCPServer->nextPendingConnection();
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            onNewClient(socket);
+        }
+    });
+    return true;
+}
+
+void MetricsExporter::onNewClient(QIODevice* socket)
+{
+    m_requests.insert(socket, QByteArray());
+    connect(socket, &QIODevice::readyRead, this, [ = ]
+    {
+        onClientReadyRead(socket);
+    });
+    connect(socket, &QObject::destroyed, this, [ = ]
+    {
+        m_requests.remove(socket);
+    });
+    QTimer::singleShot(clientTimeout, socket, &QObject::deleteLater);
+}
+
+void MetricsExporter::onClientReadyRead(QIODevice* socket)
+{
+    auto it = m_requests.find(socket);
+    if(it == m_requests.end()) // replied
+    {
+        socket->readAll();
+        return;
+    }
+    QByteArray& request = it.value();
+    request += socket->readAll();
+    if(!request.contains("\r\n\r\n") && !request.contains("\n\n"))
+    {
+        if(request.size() > maxRequestSize)
+            reply(socket, "431 Request Header Fields Too Large", QByteArray());
+        return;
+    }
+
+    // GET /metrics HTTP/1.1
+    QList<QByteArray> requestLine = request.left(request.indexOf('\n')).trimmed().split(' ');
+    QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    int queryPos = path.indexOf('?');
+    if(queryPos >= 0)
+        path.truncate(queryPos);
+    if(method != "GET")
+        reply(socket, "405 Method Not Allowed", QByteArray());
+    else if(path != "/metrics" && path != "/")
+        reply(socket, "404 Not Found", QByteArray());
+    else
+        reply(socket, "200 OK", format());
+}
+
+void MetricsExporter::reply(QIODevice* socket, const QByteArray& status, const QByteArray& body)
+{
+    m_requests.remove(socket);
+    QByteArray header = "HTTP/1.1 " + status + "\r\n";
+    header += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+    header += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    header += "Connection: close\r\n\r\n";
+    socket->write(header);
+    socket->write(body);
+    // the pending data is sent before disconnecting
+    QTcpSocket* TCPSocket = qobject_cast<QTcpSocket*>(socket);
+    if(TCPSocket != nullptr)
+        TCPSocket->disconnectFromHost();
+    else
+        qobject_cast<QLocalSocket*>(socket)->disconnectFromServer();
+}
+
+QByteArray MetricsExporter::format()
+{
+    // the sessions are only locked while copying the counters
+    QList<QPair<QByteArray, PipelineMetrics::Totals>> totalsList;
+    sessionMutex.lock();
+    for(const auto& session : sessionList)
+        totalsList.append({"session=\"" + QByteArray::number(session.first) + "\"", session.second->totals()});
+    sessionMutex.unlock();
+
+    QByteArray buf;
+    QByteArray name;
+
+    name = "serialtest_connected";
+    addFamily(buf, name, "gauge", "Whether the connection is established.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.connected);
+    name = "serialtest_connects_total";
+    addFamily(buf, name, "counter", "Established connections, including the reconnections.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.connects);
+    name = "serialtest_reconnects_total";
+    addFamily(buf, name, "counter", "Established connections after the first one.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, qMax((qint64)item.second.connects - 1, 0LL));
+    name = "serialtest_connect_failures_total";
+    addFamily(buf, name, "counter", "Failed attempts to connect.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.connectFailures);
+    name = "serialtest_errors_total";
+    addFamily(buf, name, "counter", "Errors reported by the connection.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.errors);
+
+    name = "serialtest_rx_bytes_total";
+    addFamily(buf, name, "counter", "Received bytes.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.RxBytes);
+    name = "serialtest_tx_bytes_total";
+    addFamily(buf, name, "counter", "Sent bytes.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.TxBytes);
+    name = "serialtest_tx_chunks_total";
+    addFamily(buf, name, "counter", "Write calls.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.TxChunks);
+
+    // the buckets of PipelineMetrics are [2^i, 2^(i+1)), cumulated there
+    name = "serialtest_rx_chunk_bytes";
+    addFamily(buf, name, "histogram", "Size of the received chunks.");
+    for(const auto& item : totalsList)
+    {
+        qint64 count = 0;
+        for(int i = 0; i < PipelineMetrics::histogramSize - 1; i++)
+        {
+            count += item.second.RxHistogram[i];
+            addValue(buf, name + "_bucket", item.first + ",le=\"" + QByteArray::number((1 << (i + 1)) - 1) + "\"", count);
+        }
+        // RxChunks is loaded separately, the total of the same snapshot keeps +Inf >= the finite buckets
+        count += item.second.RxHistogram[PipelineMetrics::histogramSize - 1];
+        addValue(buf, name + "_bucket", item.first + ",le=\"+Inf\"", count);
+        addValue(buf, name + "_sum", item.first, (qint64)item.second.RxBytes);
+        addValue(buf, name + "_count", item.first, count);
+    }
+
+    QMetaEnum consumerEnum = QMetaEnum::fromType<PipelineMetrics::Consumer>();
+    name = "serialtest_consumer_seconds_total";
+    addFamily(buf, name, "counter", "Time spent by the consumers of the received data.");
+    for(const auto& item : totalsList)
+    {
+        for(int i = 0; i < PipelineMetrics::ConsumerNum; i++)
+            addValue(buf, name, item.first + ",consumer=\"" + consumerEnum.valueToKey(i) + "\"", item.second.consumerTime[i] / 1e9);
+    }
+    QMetaEnum backlogEnum = QMetaEnum::fromType<PipelineMetrics::Backlog>();
+    name = "serialtest_backlog_bytes";
+    addFamily(buf, name, "gauge", "Data waiting for the consumers.");
+    for(const auto& item : totalsList)
+    {
+        for(int i = 0; i < PipelineMetrics::BacklogNum; i++)
+            addValue(buf, name, item.first + ",queue=\"" + backlogEnum.valueToKey(i) + "\"", item.second.backlog[i]);
+    }
+    QMetaEnum storeEnum = QMetaEnum::fromType<PipelineMetrics::Store>();
+    name = "serialtest_buffer_bytes";
+    addFamily(buf, name, "gauge", "Memory held by the buffers.");
+    for(const auto& item : totalsList)
+    {
+        for(int i = 0; i < PipelineMetrics::StoreNum; i++)
+            addValue(buf, name, item.first + ",buffer=\"" + storeEnum.valueToKey(i) + "\"", item.second.storeSize[i]);
+    }
+
+    name = "serialtest_replots_total";
+    addFamily(buf, name, "counter", "Finished replots of the plot.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.replots);
+    name = "serialtest_replot_requests_total";
+    addFamily(buf, name, "counter", "Requested replots, the queued ones are merged.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.replotRequests);
+    name = "serialtest_replot_seconds";
+    addFamily(buf, name, "gauge", "Duration of the latest replot.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, item.second.replotTime / 1000);
+
+    name = "serialtest_clients";
+    addFamily(buf, name, "gauge", "Connected clients in the server modes.");
+    for(const auto& item : totalsList)
+        addValue(buf, name, item.first, (qint64)item.second.clients.size());
+    name = "serialtest_client_rx_bytes_total";
+    addFamily(buf, name, "counter", "Bytes received from each client in the server modes.");
+    for(const auto& item : totalsList)
+    {
+        for(const auto& client : item.second.clients)
+            addValue(buf, name, item.first + ",client_id=\"" + QByteArray::number(client.id) + "\",client=\"" + escapeLabel(client.name) + "\"", client.RxBytes);
+    }
+    return buf;
+}
@@ -0,0 +1,45 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QCommandLineParser>
+#include <QHash>
+
+#include "pipelinemetrics.h"
+
+class QTcpServer;
+class QLocalServer;
+
+// serve the PipelineMetrics of all sessions in the Prometheus text format, for --metrics-listen
+// runs in its own worker thread and reads the counters only, a scrape never waits for the sessions
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    static void addOptions(QCommandLineParser& parser);
+    // address: port, host:port or unix:path, the port is bound to localhost if the host is omitted
+    static bool start(const QString& address, QString* errorString = nullptr);
+    // call this before Util::stopWorkerThreads()
+    static void stop();
+    static bool isRunning();
+
+    // thread-safe, the metrics must be removed before being deleted
+    static void addSession(PipelineMetrics* metrics);
+    static void removeSession(PipelineMetrics* metrics);
+    static QByteArray format();
+private:
+    explicit MetricsExporter(QObject *parent = nullptr);
+    QTcpServer* m_TCPServer = nullptr;
+    QLocalServer* m_localServer = nullptr;
+    QString m_errorString;
+    QHash<QIODevice*, QByteArray> m_requests;
+
+    static MetricsExporter* m_instance;
+
+    Q_INVOKABLE bool listen(const QString& address);
+    void onNewClient(QIODevice* socket);
+    void onClientReadyRead(QIODevice* socket);
+    void reply(QIODevice* socket, const QByteArray& status, const QByteArray& body);
+};
+
+#endif // METRICSEXPORTER_H
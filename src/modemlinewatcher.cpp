@@ -0,0 +1,199 @@
+#include "modemlinewatcher.h"
+
+#include <QDebug>
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+// in milliseconds
+// TIOCGICOUNT still counts the pulses shorter than this
+static const int s_sampleInterval = 1;
+#endif
+
+ModemLineWatcher::ModemLineWatcher(QObject *parent)
+    : QThread{parent}
+{
+    setObjectName("ModemLineWatcher");
+}
+
+ModemLineWatcher::~ModemLineWatcher()
+{
+    stop();
+}
+
+bool ModemLineWatcher::start(int fd)
+{
+#ifdef Q_OS_LINUX
+    stop();
+    if(fd < 0)
+        return false;
+
+    // a duplicated descriptor will not be reused by other files before the thread exits
+    m_fd = dup(fd);
+    if(m_fd < 0)
+        return false;
+
+    int lines;
+    if(ioctl(m_fd, TIOCMGET, &lines) < 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(m_wakeFd < 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    serial_icounter_struct counter;
+    m_hasCounter = (ioctl(m_fd, TIOCGICOUNT, &counter) == 0);
+    if(m_hasCounter)
+    {
+        m_baseCount[0] = counter.cts;
+        m_baseCount[1] = counter.dsr;
+        m_baseCount[2] = counter.dcd;
+        m_baseCount[3] = counter.rng;
+    }
+
+    m_edges.clear();
+    QThread::start();
+    return true;
+#else
+    Q_UNUSED(fd)
+    return false;
+#endif
+}
+
+void ModemLineWatcher::stop()
+{
+#ifdef Q_OS_LINUX
+    if(m_fd < 0)
+        return;
+    // the counter stays readable until the thread sees it, no matter when it enters poll()
+    quint64 one = 1;
+    while(::write(m_wakeFd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+    wait();
+    close(m_wakeFd);
+    m_wakeFd = -1;
+    close(m_fd);
+    m_fd = -1;
+#endif
+}
+
+QVector<ModemLineEdge> ModemLineWatcher::takeEdges()
+{
+    QMutexLocker locker(&m_edgeMutex);
+    QVector<ModemLineEdge> result;
+    result.swap(m_edges);
+    return result;
+}
+
+bool ModemLineWatcher::readEdge(ModemLineEdge& edge)
+{
+#ifdef Q_OS_LINUX
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    edge.timestamp = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+
+    int lines;
+    if(ioctl(m_fd, TIOCMGET, &lines) < 0)
+        return false;
+    edge.signal = QSerialPort::NoSignal;
+    if(lines & TIOCM_CTS)
+        edge.signal |= QSerialPort::ClearToSendSignal;
+    if(lines & TIOCM_DSR)
+        edge.signal |= QSerialPort::DataSetReadySignal;
+    if(lines & TIOCM_CD)
+        edge.signal |= QSerialPort::DataCarrierDetectSignal;
+    if(lines & TIOCM_RNG)
+        edge.signal |= QSerialPort::RingIndicatorSignal;
+
+    serial_icounter_struct counter;
+    if(m_hasCounter && ioctl(m_fd, TIOCGICOUNT, &counter) == 0)
+    {
+        edge.CTSCount = counter.cts - m_baseCount[0];
+        edge.DSRCount = counter.dsr - m_baseCount[1];
+        edge.DCDCount = counter.dcd - m_baseCount[2];
+        edge.RICount = counter.rng - m_baseCount[3];
+    }
+    else
+    {
+        // count the visible changes only
+        m_hasCounter = false;
+        edge.CTSCount = edge.DSRCount = edge.DCDCount = edge.RICount = 0;
+    }
+    return true;
+#else
+    Q_UNUSED(edge)
+    return false;
+#endif
+}
+
+void ModemLineWatcher::run()
+{
+#ifdef Q_OS_LINUX
+    ModemLineEdge edge, lastEdge;
+    if(!readEdge(lastEdge))
+    {
+        emit stopped();
+        return;
+    }
+    pollfd wakeItem = {m_wakeFd, POLLIN, 0};
+    while(true)
+    {
+        int result = poll(&wakeItem, 1, s_sampleInterval);
+        if(result < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            qDebug() << "ModemLineWatcher: poll() failed," << strerror(errno);
+            emit stopped();
+            return;
+        }
+        if(result > 0)
+            break; // woken by stop()
+        if(!readEdge(edge))
+        {
+            emit stopped();
+            return;
+        }
+        if(m_hasCounter)
+        {
+            if(edge.signal == lastEdge.signal && edge.CTSCount == lastEdge.CTSCount && edge.DSRCount == lastEdge.DSRCount
+               && edge.DCDCount == lastEdge.DCDCount && edge.RICount == lastEdge.RICount)
+                continue;
+        }
+        else
+        {
+            if(edge.signal == lastEdge.signal)
+                continue;
+            QSerialPort::PinoutSignals changed = edge.signal ^ lastEdge.signal;
+            edge.CTSCount = lastEdge.CTSCount + changed.testFlag(QSerialPort::ClearToSendSignal);
+            edge.DSRCount = lastEdge.DSRCount + changed.testFlag(QSerialPort::DataSetReadySignal);
+            edge.DCDCount = lastEdge.DCDCount + changed.testFlag(QSerialPort::DataCarrierDetectSignal);
+            edge.RICount = lastEdge.RICount + (changed.testFlag(QSerialPort::RingIndicatorSignal) && !edge.signal.testFlag(QSerialPort::RingIndicatorSignal));
+        }
+        lastEdge = edge;
+
+        bool wasEmpty;
+        {
+            QMutexLocker locker(&m_edgeMutex);
+            wasEmpty = m_edges.isEmpty();
+            if(m_edges.size() >= m_maxPendingEdges)
+                m_edges.removeFirst();
+            m_edges.append(edge);
+        }
+        if(wasEmpty)
+            emit edgesAvailable();
+    }
+#endif
+}
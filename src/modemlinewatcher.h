@@ -0,0 +1,52 @@
+#ifndef MODEMLINEWATCHER_H
+#define MODEMLINEWATCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+#include <QSerialPort>
+
+struct ModemLineEdge
+{
+    qint64 timestamp; // CLOCK_MONOTONIC, in nanoseconds
+    QSerialPort::PinoutSignals signal; // the line states after the change
+    // transitions since the watcher is started
+    // RI only counts the trailing edges
+    quint32 CTSCount, DSRCount, DCDCount, RICount;
+};
+
+// watch the modem line changes of a serial port in a helper thread
+// Linux only, the thread samples CTS/DSR/DCD/RI every millisecond, TIOCGICOUNT counts the transitions between samples
+// TIOCMIWAIT is not used, only a signal could interrupt it when the port is closed
+class ModemLineWatcher : public QThread
+{
+    Q_OBJECT
+public:
+    explicit ModemLineWatcher(QObject *parent = nullptr);
+    ~ModemLineWatcher();
+
+    // return false if the port doesn't support it, use polling instead
+    bool start(int fd);
+    void stop();
+    QVector<ModemLineEdge> takeEdges();
+signals:
+    // emitted when the pending list becomes non-empty
+    void edgesAvailable();
+    // the port stopped reporting the changes, emitted once
+    void stopped();
+protected:
+    void run() override;
+private:
+    int m_fd = -1;
+    int m_wakeFd = -1; // eventfd, written by stop()
+    quint32 m_baseCount[4] = {0};
+    bool m_hasCounter = false;
+
+    QMutex m_edgeMutex;
+    QVector<ModemLineEdge> m_edges;
+    static const int m_maxPendingEdges = 4096;
+
+    bool readEdge(ModemLineEdge& edge);
+};
+
+#endif // MODEMLINEWATCHER_H
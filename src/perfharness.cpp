@@ -0,0 +1,231 @@
+#include "perfharness.h"
+#include "mainwindow.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <stdio.h>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+// a tick later than this is counted as a stall
+static const qint64 tickInterval = 10;
+static const qint64 stallThreshold = 100;
+// wait for the plot timer after the connection is closed
+static const int settleTime = 500;
+
+static const QStringList scenarioList = {"text+plot", "text", "plot", "off"};
+
+static void printMessage(const QString& msg)
+{
+    fputs(qPrintable(msg + "\n"), stderr);
+    fflush(stderr);
+}
+
+// in KiB, -1 if not supported
+static qint64 getPeakRSS()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef Q_OS_MACOS
+        return usage.ru_maxrss / 1024; // in bytes
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    return -1;
+}
+
+// in ms, -1 if not supported
+static void getCPUTime(qint64& user, qint64& system)
+{
+    user = system = -1;
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if(GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        // in 100ns
+        user = (((quint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime) / 10000;
+        system = (((quint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) / 10000;
+    }
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        user = usage.ru_utime.tv_sec * 1000LL + usage.ru_utime.tv_usec / 1000;
+        system = usage.ru_stime.tv_sec * 1000LL + usage.ru_stime.tv_usec / 1000;
+    }
+#endif
+}
+
+PerfHarness::PerfHarness(MainWindow *window)
+    : QObject{window}
+{
+    m_window = window;
+    m_connection = window->connection();
+
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    m_tickTimer->setInterval(tickInterval);
+    connect(m_tickTimer, &QTimer::timeout, this, &PerfHarness::onTick);
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(50);
+    connect(m_pollTimer, &QTimer::timeout, this, &PerfHarness::poll);
+}
+
+void PerfHarness::addOptions(QCommandLineParser& parser)
+{
+    parser.addOption({"perf-scenario", "(perf)Receive from the Generator then exit, scenario: " + scenarioList.join(", "), "scenario"});
+    parser.addOption({"perf-bytes", "(perf)Bytes to receive, 10485760 by default", "bytes"});
+    parser.addOption({"perf-rate", "(perf)Generator rate in bytes/s, 0 for max, 92160(921600 baud) by default", "rate"});
+    parser.addOption({"perf-report", "(perf)Write the report to the file instead of stdout", "file"});
+}
+
+void PerfHarness::start(const QCommandLineParser& parser)
+{
+    bool isOk = true;
+    m_scenario = parser.value("perf-scenario");
+    if(!scenarioList.contains(m_scenario))
+    {
+        fail("Unknown scenario: " + m_scenario + ", available: " + scenarioList.join(", "));
+        return;
+    }
+    m_targetBytes = parser.isSet("perf-bytes") ? parser.value("perf-bytes").toLongLong(&isOk) : 10485760;
+    if(!isOk || m_targetBytes <= 0)
+    {
+        fail("Invalid byte count: " + parser.value("perf-bytes"));
+        return;
+    }
+    m_rate = parser.isSet("perf-rate") ? parser.value("perf-rate").toLongLong(&isOk) : 92160;
+    if(!isOk || m_rate < 0)
+    {
+        fail("Invalid rate: " + parser.value("perf-rate"));
+        return;
+    }
+    m_reportPath = parser.value("perf-report");
+    // 3 times of the expected time
+    m_timeout = (m_rate > 0 ? m_targetBytes * 1000 / m_rate * 3 : 0) + 30000;
+
+    // the checkboxes are not saved to the config
+    m_window->setRxViews(m_scenario.startsWith("text"), m_scenario.endsWith("plot"));
+
+    Connection::GeneratorArgument arg;
+    arg.workload = DataGenerator::SineCSV;
+    arg.rate = m_rate;
+    m_connection->setType(Connection::Generator);
+    m_connection->setArgument(arg);
+    connect(m_connection, &Connection::connected, this, &PerfHarness::onConnected);
+    connect(m_connection, &Connection::connectFailed, this, &PerfHarness::onConnectFailed);
+    // after the window is shown
+    QTimer::singleShot(0, m_connection, &Connection::open);
+}
+
+void PerfHarness::onConnected()
+{
+    m_clock.start();
+    m_lastTick = 0;
+    m_tickTimer->start();
+    m_pollTimer->start();
+}
+
+void PerfHarness::onConnectFailed(const QString& info)
+{
+    fail("Failed to start the generator: " + info);
+}
+
+void PerfHarness::onTick()
+{
+    qint64 now = m_clock.elapsed();
+    qint64 stall = now - m_lastTick - tickInterval;
+    m_lastTick = now;
+    m_maxStall = qMax(m_maxStall, stall);
+    if(stall >= stallThreshold)
+    {
+        m_stallCount++;
+        m_stallTotal += stall;
+    }
+}
+
+void PerfHarness::poll()
+{
+    m_receivedBytes = m_window->RxCount();
+    if(m_producedBytes < 0)
+    {
+        if(m_connection->Generator_producedBytes() >= m_targetBytes)
+            m_producedBytes = m_connection->Generator_producedBytes();
+    }
+    m_timedOut = m_clock.elapsed() > m_timeout;
+    if((m_producedBytes >= 0 && m_receivedBytes >= m_producedBytes) || m_timedOut)
+    {
+        m_elapsed = m_clock.elapsed();
+        m_pollTimer->stop();
+        m_tickTimer->stop();
+        if(m_producedBytes < 0)
+            m_producedBytes = m_connection->Generator_producedBytes();
+        // the Rx UI is flushed when disconnected
+        m_connection->close();
+        QTimer::singleShot(settleTime, this, &PerfHarness::finish);
+    }
+}
+
+void PerfHarness::finish()
+{
+    qint64 user, system;
+    getCPUTime(user, system);
+
+    QJsonObject report;
+    report["scenario"] = m_scenario;
+    report["targetBytes"] = m_targetBytes;
+    report["rate"] = m_rate;
+    report["producedBytes"] = m_producedBytes;
+    report["receivedBytes"] = m_receivedBytes;
+    report["droppedBytes"] = qMax(m_producedBytes - m_receivedBytes, 0LL);
+    report["elapsedMs"] = m_elapsed;
+    report["throughput"] = m_elapsed > 0 ? m_receivedBytes * 1000.0 / m_elapsed : 0.0;
+    report["cpuUserMs"] = user;
+    report["cpuSystemMs"] = system;
+    report["peakRssKiB"] = getPeakRSS();
+    report["maxStallMs"] = m_maxStall;
+    report["stallCount"] = m_stallCount;
+    report["stallTotalMs"] = m_stallTotal;
+    report["timedOut"] = m_timedOut;
+    QByteArray json = QJsonDocument(report).toJson();
+
+    bool isOk;
+    QFile file;
+    if(m_reportPath.isEmpty())
+        isOk = file.open(stdout, QIODevice::WriteOnly);
+    else
+    {
+        file.setFileName(m_reportPath);
+        isOk = file.open(QIODevice::WriteOnly);
+    }
+    if(!isOk || file.write(json) != json.size())
+    {
+        fail("Cannot write the report: " + file.errorString());
+        return;
+    }
+    file.close();
+    QMetaObject::invokeMethod(qApp, "exit", Qt::QueuedConnection, Q_ARG(int, m_timedOut ? 2 : 0));
+}
+
+void PerfHarness::fail(const QString& info)
+{
+    printMessage(info);
+    m_pollTimer->stop();
+    m_tickTimer->stop();
+    // the event loop might not be started yet
+    QMetaObject::invokeMethod(qApp, "exit", Qt::QueuedConnection, Q_ARG(int, 1));
+}
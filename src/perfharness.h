@@ -0,0 +1,55 @@
+#ifndef PERFHARNESS_H
+#define PERFHARNESS_H
+
+#include <QObject>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+
+class MainWindow;
+class Connection;
+
+// drive the Rx pipeline of a session with the Generator, for --perf-scenario
+// the scenarios are the ones in performance.txt, the report is written in JSON
+// run each scenario in a new process, the peak RSS never goes down
+class PerfHarness : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PerfHarness(MainWindow *window);
+
+    static void addOptions(QCommandLineParser& parser);
+    // exits the application when finished
+    void start(const QCommandLineParser& parser);
+private slots:
+    void onConnected();
+    void onConnectFailed(const QString& info);
+    void onTick();
+    void poll();
+    void finish();
+private:
+    MainWindow* m_window;
+    Connection* m_connection;
+    QString m_scenario;
+    QString m_reportPath;
+    qint64 m_targetBytes = 0;
+    qint64 m_rate = 0;
+    qint64 m_timeout = 0;
+    bool m_timedOut = false;
+
+    QTimer* m_tickTimer;
+    QTimer* m_pollTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastTick = 0;
+    qint64 m_maxStall = 0;
+    qint64 m_stallCount = 0;
+    qint64 m_stallTotal = 0;
+
+    qint64 m_producedBytes = -1; // when the target is reached
+    qint64 m_receivedBytes = 0;
+    qint64 m_elapsed = 0;
+
+    void fail(const QString& info);
+};
+
+#endif // PERFHARNESS_H
@@ -0,0 +1,224 @@
+#include "pipelinemetrics.h"
+#include "connection.h"
+
+#include <QtAlgorithms>
+
+PipelineMetrics::PipelineMetrics(QObject *parent)
+    : QObject{parent}
+{
+    reset();
+}
+
+void PipelineMetrics::addRx(qint64 len)
+{
+    if(len <= 0)
+        return;
+    m_RxBytes.fetchAndAddRelaxed(len);
+    m_RxChunks.fetchAndAddRelaxed(1);
+    // the index of the highest set bit
+    int bucket = qMin(63 - qCountLeadingZeroBits((quint64)len), histogramSize - 1);
+    m_RxHistogram[bucket].fetchAndAddRelaxed(1);
+}
+
+void PipelineMetrics::addTx(qint64 len)
+{
+    if(len <= 0)
+        return;
+    m_TxBytes.fetchAndAddRelaxed(len);
+    m_TxChunks.fetchAndAddRelaxed(1);
+}
+
+void PipelineMetrics::addConsumerTime(Consumer consumer, qint64 nsecs)
+{
+    m_consumerTime[consumer].fetchAndAddRelaxed(nsecs);
+}
+
+void PipelineMetrics::addReplotRequest()
+{
+    m_replotRequests.fetchAndAddRelaxed(1);
+}
+
+void PipelineMetrics::addReplot(double msecs)
+{
+    m_replots.fetchAndAddRelaxed(1);
+    m_lastReplotTime.storeRelease((qint64)(msecs * 1000));
+}
+
+void PipelineMetrics::setBacklog(Backlog backlog, qint64 size)
+{
+    m_backlog[backlog].storeRelease(size);
+}
+
+void PipelineMetrics::setStoreSize(Store store, qint64 size)
+{
+    m_storeSize[store].storeRelease(size);
+}
+
+void PipelineMetrics::watchConnection(Connection* connection)
+{
+    m_connection = connection;
+    // every chunk read from the port, before the readers merge them
+    connect(connection, &Connection::dataArrived, this, [ = ](const QByteArray & data)
+    {
+        addRx(data.size());
+    }, Qt::DirectConnection);
+    connect(connection, &Connection::connected, this, [ = ]
+    {
+        m_connects.fetchAndAddRelaxed(1);
+        m_connected.storeRelease(1);
+    });
+    connect(connection, &Connection::disconnected, this, [ = ]
+    {
+        m_connected.storeRelease(0);
+    });
+    connect(connection, &Connection::connectFailed, this, [ = ]
+    {
+        m_connectFailures.fetchAndAddRelaxed(1);
+    });
+    connect(connection, &Connection::errorOccurred, this, [ = ]
+    {
+        m_errors.fetchAndAddRelaxed(1);
+    });
+}
+
+void PipelineMetrics::updateConnectionGauges()
+{
+    if(m_connection.isNull())
+        return;
+    Connection::Type type = m_connection->type();
+    bool isOpened = m_connection->state() != Connection::Unconnected;
+    setBacklog(TxQueueBacklog, isOpened ? m_connection->bytesToWrite() : 0);
+
+    QList<Client> clients;
+    if(isOpened && (type == Connection::BT_Server || type == Connection::TCP_Server || type == Connection::Unix_Server))
+    {
+        QMap<int, QString> clientMap = m_connection->Server_clientMap();
+        for(auto it = clientMap.cbegin(); it != clientMap.cend(); ++it)
+            clients.append({it.key(), it.value(), m_connection->Server_clientRxCount(it.key())});
+    }
+    m_clientMutex.lock();
+    m_clients.swap(clients);
+    m_clientMutex.unlock();
+    // the old list is freed there, outside the lock
+}
+
+PipelineMetrics::Sample PipelineMetrics::sample()
+{
+    Sample result;
+    double seconds = m_clock.nsecsElapsed() / 1e9;
+    m_clock.start();
+    if(seconds <= 0)
+        seconds = 1;
+
+    quint64 val;
+    val = m_RxBytes.loadAcquire();
+    result.RxBytesRate = (val - m_lastRxBytes) / seconds;
+    m_lastRxBytes = val;
+    val = m_RxChunks.loadAcquire();
+    result.RxChunksRate = (val - m_lastRxChunks) / seconds;
+    m_lastRxChunks = val;
+    val = m_TxBytes.loadAcquire();
+    result.TxBytesRate = (val - m_lastTxBytes) / seconds;
+    m_lastTxBytes = val;
+    val = m_TxChunks.loadAcquire();
+    result.TxChunksRate = (val - m_lastTxChunks) / seconds;
+    m_lastTxChunks = val;
+
+    result.RxHistogram.resize(histogramSize);
+    for(int i = 0; i < histogramSize; i++)
+    {
+        val = m_RxHistogram[i].loadAcquire();
+        result.RxHistogram[i] = val - m_lastRxHistogram[i];
+        m_lastRxHistogram[i] = val;
+    }
+    result.consumerLoad.resize(ConsumerNum);
+    for(int i = 0; i < ConsumerNum; i++)
+    {
+        val = m_consumerTime[i].loadAcquire();
+        result.consumerLoad[i] = (val - m_lastConsumerTime[i]) / 1e6 / seconds;
+        m_lastConsumerTime[i] = val;
+    }
+
+    quint64 requests = m_replotRequests.loadAcquire();
+    quint64 replots = m_replots.loadAcquire();
+    // the queued replots are merged, the merged ones are never shown
+    result.droppedFrames = qMax((qint64)(requests - m_lastReplotRequests) - (qint64)(replots - m_lastReplots), 0LL);
+    result.replotRate = (replots - m_lastReplots) / seconds;
+    result.replotTime = m_lastReplotTime.loadAcquire() / 1000.0;
+    m_lastReplotRequests = requests;
+    m_lastReplots = replots;
+
+    result.backlog.resize(BacklogNum);
+    for(int i = 0; i < BacklogNum; i++)
+        result.backlog[i] = m_backlog[i].loadAcquire();
+    result.storeSize.resize(StoreNum);
+    for(int i = 0; i < StoreNum; i++)
+        result.storeSize[i] = m_storeSize[i].loadAcquire();
+    return result;
+}
+
+PipelineMetrics::Totals PipelineMetrics::totals() const
+{
+    Totals result;
+    result.RxBytes = m_RxBytes.loadAcquire();
+    result.RxChunks = m_RxChunks.loadAcquire();
+    result.TxBytes = m_TxBytes.loadAcquire();
+    result.TxChunks = m_TxChunks.loadAcquire();
+    result.RxHistogram.resize(histogramSize);
+    for(int i = 0; i < histogramSize; i++)
+        result.RxHistogram[i] = m_RxHistogram[i].loadAcquire();
+    result.consumerTime.resize(ConsumerNum);
+    for(int i = 0; i < ConsumerNum; i++)
+        result.consumerTime[i] = m_consumerTime[i].loadAcquire();
+    result.replotRequests = m_replotRequests.loadAcquire();
+    result.replots = m_replots.loadAcquire();
+    result.replotTime = m_lastReplotTime.loadAcquire() / 1000.0;
+    result.connects = m_connects.loadAcquire();
+    result.connectFailures = m_connectFailures.loadAcquire();
+    result.errors = m_errors.loadAcquire();
+    result.connected = m_connected.loadAcquire() != 0;
+    result.backlog.resize(BacklogNum);
+    for(int i = 0; i < BacklogNum; i++)
+        result.backlog[i] = m_backlog[i].loadAcquire();
+    result.storeSize.resize(StoreNum);
+    for(int i = 0; i < StoreNum; i++)
+        result.storeSize[i] = m_storeSize[i].loadAcquire();
+    // implicitly shared, no deep copy while locked
+    m_clientMutex.lock();
+    result.clients = m_clients;
+    m_clientMutex.unlock();
+    return result;
+}
+
+void PipelineMetrics::reset()
+{
+    m_RxBytes.storeRelease(0);
+    m_RxChunks.storeRelease(0);
+    m_TxBytes.storeRelease(0);
+    m_TxChunks.storeRelease(0);
+    for(int i = 0; i < histogramSize; i++)
+    {
+        m_RxHistogram[i].storeRelease(0);
+        m_lastRxHistogram[i] = 0;
+    }
+    for(int i = 0; i < ConsumerNum; i++)
+    {
+        m_consumerTime[i].storeRelease(0);
+        m_lastConsumerTime[i] = 0;
+    }
+    m_replotRequests.storeRelease(0);
+    m_replots.storeRelease(0);
+    m_lastReplotTime.storeRelease(0);
+    for(int i = 0; i < BacklogNum; i++)
+        m_backlog[i].storeRelease(0);
+    for(int i = 0; i < StoreNum; i++)
+        m_storeSize[i].storeRelease(0);
+    m_connects.storeRelease(0);
+    m_connectFailures.storeRelease(0);
+    m_errors.storeRelease(0);
+    // the connection state is kept
+    m_lastRxBytes = m_lastRxChunks = 0;
+    m_lastTxBytes = m_lastTxChunks = 0;
+    m_lastReplotRequests = m_lastReplots = 0;
+    m_clock.start();
+}
@@ -0,0 +1,152 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QPointer>
+#include <QVector>
+
+class Connection;
+
+// counters of the Rx/Tx pipeline of a session
+// the counters are lock-free and only added in the hot paths,
+// the rates are calculated in sample(), which is called once a second by the viewer
+// totals() is for the exporter, it can be called from any thread
+class PipelineMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    // the receivers of updateRxUI() and the plot timer
+    enum Consumer
+    {
+        TextView = 0,
+        PlotFeed,
+        PlotParse,
+        FileXceiver,
+        ConsumerNum,
+    };
+    Q_ENUM(Consumer)
+
+    // the data waiting for the consumers, set by the owner before sampling
+    enum Backlog
+    {
+        RxUIBacklog = 0,
+        PlotUIBacklog,
+        PlotBufBacklog,
+        TxQueueBacklog,
+        BacklogNum,
+    };
+    Q_ENUM(Backlog)
+
+    // the memory held by the buffers, set by the owner before sampling
+    enum Store
+    {
+        RawRx = 0,
+        RawTx,
+        RxUIBuf,
+        PlotUIBuf,
+        PlotBuf,
+        TextDocument,
+        PlotGraph,
+        StoreNum,
+    };
+    Q_ENUM(Store)
+
+    // bucket i: [2^i, 2^(i+1)), the last one has all the larger chunks
+    static const int histogramSize = 17;
+
+    struct Sample
+    {
+        double RxBytesRate = 0;
+        double RxChunksRate = 0;
+        double TxBytesRate = 0;
+        double TxChunksRate = 0;
+        QVector<qint64> RxHistogram; // in this period
+        QVector<double> consumerLoad; // ms per second
+        double replotTime = 0; // the latest one in ms
+        double replotRate = 0;
+        qint64 droppedFrames = 0; // in this period
+        QVector<qint64> backlog;
+        QVector<qint64> storeSize;
+    };
+
+    // for the server modes
+    struct Client
+    {
+        int id;
+        QString name;
+        qint64 RxBytes;
+    };
+
+    // the cumulative values since the last reset()
+    struct Totals
+    {
+        quint64 RxBytes = 0;
+        quint64 RxChunks = 0;
+        quint64 TxBytes = 0;
+        quint64 TxChunks = 0;
+        QVector<quint64> RxHistogram;
+        QVector<quint64> consumerTime; // in ns
+        quint64 replotRequests = 0;
+        quint64 replots = 0;
+        double replotTime = 0; // the latest one in ms
+        quint64 connects = 0;
+        quint64 connectFailures = 0;
+        quint64 errors = 0;
+        bool connected = false;
+        QVector<qint64> backlog;
+        QVector<qint64> storeSize;
+        QList<Client> clients;
+    };
+
+    explicit PipelineMetrics(QObject *parent = nullptr);
+
+    void addRx(qint64 len);
+    void addTx(qint64 len);
+    void addConsumerTime(Consumer consumer, qint64 nsecs);
+    void addReplotRequest();
+    void addReplot(double msecs);
+    void setBacklog(Backlog backlog, qint64 size);
+    void setStoreSize(Store store, qint64 size);
+
+    // count the received chunks and the connection events, the connection should live as long as this
+    void watchConnection(Connection* connection);
+    // update the Tx queue and the client list, called by the owner before sampling
+    void updateConnectionGauges();
+
+    Sample sample();
+    Totals totals() const;
+    void reset();
+private:
+    QAtomicInteger<quint64> m_RxBytes;
+    QAtomicInteger<quint64> m_RxChunks;
+    QAtomicInteger<quint64> m_TxBytes;
+    QAtomicInteger<quint64> m_TxChunks;
+    QAtomicInteger<quint64> m_RxHistogram[histogramSize];
+    QAtomicInteger<quint64> m_consumerTime[ConsumerNum]; // in ns
+    QAtomicInteger<quint64> m_replotRequests;
+    QAtomicInteger<quint64> m_replots;
+    QAtomicInteger<qint64> m_lastReplotTime; // in us
+    QAtomicInteger<qint64> m_backlog[BacklogNum];
+    QAtomicInteger<qint64> m_storeSize[StoreNum];
+    QAtomicInteger<quint64> m_connects;
+    QAtomicInteger<quint64> m_connectFailures;
+    QAtomicInteger<quint64> m_errors;
+    QAtomicInt m_connected;
+    // replaced as a whole by the owner, the readers only copy it
+    mutable QMutex m_clientMutex;
+    QList<Client> m_clients;
+    QPointer<Connection> m_connection;
+
+    // the values of the last sample()
+    QElapsedTimer m_clock;
+    quint64 m_lastRxBytes = 0, m_lastRxChunks = 0;
+    quint64 m_lastTxBytes = 0, m_lastTxChunks = 0;
+    quint64 m_lastRxHistogram[histogramSize] = {0};
+    quint64 m_lastConsumerTime[ConsumerNum] = {0};
+    quint64 m_lastReplotRequests = 0, m_lastReplots = 0;
+};
+
+#endif // PIPELINEMETRICS_H
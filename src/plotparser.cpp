@@ -0,0 +1,93 @@
+#include "plotparser.h"
+
+#include <QDebug>
+
+PlotParser::PlotParser()
+{
+    m_doubleRegex.setPattern("-?\\d*\\.?\\d+"); // for +xxxxx and xxxxx. , just get xxxxx
+    m_doubleRegex.optimize();
+}
+
+PlotParser::~PlotParser()
+{
+    delete m_decoder;
+}
+
+void PlotParser::setDecoder(QTextDecoder *decoder)
+{
+    delete m_decoder;
+    m_decoder = decoder;
+}
+
+void PlotParser::setFrameSeparator(const QString& separator)
+{
+    m_frameSeparator = separator;
+}
+
+void PlotParser::setDataSeparator(const QString& separator)
+{
+    m_dataSeparator = separator;
+}
+
+void PlotParser::setClearFlag(const QString& flag)
+{
+    m_clearFlag = flag;
+}
+
+void PlotParser::append(const QByteArray& data)
+{
+    if(m_decoder == nullptr)
+        return;
+    m_buf.append(m_decoder->toUnicode(data));
+}
+
+void PlotParser::clear()
+{
+    m_buf.clear();
+}
+
+bool PlotParser::isEmpty() const
+{
+    return m_buf.isEmpty();
+}
+
+int PlotParser::size() const
+{
+    return m_buf.size();
+}
+
+qint64 PlotParser::memorySize() const
+{
+    return m_buf.capacity() * sizeof(QChar);
+}
+
+PlotParser::FrameType PlotParser::nextFrame(QVector<double>& values, int maxNum)
+{
+    values.clear();
+    int i;
+    if(m_frameSeparator.isEmpty() || (i = m_buf.indexOf(m_frameSeparator)) == -1)
+    {
+        if(m_buf.size() > 1024 * 1024 * 256) // 256MB threshold
+        {
+            qDebug() << "plotBuf full!";
+            m_buf.clear();
+        }
+        return NoFrame;
+    }
+
+    QStringList dataList = m_buf.left(i).split(m_dataSeparator);
+    // qDebug() << dataList;
+    m_buf.remove(0, i + m_frameSeparator.length());
+    if(!m_clearFlag.isEmpty() && dataList[0] == m_clearFlag)
+        return ClearFrame;
+    int num = qMin(maxNum, dataList.size());
+    values.reserve(num);
+    for(i = 0; i < num; i++)
+        values.append(toDouble(dataList[i]));
+    return DataFrame;
+}
+
+double PlotParser::toDouble(const QString& str) const
+{
+    return m_doubleRegex.match(str).captured().toDouble();
+}
@@ -0,0 +1,46 @@
+#ifndef PLOTPARSER_H
+#define PLOTPARSER_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextDecoder>
+#include <QRegularExpression>
+#include <QVector>
+
+// split the received text into frames, then into values
+// used by PlotTab, no widgets are involved
+class PlotParser
+{
+public:
+    enum FrameType
+    {
+        NoFrame = 0, // no complete frame in the buffer
+        DataFrame,
+        ClearFrame,
+    };
+
+    PlotParser();
+    ~PlotParser();
+
+    void setDecoder(QTextDecoder* decoder); // takes the ownership
+    void setFrameSeparator(const QString& separator);
+    void setDataSeparator(const QString& separator);
+    void setClearFlag(const QString& flag); // empty to disable
+    void append(const QByteArray& data);
+    void clear();
+    bool isEmpty() const;
+    int size() const; // in QChar
+    qint64 memorySize() const;
+    // take the next complete frame, at most maxNum values are converted
+    FrameType nextFrame(QVector<double>& values, int maxNum);
+    double toDouble(const QString& str) const; // find valid value then convert
+private:
+    QString m_buf;
+    QTextDecoder* m_decoder = nullptr;
+    QString m_frameSeparator;
+    QString m_dataSeparator;
+    QString m_clearFlag;
+    QRegularExpression m_doubleRegex;
+};
+
+#endif // PLOTPARSER_H
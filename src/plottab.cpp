@@ -2,6 +2,7 @@
 #include "ui_plottab.h"
 
 #include "legenditemdialog.h"
+#include "tracer.h"
 
 PlotTab::PlotTab(QWidget *parent) :
     QWidget(parent),
@@ -9,13 +10,16 @@ PlotTab::PlotTab(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    doubleRegex = new QRegularExpression("-?\\d*\\.?\\d+"); // for +xxxxx and xxxxx. , just get xxxxx
-    doubleRegex->optimize();
+    m_parser = new PlotParser;
     on_plot_advancedBox_stateChanged(Qt::Unchecked); // hide
+
+    setClientList(QMap<int, QString>());
+    connect(ui->plot_clientBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &PlotTab::RxClientChanged);
 }
 
 PlotTab::~PlotTab()
 {
+    delete m_parser;
     delete ui;
 }
 
@@ -48,7 +52,6 @@ void PlotTab::setReplotInterval(int msec)
 void PlotTab::initQCP()
 {
     // init
-    plotBuf = new QString();
     plotTracer = new QCPItemTracer(ui->qcpWidget);
     plotText = new QCPItemText(ui->qcpWidget);
     m_dataProcessTimer = new QTimer();
@@ -91,6 +94,17 @@ void PlotTab::initQCP()
     connect(ui->qcpWidget, &QCustomPlot::axisDoubleClick, this, &PlotTab::onQCPAxisDoubleClick);
     connect(ui->qcpWidget, &QCustomPlot::mousePress, this, &PlotTab::onQCPMousePress);
     connect(ui->qcpWidget, &QCustomPlot::mouseRelease, this, &PlotTab::onQCPMouseRelease);
+    connect(ui->qcpWidget, &QCustomPlot::beforeReplot, this, [ = ]
+    {
+        m_replotStart = Tracer::isEnabled() ? Tracer::now() : -1;
+    });
+    connect(ui->qcpWidget, &QCustomPlot::afterReplot, this, [ = ]
+    {
+        if(m_metrics != nullptr)
+            m_metrics->addReplot(ui->qcpWidget->replotTime());
+        if(m_replotStart >= 0 && Tracer::isEnabled())
+            Tracer::addEvent("QCustomPlot::replot", m_replotStart, Tracer::now());
+    });
 }
 
 void PlotTab::onQCPLegendDoubleClick(QCPLegend *legend, QCPAbstractLegendItem *item, QMouseEvent* event)
@@ -210,7 +224,7 @@ void PlotTab::on_plot_clearButton_clicked()
     num = ui->qcpWidget->graphCount();
     for(int i = 0; i < num; i++)
         ui->qcpWidget->graph(i)->data()->clear(); // use data()->clear() rather than data().clear()
-    plotBuf->clear();
+    m_parser->clear();
     ui->qcpWidget->replot();
 }
 
@@ -309,6 +323,7 @@ void PlotTab::on_plot_frameSpTypeBox_currentIndexChanged(int index)
         plotFrameSeparator = "\r\n";
     else if(index == 3)
         plotFrameSeparator = "\n";
+    m_parser->setFrameSeparator(plotFrameSeparator);
 }
 
 void PlotTab::on_plot_dataSpTypeBox_currentIndexChanged(int index)
@@ -333,6 +348,7 @@ void PlotTab::on_plot_dataSpTypeBox_currentIndexChanged(int index)
         plotDataSeparator = "\r\n";
     else if(index == 3)
         plotDataSeparator = "\n";
+    m_parser->setDataSeparator(plotDataSeparator);
 }
 
 
@@ -345,6 +361,7 @@ void PlotTab::on_plot_clearFlagTypeBox_currentIndexChanged(int index)
         plotClearFlag = ui->plot_clearFlagEdit->text();
     else if(index == 2)
         plotClearFlag = QByteArray::fromHex(ui->plot_clearFlagEdit->text().toLatin1());
+    m_parser->setClearFlag(plotClearFlag);
 }
 
 
@@ -507,9 +524,59 @@ bool PlotTab::enabled()
     return ui->plot_enaBox->isChecked();
 }
 
+void PlotTab::setPlotEnabled(bool enabled)
+{
+    ui->plot_enaBox->setChecked(enabled);
+}
+
+void PlotTab::setMetrics(PipelineMetrics* metrics)
+{
+    m_metrics = metrics;
+}
+
+int PlotTab::parserBacklog()
+{
+    return m_parser->size();
+}
+
+qint64 PlotTab::parserMemory()
+{
+    return m_parser->memorySize();
+}
+
+qint64 PlotTab::graphMemory()
+{
+    qint64 result = 0;
+    for(int i = 0; i < ui->qcpWidget->graphCount(); i++)
+        result += ui->qcpWidget->graph(i)->data()->size() * sizeof(QCPGraphData);
+    return result;
+}
+
+void PlotTab::setClientList(const QMap<int, QString>& clientMap)
+{
+    int currId = ui->plot_clientBox->count() > 0 ? RxClientId() : -1;
+    ui->plot_clientBox->blockSignals(true);
+    ui->plot_clientBox->clear();
+    ui->plot_clientBox->addItem(tr("All clients"), -1);
+    for(auto it = clientMap.cbegin(); it != clientMap.cend(); ++it)
+        ui->plot_clientBox->addItem(it.value(), it.key());
+    int index = ui->plot_clientBox->findData(currId);
+    ui->plot_clientBox->setCurrentIndex(qMax(index, 0));
+    ui->plot_clientBox->blockSignals(false);
+    ui->plot_clientBox->setVisible(!clientMap.isEmpty());
+    // the selected client is disconnected
+    if(index < 0)
+        emit RxClientChanged();
+}
+
+int PlotTab::RxClientId()
+{
+    return ui->plot_clientBox->currentData().toInt();
+}
+
 void PlotTab::newData(const QByteArray& data)
 {
-    plotBuf->append(decoder->toUnicode(data));
+    m_parser->append(data);
 }
 
 void PlotTab::processData()
@@ -517,51 +584,52 @@ void PlotTab::processData()
     double currKey = 0;
     bool hasData = false;
     int i;
-    QStringList dataList;
-    if(plotBuf->isEmpty())
+    QVector<double> values;
+    PlotParser::FrameType frameType;
+    QElapsedTimer timer;
+    qint64 parseTime = 0;
+    if(m_parser->isEmpty())
         return;
+    TraceScope scope("PlotTab::processData");
+
+    timer.start();
 
-    while((i = plotBuf->indexOf(plotFrameSeparator)) != -1)
+    while((frameType = m_parser->nextFrame(values, ui->plot_dataNumBox->value())) != PlotParser::NoFrame)
     {
         hasData = true;
-        dataList = ((QString)(plotBuf->left(i))).split(plotDataSeparator);
-        // qDebug() << dataList;
-        plotBuf->remove(0, i + plotFrameSeparator.length());
         plotCounter++;
-        if(!plotClearFlag.isEmpty() && dataList[0] == plotClearFlag)
+        if(frameType == PlotParser::ClearFrame)
         {
             on_plot_clearButton_clicked();
         }
         else if(ui->plot_XTypeBox->currentIndex() == 0)
         {
             currKey = plotCounter;
-            for(i = 0; i < ui->plot_dataNumBox->value() && i < dataList.length(); i++)
-                ui->qcpWidget->graph(i)->addData(currKey, toDouble(dataList[i]));
+            for(i = 0; i < values.size(); i++)
+                ui->qcpWidget->graph(i)->addData(currKey, values[i]);
         }
         else if(ui->plot_XTypeBox->currentIndex() == 1)
         {
-            currKey = toDouble(dataList[0]);
-            for(i = 1; i < ui->plot_dataNumBox->value() && i < dataList.length(); i++)
-                ui->qcpWidget->graph(i - 1)->addData(currKey, toDouble(dataList[i]));
+            currKey = values.value(0);
+            for(i = 1; i < values.size(); i++)
+                ui->qcpWidget->graph(i - 1)->addData(currKey, values[i]);
         }
         else if(ui->plot_XTypeBox->currentIndex() == 2)
         {
             currKey = plotTime.msecsTo(QTime::currentTime()) / 1000.0;
-            for(i = 0; i < ui->plot_dataNumBox->value() && i < dataList.length(); i++)
-                ui->qcpWidget->graph(i)->addData(currKey, toDouble(dataList[i]));
+            for(i = 0; i < values.size(); i++)
+                ui->qcpWidget->graph(i)->addData(currKey, values[i]);
         }
+        // the nested event handlers are measured by themselves
+        parseTime += timer.nsecsElapsed();
         QApplication::processEvents();
-
+        timer.start();
     }
+    parseTime += timer.nsecsElapsed();
+    if(m_metrics != nullptr)
+        m_metrics->addConsumerTime(PipelineMetrics::PlotParse, parseTime);
     if(!hasData)
-    {
-        if(plotBuf->size() > 1024 * 1024 * 256) // 256MB threshold
-        {
-            qDebug() << "plotBuf full!";
-            plotBuf->clear();
-        }
         return;
-    }
     else if(ui->plot_latestBox->isChecked())
     {
         ui->qcpWidget->xAxis->blockSignals(true);
@@ -570,14 +638,14 @@ void PlotTab::processData()
         if(ui->plot_tracerCheckBox->isChecked())
             updateTracer(currKey);
     }
+    if(m_metrics != nullptr)
+        m_metrics->addReplotRequest();
     ui->qcpWidget->replot(QCustomPlot::rpQueuedReplot);
 }
 
 void PlotTab::setDecoder(QTextDecoder *decoder)
 {
-    if(this->decoder != nullptr)
-        delete this->decoder;
-    this->decoder = decoder;
+    m_parser->setDecoder(decoder);
 }
 
 QCPAbstractLegendItem* PlotTab::getLegendItemByPos(const QPointF &pos)
@@ -613,8 +681,3 @@ void PlotTab::setGraphProperty(QCPAbstractLegendItem *item)
         saveGraphProperty();
     }
 }
-
-inline double PlotTab::toDouble(const QString& str)
-{
-    return doubleRegex->match(str).captured().toDouble();
-}
@@ -5,6 +5,8 @@
 
 #include "mysettings.h"
 #include "mycustomplot.h"
+#include "plotparser.h"
+#include "pipelinemetrics.h"
 
 namespace Ui
 {
@@ -23,11 +25,18 @@ public:
     void initSettings();
     void setReplotInterval(int msec);
     bool enabled();
+    void setPlotEnabled(bool enabled);
+    void setMetrics(PipelineMetrics* metrics);
+    int parserBacklog();
+    qint64 parserMemory();
+    qint64 graphMemory();
+    void setClientList(const QMap<int, QString>& clientMap);
+    int RxClientId(); // -1: all clients
 public slots:
     void newData(const QByteArray &data);
     void setDecoder(QTextDecoder* decoder);
 signals:
-
+    void RxClientChanged();
 private slots:
     void onQCPLegendDoubleClick(QCPLegend *legend, QCPAbstractLegendItem *item, QMouseEvent* event);
     void onQCPLegendClick(QCPLegend *legend, QCPAbstractLegendItem *item, QMouseEvent *event);
@@ -58,7 +67,9 @@ private slots:
 private:
     Ui::PlotTab *ui;
 
-    QString* plotBuf;
+    PlotParser* m_parser;
+    PipelineMetrics* m_metrics = nullptr;
+    qint64 m_replotStart = -1;
     quint64 plotCounter;
     QCPItemTracer* plotTracer;
     QCPItemText* plotText;
@@ -74,16 +85,13 @@ private:
 
     QMap<QCPAbstractLegendItem*, ulong> longPressCounter;
 
-    QTextDecoder* decoder = nullptr;
     MySettings *settings;
-    QRegularExpression* doubleRegex;
 
     QTimer* m_dataProcessTimer;
 
     void updateTracer(double x);
     QCPAbstractLegendItem *getLegendItemByPos(const QPointF &pos);
     void setGraphProperty(QCPAbstractLegendItem *item);
-    inline double toDouble(const QString& str); // find valid value then convert
     void saveGraphProperty();
     void changeGraphNum(int newNum);
 };
@@ -0,0 +1,96 @@
+#include "ptydevice.h"
+
+#include <QFile>
+#include <QFileInfo>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#endif
+
+PtyDevice::PtyDevice(QObject *parent)
+    : FdDevice{parent}
+{
+
+}
+
+PtyDevice::~PtyDevice()
+{
+    PtyDevice::close();
+}
+
+bool PtyDevice::openPty(const QString& linkPath)
+{
+#ifdef Q_OS_UNIX
+    if(isOpen())
+        return false;
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || grantpt(masterFd) < 0 || unlockpt(masterFd) < 0)
+    {
+        setSystemError();
+        if(masterFd >= 0)
+            ::close(masterFd);
+        return false;
+    }
+    m_slaveName = QString::fromLocal8Bit(ptsname(masterFd));
+    m_slaveFd = ::open(ptsname(masterFd), O_RDWR | O_NOCTTY);
+    if(m_slaveFd < 0)
+    {
+        setSystemError();
+        ::close(masterFd);
+        close();
+        return false;
+    }
+    // raw mode, the data is passed as it is, like a serial port
+    termios tio;
+    if(tcgetattr(m_slaveFd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(m_slaveFd, TCSANOW, &tio);
+    }
+
+    if(!linkPath.isEmpty())
+    {
+        // replace the stale link from the last run
+        if(QFileInfo(linkPath).isSymLink())
+            QFile::remove(linkPath);
+        if(!QFile::link(m_slaveName, linkPath))
+        {
+            setErrorString(tr("Failed to create the link") + " " + linkPath);
+            ::close(masterFd);
+            close();
+            return false;
+        }
+        m_linkPath = linkPath;
+    }
+    return openFds(masterFd, masterFd);
+#else
+    Q_UNUSED(linkPath)
+    setErrorString(tr("Pseudo-terminal is not supported on this platform"));
+    return false;
+#endif
+}
+
+void PtyDevice::close()
+{
+    FdDevice::close();
+#ifdef Q_OS_UNIX
+    if(m_slaveFd >= 0)
+        ::close(m_slaveFd);
+    m_slaveFd = -1;
+#endif
+    if(!m_linkPath.isEmpty())
+        QFile::remove(m_linkPath);
+    m_linkPath.clear();
+    m_slaveName.clear();
+}
+
+QString PtyDevice::slaveName() const
+{
+    return m_slaveName;
+}
+
+QString PtyDevice::linkPath() const
+{
+    return m_linkPath;
+}
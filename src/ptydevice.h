@@ -0,0 +1,27 @@
+#ifndef PTYDEVICE_H
+#define PTYDEVICE_H
+
+#include "fddevice.h"
+
+// the master side of a pseudo-terminal pair, Unix only
+// other programs open slaveName() like a serial port
+class PtyDevice : public FdDevice
+{
+    Q_OBJECT
+public:
+    explicit PtyDevice(QObject *parent = nullptr);
+    ~PtyDevice();
+
+    // if linkPath is not empty, a symlink to the slave is created there
+    bool openPty(const QString& linkPath = QString());
+    void close() override;
+    QString slaveName() const;
+    QString linkPath() const;
+private:
+    // kept open, otherwise reading the master fails after the last client closes the slave
+    int m_slaveFd = -1;
+    QString m_slaveName;
+    QString m_linkPath;
+};
+
+#endif // PTYDEVICE_H
@@ -1,6 +1,8 @@
 ﻿#include "serialpinout.h"
 #include "ui_serialpinout.h"
 
+#include <QTimer>
+
 SerialPinout::SerialPinout(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::SerialPinout)
@@ -100,6 +102,7 @@ void SerialPinout::onEnableStateChanged(bool state)
 
 void SerialPinout::setPinout(QSerialPort::PinoutSignals signal)
 {
+    m_signal = signal;
 
     if(signal.testFlag(QSerialPort::ClearToSendSignal))
         ui->CTSLabel->setStyleSheet(activeBGList[activeBGId]);
@@ -118,3 +121,73 @@ void SerialPinout::setPinout(QSerialPort::PinoutSignals signal)
     else
         ui->RILabel->setStyleSheet(noBG);
 }
+
+void SerialPinout::addEdges(const QVector<ModemLineEdge>& edges)
+{
+    for(const ModemLineEdge& edge : edges)
+    {
+        if(edge.CTSCount < m_lastEdge.CTSCount || edge.DSRCount < m_lastEdge.DSRCount || edge.DCDCount < m_lastEdge.DCDCount || edge.RICount < m_lastEdge.RICount)
+        {
+            // the watcher is restarted
+            m_edgeHistory.clear();
+            m_lastEdge = {};
+        }
+        // the first edge has no reference
+        if(!m_edgeHistory.isEmpty())
+        {
+            // more transitions than the visible changes, the line had a pulse shorter than a wakeup
+            QSerialPort::PinoutSignals changed = edge.signal ^ m_lastEdge.signal;
+            if(edge.CTSCount - m_lastEdge.CTSCount > (changed.testFlag(QSerialPort::ClearToSendSignal) ? 1u : 0u))
+                flashLabel(ui->CTSLabel);
+            if(edge.DSRCount - m_lastEdge.DSRCount > (changed.testFlag(QSerialPort::DataSetReadySignal) ? 1u : 0u))
+                flashLabel(ui->DSRLabel);
+            if(edge.DCDCount - m_lastEdge.DCDCount > (changed.testFlag(QSerialPort::DataCarrierDetectSignal) ? 1u : 0u))
+                flashLabel(ui->DCDLabel);
+            // RI only counts the trailing edges
+            if(edge.RICount != m_lastEdge.RICount && !edge.signal.testFlag(QSerialPort::RingIndicatorSignal))
+                flashLabel(ui->RILabel);
+        }
+        m_lastEdge = edge;
+
+        if(m_edgeHistory.size() >= m_maxEdgeHistory)
+            m_edgeHistory.removeFirst();
+        m_edgeHistory.append(edge);
+    }
+    updateEdgeToolTip();
+}
+
+void SerialPinout::flashLabel(QLabel* label)
+{
+    if(!label->isVisible())
+        return;
+    label->setStyleSheet(glitchBG);
+    QTimer::singleShot(150, this, [ = ]
+    {
+        setPinout(m_signal);
+    });
+}
+
+void SerialPinout::updateEdgeToolTip()
+{
+    QString text = tr("Transitions:") + QString(" CTS %1, DSR %2, DCD %3, RI %4")
+                   .arg(m_lastEdge.CTSCount)
+                   .arg(m_lastEdge.DSRCount)
+                   .arg(m_lastEdge.DCDCount)
+                   .arg(m_lastEdge.RICount);
+    // time since the previous edge, in microseconds
+    for(int i = 1; i < m_edgeHistory.size(); i++)
+    {
+        const ModemLineEdge& edge = m_edgeHistory[i];
+        QStringList lines;
+        if(edge.signal.testFlag(QSerialPort::ClearToSendSignal))
+            lines.append("CTS");
+        if(edge.signal.testFlag(QSerialPort::DataSetReadySignal))
+            lines.append("DSR");
+        if(edge.signal.testFlag(QSerialPort::DataCarrierDetectSignal))
+            lines.append("DCD");
+        if(edge.signal.testFlag(QSerialPort::RingIndicatorSignal))
+            lines.append("RI");
+        text += QString("\n+%1us: %2").arg((edge.timestamp - m_edgeHistory[i - 1].timestamp) / 1000).arg(lines.join(' '));
+    }
+    setToolTip(text);
+}
@@ -3,6 +3,9 @@
 
 #include <QWidget>
 #include <QSerialPort>
+#include <QLabel>
+
+#include "modemlinewatcher.h"
 
 #include "mysettings.h"
 
@@ -22,6 +25,7 @@ public:
     void initSettings();
 public slots:
     void setPinout(QSerialPort::PinoutSignals signal);
+    void addEdges(const QVector<ModemLineEdge>& edges);
     void setEnableState(bool state);
     bool getEnableState();
 protected:
@@ -38,7 +42,15 @@ private:
     int activeBGId = 0;
     const QString noBG = "";
     MySettings *m_settings;
+    QSerialPort::PinoutSignals m_signal;
+    // the recent edges, shown in the tooltip
+    QVector<ModemLineEdge> m_edgeHistory;
+    static const int m_maxEdgeHistory = 16;
+    ModemLineEdge m_lastEdge = {};
+    const QString glitchBG = "background-color: rgb(255,190,0);";
     void onEnableStateChanged(bool state);
+    void flashLabel(QLabel* label);
+    void updateEdgeToolTip();
 signals:
     void enableStateChanged(bool state);
 };
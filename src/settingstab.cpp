@@ -38,6 +38,10 @@ SettingsTab::SettingsTab(QWidget *parent) :
     ui->Theme_nameBox->addItem(tr("(None)"), "(none)");
     ui->Theme_nameBox->addItem(tr("Dark"), "qdss_dark");
     ui->Theme_nameBox->addItem(tr("Light"), "qdss_light");
+
+    ui->Server_lagPolicyBox->addItem(tr("Drop the data"), Connection::Lag_Drop);
+    ui->Server_lagPolicyBox->addItem(tr("Disconnect the client"), Connection::Lag_Disconnect);
+    ui->Server_lagPolicyBox->addItem(tr("Block the sender"), Connection::Lag_Block);
     QScroller::grabGesture(ui->scrollArea);
 }
 
@@ -91,6 +95,21 @@ void SettingsTab::initSettings()
     connect(ui->Android_forceLandscapeBox, &QCheckBox::clicked, this, &SettingsTab::savePreference);
     connect(ui->Android_dockBox, &QCheckBox::clicked, this, &SettingsTab::savePreference);
     connect(ui->Opacity_Box, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsTab::savePreference);
+    connect(ui->Server_lagLimitBox, &QSpinBox::editingFinished, this, &SettingsTab::onServerLagChanged);
+    connect(ui->Server_lagPolicyBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SettingsTab::onServerLagChanged);
+    connect(ui->Tx_coalesceBox, &QSpinBox::editingFinished, this, &SettingsTab::onTxCoalescingChanged);
+}
+
+void SettingsTab::onTxCoalescingChanged()
+{
+    emit TxCoalescingChanged(ui->Tx_coalesceBox->value());
+    savePreference();
+}
+
+void SettingsTab::onServerLagChanged()
+{
+    emit serverLagChanged(ui->Server_lagLimitBox->value() * 1024LL, (Connection::LagPolicy)ui->Server_lagPolicyBox->currentData().toInt());
+    savePreference();
 }
 
 
@@ -168,6 +187,9 @@ void SettingsTab::savePreference()
 #else
     m_settings->setValue("Opacity", ui->Opacity_Box->value());
 #endif
+    m_settings->setValue("Tx_Coalesce", ui->Tx_coalesceBox->value());
+    m_settings->setValue("Server_LagLimit", ui->Server_lagLimitBox->value());
+    m_settings->setValue("Server_LagPolicy", ui->Server_lagPolicyBox->currentData().toInt());
     m_settings->endGroup();
 }
 
@@ -185,6 +207,10 @@ void SettingsTab::loadPreference()
     ui->Opacity_Box->setValue(m_settings->value("Opacity", 100).toInt());
     int themeId = ui->Theme_nameBox->findData(m_settings->value("Theme_Name", "(none)").toString());
     ui->Theme_nameBox->setCurrentIndex((themeId == -1) ? 0 : themeId);
+    ui->Tx_coalesceBox->setValue(m_settings->value("Tx_Coalesce", 0).toInt());
+    ui->Server_lagLimitBox->setValue(m_settings->value("Server_LagLimit", 1024).toInt());
+    int lagPolicyId = ui->Server_lagPolicyBox->findData(m_settings->value("Server_LagPolicy", Connection::Lag_Drop).toInt());
+    ui->Server_lagPolicyBox->setCurrentIndex((lagPolicyId == -1) ? 0 : lagPolicyId);
 
     // QApplication::font() might return wrong result
     // If fonts are not specified in config file, don't touch them.
@@ -209,6 +235,8 @@ void SettingsTab::loadPreference()
     }
 
     m_settings->endGroup();
+    emit serverLagChanged(ui->Server_lagLimitBox->value() * 1024LL, (Connection::LagPolicy)ui->Server_lagPolicyBox->currentData().toInt());
+    emit TxCoalescingChanged(ui->Tx_coalesceBox->value());
     // Language is applied in main.cpp, not there.
     on_Lang_nameBox_currentIndexChanged(ui->Lang_nameBox->currentIndex());
 #ifdef Q_OS_ANDROID
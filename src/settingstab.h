@@ -4,6 +4,7 @@
 #include <QWidget>
 
 #include "mysettings.h"
+#include "connection.h"
 
 namespace Ui
 {
@@ -53,6 +54,9 @@ private slots:
 
     void on_Theme_setButton_clicked();
 
+    void onServerLagChanged();
+    void onTxCoalescingChanged();
+
 private:
     Ui::SettingsTab *ui;
     MySettings* m_settings;
@@ -61,6 +65,8 @@ signals:
     void opacityChanged(qreal value);
     void fontChanged(QFont font);
     void fullScreenStateChanged(bool isFullScreen);
+    void serverLagChanged(qint64 limit, Connection::LagPolicy policy);
+    void TxCoalescingChanged(int msec);
 };
 
 #endif // SETTINGSTAB_H
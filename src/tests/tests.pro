@@ -0,0 +1,18 @@
+# QTest loopback tests for the file transfer protocols, runs under QCoreApplication
+# the sender and the receiver are connected in the process, no port is needed
+# ./tst_fileprotocols
+QT += testlib
+QT -= gui
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+TARGET = tst_fileprotocols
+
+include(../core/core.pri)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    tst_fileprotocols.cpp
@@ -0,0 +1,295 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include "xymodem.h"
+#include "zmodem.h"
+#include "chunkprotocol.h"
+
+// connects two engines back to back, the data is delivered through the event loop like a port
+// one byte from the sender can be corrupted to trigger the error recovery
+class Line : public QObject
+{
+public:
+    Line(FileProtocol* sender, FileProtocol* receiver, qint64 corruptPos = -1)
+        : m_corruptPos(corruptPos)
+    {
+        connect(sender, &FileProtocol::send, this, [ = ](const QByteArray & data)
+        {
+            QByteArray result = data;
+            if(m_corruptPos >= m_forwardNum && m_corruptPos < m_forwardNum + data.size())
+                result.data()[m_corruptPos - m_forwardNum] ^= 0x55;
+            m_forwardNum += data.size();
+            m_forward += result;
+            receiver->newData(result);
+        }, Qt::QueuedConnection);
+        connect(receiver, &FileProtocol::send, this, [ = ](const QByteArray & data)
+        {
+            m_backward += data;
+            sender->newData(data);
+        }, Qt::QueuedConnection);
+    }
+    qint64 forwardNum() const
+    {
+        return m_forwardNum;
+    }
+    // everything received from the sender
+    QByteArray forward() const
+    {
+        return m_forward;
+    }
+    // everything sent by the receiver
+    QByteArray backward() const
+    {
+        return m_backward;
+    }
+private:
+    qint64 m_corruptPos;
+    qint64 m_forwardNum = 0;
+    QByteArray m_forward;
+    QByteArray m_backward;
+};
+
+class TestFileProtocols : public QObject
+{
+    Q_OBJECT
+private slots:
+    void xmodem1K();
+    void ymodemBatch();
+    void zmodem();
+    void zmodemResume();
+    void zmodemCorrupted();
+    void chunkedResume();
+private:
+    QTemporaryDir m_dir;
+
+    QByteArray testData(int size, int seed);
+    QString writeFile(const QString& name, const QByteArray& data);
+    QByteArray readFile(const QString& name);
+    void setArgument(FileProtocol* engine, bool resume = false);
+    void transfer(FileProtocol* sender, FileProtocol* receiver);
+};
+
+QByteArray TestFileProtocols::testData(int size, int seed)
+{
+    QByteArray result(size, '\0');
+    // includes the bytes escaped by ZMODEM
+    for(int i = 0; i < size; i++)
+        result[i] = (char)(i * 131 + (i >> 8) + seed);
+    return result;
+}
+
+QString TestFileProtocols::writeFile(const QString& name, const QByteArray& data)
+{
+    QString path = m_dir.filePath(name);
+    QFile file(path);
+    if(file.open(QFile::WriteOnly))
+        file.write(data);
+    return path;
+}
+
+QByteArray TestFileProtocols::readFile(const QString& name)
+{
+    QFile file(m_dir.filePath(name));
+    if(!file.open(QFile::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+void TestFileProtocols::setArgument(FileProtocol* engine, bool resume)
+{
+    FileProtocol::Argument arg;
+    arg.timeout = 1000; // for the recovery tests
+    arg.resume = resume;
+    engine->setArgument(arg);
+}
+
+// the receiver is started first, the queued data is handled after both are started
+void TestFileProtocols::transfer(FileProtocol* sender, FileProtocol* receiver)
+{
+    QSignalSpy senderFinished(sender, &FileProtocol::finished);
+    QSignalSpy receiverFinished(receiver, &FileProtocol::finished);
+    QSignalSpy senderError(sender, &FileProtocol::error);
+    QSignalSpy receiverError(receiver, &FileProtocol::error);
+    QTRY_VERIFY_WITH_TIMEOUT((senderFinished.count() > 0 && receiverFinished.count() > 0) || senderError.count() > 0 || receiverError.count() > 0, 30000);
+    QCOMPARE(senderError.count(), 0);
+    QCOMPARE(receiverError.count(), 0);
+}
+
+void TestFileProtocols::xmodem1K()
+{
+    QVERIFY(m_dir.isValid());
+    QByteArray data = testData(5000, 1);
+    QString txPath = writeFile("x1k_tx.bin", data);
+    XYModem sender(XYModem::XModem1K), receiver(XYModem::XModem1K);
+    setArgument(&sender);
+    setArgument(&receiver);
+    Line line(&sender, &receiver);
+    QVERIFY(receiver.startReceive(m_dir.filePath("x1k_rx.bin")));
+    QVERIFY(sender.startTransmit(txPath));
+    transfer(&sender, &receiver);
+
+    // XMODEM has no file size, the last block is padded with CPMEOF
+    QByteArray received = readFile("x1k_rx.bin");
+    QCOMPARE(received.size() % 128, 0);
+    QVERIFY(received.size() - data.size() < 128);
+    QCOMPARE(received.left(data.size()), data);
+    QCOMPARE(received.mid(data.size()), QByteArray(received.size() - data.size(), '\x1A'));
+}
+
+void TestFileProtocols::ymodemBatch()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(QDir(m_dir.path()).mkpath("ymodem_rx"));
+    QByteArray data1 = testData(3000, 2), data2 = testData(70000, 3);
+    QString txPath1 = writeFile("ymodem_1.bin", data1);
+    QString txPath2 = writeFile("ymodem_2.bin", data2);
+    XYModem sender(XYModem::YModem), receiver(XYModem::YModem);
+    setArgument(&sender);
+    setArgument(&receiver);
+    Line line(&sender, &receiver);
+    QVERIFY(receiver.startReceive(m_dir.filePath("ymodem_rx")));
+    sender.setPendingFiles(QStringList(txPath2));
+    QVERIFY(sender.startTransmit(txPath1));
+    transfer(&sender, &receiver);
+
+    // the padding is removed with the size in block 0
+    QCOMPARE(readFile("ymodem_rx/ymodem_1.bin"), data1);
+    QCOMPARE(readFile("ymodem_rx/ymodem_2.bin"), data2);
+}
+
+void TestFileProtocols::zmodem()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(QDir(m_dir.path()).mkpath("zmodem_rx"));
+    QByteArray data = testData(200000, 4);
+    QString txPath = writeFile("zmodem.bin", data);
+    ZModem sender, receiver;
+    setArgument(&sender);
+    setArgument(&receiver);
+    Line line(&sender, &receiver);
+    QVERIFY(receiver.startReceive(m_dir.filePath("zmodem_rx")));
+    QVERIFY(sender.startTransmit(txPath));
+    transfer(&sender, &receiver);
+
+    QCOMPARE(readFile("zmodem_rx/zmodem.bin"), data);
+}
+
+// the receiver keeps the existing part and asks for the rest with ZRPOS
+void TestFileProtocols::zmodemResume()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(QDir(m_dir.path()).mkpath("zmodem_resume_rx"));
+    QByteArray data = testData(200000, 5);
+    const int existingSize = 120000;
+    QString txPath = writeFile("zmodem_resume.bin", data);
+    writeFile("zmodem_resume_rx/zmodem_resume.bin", data.left(existingSize));
+    ZModem sender, receiver;
+    setArgument(&sender);
+    setArgument(&receiver, true);
+    Line line(&sender, &receiver);
+    QSignalSpy received(&receiver, &FileProtocol::dataReceived);
+    QVERIFY(receiver.startReceive(m_dir.filePath("zmodem_resume_rx")));
+    QVERIFY(sender.startTransmit(txPath));
+    transfer(&sender, &receiver);
+
+    QCOMPARE(readFile("zmodem_resume_rx/zmodem_resume.bin"), data);
+    qint64 receivedNum = 0;
+    for(const QList<QVariant>& args : received)
+        receivedNum += args.at(0).value<qsizetype>();
+    QCOMPARE(receivedNum, (qint64)(data.size() - existingSize));
+    QVERIFY(line.forwardNum() < data.size());
+}
+
+// the damaged subpacket is dropped, then the sender resumes from the ZRPOS position
+void TestFileProtocols::zmodemCorrupted()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(QDir(m_dir.path()).mkpath("zmodem_corrupted_rx"));
+    QByteArray data = testData(200000, 6);
+    QString txPath = writeFile("zmodem_corrupted.bin", data);
+    ZModem sender, receiver;
+    setArgument(&sender);
+    setArgument(&receiver);
+    Line line(&sender, &receiver, 50000);
+    QVERIFY(receiver.startReceive(m_dir.filePath("zmodem_corrupted_rx")));
+    QVERIFY(sender.startTransmit(txPath));
+    transfer(&sender, &receiver);
+
+    QCOMPARE(readFile("zmodem_corrupted_rx/zmodem_corrupted.bin"), data);
+    // ZRPOS(0) for the file, then another one for the error
+    QVERIFY(line.backward().count("**\x18" "B09") >= 2);
+}
+
+// the transfer is stopped in the middle, then both sides are restarted
+// the receiver resumes with the .chunkmap file, the blocks marked there are not sent again
+void TestFileProtocols::chunkedResume()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(QDir(m_dir.path()).mkpath("chunked_rx"));
+    QByteArray data = testData(300000, 7);
+    QString txPath = writeFile("chunked.bin", data);
+    const quint32 blockSize = 4096;
+    const quint32 blockCount = (data.size() + blockSize - 1) / blockSize;
+    const QString mapName = "chunked_rx/chunked.bin.chunkmap";
+
+    {
+        ChunkProtocol sender, receiver;
+        setArgument(&sender);
+        setArgument(&receiver);
+        Line line(&sender, &receiver);
+        QSignalSpy received(&receiver, &FileProtocol::dataReceived);
+        QVERIFY(receiver.startReceive(m_dir.filePath("chunked_rx")));
+        QVERIFY(sender.startTransmit(txPath));
+        QTRY_VERIFY_WITH_TIMEOUT(received.count() >= 20, 30000);
+        // the receiver saves the map when it is stopped
+        receiver.stop();
+        sender.stop();
+    }
+
+    // map file: magic(4) + manifest length(4) + manifest + bitmap
+    QByteArray map = readFile(mapName);
+    QVERIFY(map.startsWith("SCHK"));
+    qsizetype bitmapPos = 8 + qFromLittleEndian<quint32>(map.constData() + 4);
+    QByteArray bitmap = map.mid(bitmapPos);
+    QCOMPARE(bitmap.size(), (int)((blockCount + 7) / 8));
+    quint32 savedNum = 0;
+    for(quint32 i = 0; i < blockCount; i++)
+        savedNum += (bitmap[i / 8] >> (i % 8)) & 1;
+    QVERIFY(savedNum >= 20);
+    QVERIFY(savedNum < blockCount);
+
+    ChunkProtocol sender, receiver;
+    setArgument(&sender);
+    setArgument(&receiver);
+    Line line(&sender, &receiver);
+    QVERIFY(receiver.startReceive(m_dir.filePath("chunked_rx")));
+    QVERIFY(sender.startTransmit(txPath));
+    transfer(&sender, &receiver);
+
+    QCOMPARE(readFile("chunked_rx/chunked.bin"), data);
+    QVERIFY(!QFile::exists(m_dir.filePath(mapName)));
+    // frame: magic(2) + type(1) + payload length(4) + payload + CRC-32(4), Data(3): block index(4) + block
+    const QByteArray stream = line.forward();
+    const char* buf = stream.constData();
+    qsizetype pos = 0;
+    QSet<quint32> sentBlocks;
+    while(pos + 7 <= stream.size())
+    {
+        QVERIFY(buf[pos] == '\xA5' && buf[pos + 1] == '\x5A');
+        quint32 len = qFromLittleEndian<quint32>(buf + pos + 3);
+        if(buf[pos + 2] == 3)
+        {
+            quint32 index = qFromLittleEndian<quint32>(buf + pos + 7);
+            QVERIFY2(!((bitmap[index / 8] >> (index % 8)) & 1), qPrintable(QString("block %1 is resent").arg(index)));
+            sentBlocks.insert(index);
+        }
+        pos += 7 + len + 4;
+    }
+    QCOMPARE(pos, (qsizetype)stream.size());
+    QCOMPARE((quint32)sentBlocks.size(), blockCount - savedNum);
+}
+
+QTEST_GUILESS_MAIN(TestFileProtocols)
+
+#include "tst_fileprotocols.moc"
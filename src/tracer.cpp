@@ -0,0 +1,174 @@
+#include "tracer.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QCoreApplication>
+
+#include <atomic>
+
+struct TraceEvent
+{
+    const char* name;
+    qint64 start;
+    qint64 duration;
+    qint64 arg;
+};
+
+struct TraceRing
+{
+    int tid;
+    QString threadName;
+    QVector<TraceEvent> events;
+    // total number of events, written by the owner thread only
+    // also the sequence counter of the ring, the slot of event pos might be being written
+    QAtomicInteger<quint64> pos;
+    QAtomicInteger<quint64> clearedPos; // the events before it are dropped
+};
+
+QAtomicInt Tracer::m_enabled;
+
+// the rings are never freed, the events of the finished threads are kept
+static QMutex ringListMutex;
+static QList<TraceRing*> ringList;
+static thread_local TraceRing* currentRing = nullptr;
+
+struct TraceClock
+{
+    QElapsedTimer timer;
+    TraceClock()
+    {
+        timer.start();
+    }
+};
+
+static QElapsedTimer& traceClock()
+{
+    static TraceClock instance;
+    return instance.timer;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    traceClock(); // the timestamps start from the first call
+    m_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+qint64 Tracer::now()
+{
+    return traceClock().nsecsElapsed();
+}
+
+void Tracer::addEvent(const char* name, qint64 start, qint64 end, qint64 arg)
+{
+    TraceRing* ring = currentRing;
+    if(ring == nullptr)
+    {
+        ring = new TraceRing;
+        ring->events.resize(ringSize);
+        ring->pos.storeRelease(0);
+        ring->clearedPos.storeRelease(0);
+        QThread* thread = QThread::currentThread();
+        ring->threadName = thread->objectName();
+        if(ring->threadName.isEmpty())
+            ring->threadName = (QCoreApplication::instance() != nullptr && thread == QCoreApplication::instance()->thread()) ? "Main" : "Thread";
+        ringListMutex.lock();
+        ring->tid = ringList.size() + 1;
+        ringList.append(ring);
+        ringListMutex.unlock();
+        currentRing = ring;
+    }
+    quint64 pos = ring->pos.loadAcquire();
+    TraceEvent& event = ring->events[pos % ringSize];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    event.arg = arg;
+    ring->pos.storeRelease(pos + 1);
+}
+
+static QByteArray escapeJSON(const QString& str)
+{
+    QByteArray result;
+    for(char c : str.toUtf8())
+    {
+        if(c == '"' || c == '\\')
+            result += '\\';
+        if((uchar)c < 0x20)
+            result += "\\u00" + QByteArray::number((uchar)c, 16).rightJustified(2, '0');
+        else
+            result += c;
+    }
+    return result;
+}
+
+// copy the events while the owner thread is writing, then drop the overwritten ones
+static QVector<TraceEvent> snapshot(TraceRing* ring)
+{
+    quint64 end = ring->pos.loadAcquire();
+    quint64 begin = end > (quint64)Tracer::ringSize ? end - Tracer::ringSize : 0;
+    // clear() might run after end is loaded
+    begin = qMin(qMax(begin, ring->clearedPos.loadAcquire()), end);
+    QVector<TraceEvent> result;
+    result.reserve(end - begin);
+    for(quint64 i = begin; i < end; i++)
+        result.append(ring->events[i % Tracer::ringSize]);
+    // the copies above should not be reordered after the check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    quint64 newEnd = ring->pos.loadAcquire();
+    // the slots from event newEnd - ringSize are reused or being reused
+    quint64 validBegin = newEnd >= (quint64)Tracer::ringSize ? newEnd - Tracer::ringSize + 1 : 0;
+    if(validBegin > begin)
+        result.remove(0, qMin(validBegin, end) - begin);
+    return result;
+}
+
+bool Tracer::dump(const QString& path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QByteArray buf;
+    bool first = true;
+    buf += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    ringListMutex.lock();
+    for(TraceRing* ring : ringList)
+    {
+        if(!first)
+            buf += ",\n";
+        first = false;
+        buf += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(ring->tid)
+               + ",\"args\":{\"name\":\"" + escapeJSON(ring->threadName) + " " + QByteArray::number(ring->tid) + "\"}}";
+        const QVector<TraceEvent> events = snapshot(ring);
+        for(const TraceEvent& event : events)
+        {
+            // ts and dur are in us
+            buf += ",\n{\"name\":\"" + QByteArray(event.name) + "\",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   + QByteArray::number(ring->tid)
+                   + ",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3)
+                   + ",\"dur\":" + QByteArray::number(event.duration / 1000.0, 'f', 3);
+            if(event.arg >= 0)
+                buf += ",\"args\":{\"bytes\":" + QByteArray::number(event.arg) + "}";
+            buf += "}";
+        }
+        if(buf.size() > 1048576)
+        {
+            file.write(buf);
+            buf.clear();
+        }
+    }
+    ringListMutex.unlock();
+    buf += "\n]}\n";
+    return file.write(buf) == buf.size();
+}
+
+void Tracer::clear()
+{
+    ringListMutex.lock();
+    for(TraceRing* ring : ringList)
+        ring->clearedPos.storeRelease(ring->pos.loadAcquire());
+    ringListMutex.unlock();
+}
@@ -0,0 +1,54 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QAtomicInt>
+
+// scoped trace events of the pipeline stages, dumped in the Chrome trace format
+// open the file in chrome://tracing or https://ui.perfetto.dev
+// each thread has its own ring buffer, the oldest events are overwritten
+class Tracer
+{
+public:
+    static const int ringSize = 65536; // events per thread
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return m_enabled.loadAcquire() != 0;
+    }
+    static qint64 now(); // in ns
+    // name must be a string literal, arg is omitted if negative
+    static void addEvent(const char* name, qint64 start, qint64 end, qint64 arg = -1);
+    // it can be called while tracing, the events being overwritten are skipped
+    static bool dump(const QString& path);
+    static void clear();
+private:
+    static QAtomicInt m_enabled;
+};
+
+// record the lifetime of the object
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+    {
+        m_name = name;
+        m_start = Tracer::isEnabled() ? Tracer::now() : -1;
+    }
+    ~TraceScope()
+    {
+        if(m_start >= 0 && Tracer::isEnabled())
+            Tracer::addEvent(m_name, m_start, Tracer::now(), m_arg);
+    }
+    void setArg(qint64 arg)
+    {
+        m_arg = arg;
+    }
+private:
+    const char* m_name;
+    qint64 m_start;
+    qint64 m_arg = -1;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,193 @@
+#include "unixdatagramsocket.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+UnixDatagramSocket::UnixDatagramSocket(QObject *parent)
+    : FdDevice{parent}
+{
+
+}
+
+UnixDatagramSocket::~UnixDatagramSocket()
+{
+    UnixDatagramSocket::close();
+}
+
+int UnixDatagramSocket::createSocket(const QString& path, QByteArray& addr)
+{
+#ifdef Q_OS_UNIX
+    QByteArray name = path.toLocal8Bit();
+    sockaddr_un sa = {};
+    if(name.isEmpty() || name.size() >= (int)sizeof(sa.sun_path))
+    {
+        setErrorString(tr("Invalid socket path") + " " + path);
+        return -1;
+    }
+    sa.sun_family = AF_UNIX;
+    memcpy(sa.sun_path, name.constData(), name.size());
+    addr = QByteArray((const char*)&sa, sizeof(sa));
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(fd < 0)
+        setSystemError();
+    return fd;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(addr)
+    setErrorString(tr("Unix domain socket is not supported on this platform"));
+    return -1;
+#endif
+}
+
+bool UnixDatagramSocket::bind(const QString& path)
+{
+#ifdef Q_OS_UNIX
+    QByteArray addr;
+    if(isOpen())
+        return false;
+    int fd = createSocket(path, addr);
+    if(fd < 0)
+        return false;
+    // remove the socket left by the last run
+    struct stat st;
+    QByteArray name = path.toLocal8Bit();
+    if(lstat(name.constData(), &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(name.constData());
+    if(::bind(fd, (const sockaddr*)addr.constData(), addr.size()) < 0)
+    {
+        setSystemError();
+        ::close(fd);
+        return false;
+    }
+    m_boundPath = path;
+    m_connected = false;
+    m_peerAddr.clear();
+    return openFds(fd, fd);
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+bool UnixDatagramSocket::connectTo(const QString& path)
+{
+#ifdef Q_OS_UNIX
+    QByteArray addr;
+    if(isOpen())
+        return false;
+    int fd = createSocket(path, addr);
+    if(fd < 0)
+        return false;
+#ifdef Q_OS_LINUX
+    // autobind to an abstract address
+    sa_family_t family = AF_UNIX;
+    ::bind(fd, (const sockaddr*)&family, sizeof(family));
+#endif
+    if(::connect(fd, (const sockaddr*)addr.constData(), addr.size()) < 0)
+    {
+        setSystemError();
+        ::close(fd);
+        return false;
+    }
+    m_connected = true;
+    return openFds(fd, fd);
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+void UnixDatagramSocket::close()
+{
+    FdDevice::close();
+#ifdef Q_OS_UNIX
+    if(!m_boundPath.isEmpty())
+        unlink(m_boundPath.toLocal8Bit().constData());
+#endif
+    m_boundPath.clear();
+    m_peerAddr.clear();
+    m_connected = false;
+}
+
+qint64 UnixDatagramSocket::bytesToWrite() const
+{
+    // not buffered
+    return 0;
+}
+
+QByteArray UnixDatagramSocket::receiveAll()
+{
+    QByteArray result;
+#ifdef Q_OS_UNIX
+    QByteArray buf;
+    while(true)
+    {
+        // the size of the next datagram on Linux, the total size on others
+        int len = 0;
+        ioctl(readHandle(), FIONREAD, &len);
+        buf.resize(qMax(len, 1));
+        qint64 received = readData(buf.data(), buf.size());
+        if(received < 0 || (received == 0 && len == 0))
+            break;
+        result.append(buf.constData(), received);
+    }
+#endif
+    return result;
+}
+
+qint64 UnixDatagramSocket::readData(char *data, qint64 maxSize)
+{
+#ifdef Q_OS_UNIX
+    sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    qint64 len = ::recvfrom(readHandle(), data, maxSize, MSG_DONTWAIT, (sockaddr*)&addr, &addrLen);
+    if(len < 0)
+    {
+        if(errno == EAGAIN || errno == EINTR)
+            return 0;
+        setSystemError();
+        return -1;
+    }
+    // the unbound clients can't be replied
+    if(!m_connected && addrLen > sizeof(sa_family_t))
+        m_peerAddr = QByteArray((const char*)&addr, addrLen);
+    return len;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+#endif
+}
+
+qint64 UnixDatagramSocket::writeData(const char *data, qint64 maxSize)
+{
+#ifdef Q_OS_UNIX
+    qint64 len;
+    if(m_connected)
+        len = ::send(writeHandle(), data, maxSize, MSG_DONTWAIT);
+    else if(!m_peerAddr.isEmpty())
+        len = ::sendto(writeHandle(), data, maxSize, MSG_DONTWAIT, (const sockaddr*)m_peerAddr.constData(), m_peerAddr.size());
+    else
+    {
+        setErrorString(tr("No client has sent any datagram yet"));
+        return -1;
+    }
+    if(len < 0)
+    {
+        setSystemError();
+        return -1;
+    }
+    return len;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+#endif
+}
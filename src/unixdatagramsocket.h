@@ -0,0 +1,33 @@
+#ifndef UNIXDATAGRAMSOCKET_H
+#define UNIXDATAGRAMSOCKET_H
+
+#include "fddevice.h"
+
+// AF_UNIX SOCK_DGRAM socket, Unix only
+// each write() is sent as a datagram, the received datagrams are concatenated
+class UnixDatagramSocket : public FdDevice
+{
+    Q_OBJECT
+public:
+    explicit UnixDatagramSocket(QObject *parent = nullptr);
+    ~UnixDatagramSocket();
+
+    // server, reply to the sender of the last datagram
+    bool bind(const QString& path);
+    // client, the socket is auto-bound on Linux so the server can reply
+    bool connectTo(const QString& path);
+    void close() override;
+    qint64 bytesToWrite() const override;
+    // all pending datagrams, readAll() might truncate the large ones
+    QByteArray receiveAll();
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+private:
+    QByteArray m_peerAddr; // raw sockaddr of the last sender
+    bool m_connected = false;
+    QString m_boundPath;
+    int createSocket(const QString& path, QByteArray& addr);
+};
+
+#endif // UNIXDATAGRAMSOCKET_H
@@ -2,17 +2,7 @@
 
 #include "QDebug"
 #include <QString>
-#include <QGestureEvent>
-#include <QTouchEvent>
-#include <QContextMenuEvent>
-#include <QApplication>
-#include <QPlainTextEdit>
-#include <QLineEdit>
 #include <QFileInfo>
-#ifdef Q_OS_ANDROID
-#include <QtAndroid>
-#include <QAndroidJniEnvironment>
-#endif
 
 Util::Util()
 {
@@ -125,35 +115,6 @@ QByteArray Util::unescape(const QString &text, QTextCodec* codec)
     return result;
 }
 
-void Util::disableItem(QStandardItemModel* model, int id, bool enabled)
-{
-    if(model == nullptr)
-        return;
-    QStandardItem *item = model->item(id);
-    Qt::ItemFlags flags = item->flags();
-    flags.setFlag(Qt::ItemIsEnabled, enabled);
-    item->setFlags(flags);
-}
-
-
-#ifdef Q_OS_ANDROID
-void Util::showToast(const QString& message, bool isLong)
-{
-    // all the magic must happen on Android UI thread
-    // don't capture by reference there
-    QtAndroid::runOnAndroidThread([ = ]
-    {
-        QAndroidJniObject javaString = QAndroidJniObject::fromString(message);
-        QAndroidJniObject toast = QAndroidJniObject::callStaticObjectMethod("android/widget/Toast", "makeText",
-                "(Landroid/content/Context;Ljava/lang/CharSequence;I)Landroid/widget/Toast;",
-                QtAndroid::androidActivity().object(),
-                javaString.object(),
-                jint(isLong ? 1 : 0));
-        toast.callMethod<void>("show");
-    });
-}
-#endif
-
 QString Util::getValidLocalFilename(const QList<QUrl>& urlList)
 {
     for(auto url : urlList)
@@ -164,25 +125,41 @@ QString Util::getValidLocalFilename(const QList<QUrl>& urlList)
     return QString();
 }
 
-// use TapAndHold gesture to show the context menu
-// call widget->grabGesture(Qt::TapAndHoldGesture) then use the event filter
-// for QLineEdit, the edit menu will be shown
-// for QPlainTextEdit, the parent's context menu will be shown
-// useless now...
+bool Util::parseAddress(const QString& text, QString& host, quint16& port)
+{
+    int pos = text.lastIndexOf(':');
+    bool isOk;
+    port = text.mid(pos + 1).toUShort(&isOk);
+    host = (pos < 0) ? QString() : text.left(pos);
+    if(host.startsWith('[') && host.endsWith(']'))
+        host = host.mid(1, host.size() - 2);
+    return isOk;
+}
 
-bool GestureConverter::eventFilter(QObject *obj, QEvent *event)
+QThread* Util::m_workerThreads[Util::WorkerRoleNum] = {nullptr};
+
+QThread* Util::workerThread(WorkerRole role)
 {
-    qDebug() << obj->objectName() << event->type();
-    if(event->type() == QEvent::Gesture || event->type() == QEvent::GestureOverride)
+    static const char* names[WorkerRoleNum] = {"FileXceiver", "FileWriter", "Checksum", "Metrics"};
+    if(m_workerThreads[role] == nullptr)
     {
-        QGestureEvent *ge = static_cast<QGestureEvent*>(event);
-        qDebug() << obj->objectName() << ge->gestures();
-        QGesture *ges = ge->gesture(Qt::TapAndHoldGesture);
-        if(ges->state() == Qt::GestureFinished)
-        {
-            QContextMenuEvent newEvent(QContextMenuEvent::Mouse, ge->mapToGraphicsScene(ges->hotSpot()).toPoint());
-            QApplication::sendEvent(obj, &newEvent);
-        }
+        m_workerThreads[role] = new QThread();
+        m_workerThreads[role]->setObjectName(names[role]);
+        m_workerThreads[role]->start();
+    }
+    return m_workerThreads[role];
+}
+
+// call this after all sessions are deleted
+void Util::stopWorkerThreads()
+{
+    for(int i = 0; i < WorkerRoleNum; i++)
+    {
+        if(m_workerThreads[i] == nullptr)
+            continue;
+        m_workerThreads[i]->quit();
+        m_workerThreads[i]->wait();
+        delete m_workerThreads[i];
+        m_workerThreads[i] = nullptr;
     }
-    return false;
 }
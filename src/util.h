@@ -3,29 +3,33 @@
 
 #include <QString>
 #include <QTextCodec>
-#include <QStandardItemModel>
+#include <QThread>
+#include <QUrl>
 
 class Util
 {
 public:
+    // worker threads shared by all sessions, one thread per role
+    enum WorkerRole
+    {
+        TransceiverWorker = 0,
+        WriterWorker,
+        ChecksumWorker,
+        MetricsWorker,
+        WorkerRoleNum,
+    };
+
     Util();
     static QByteArray unescape(const QString& text, QTextCodec* codec);
-    static void disableItem(QStandardItemModel* model, int id, bool enabled = false);
-#ifdef Q_OS_ANDROID
-    static void showToast(const QString &message, bool isLong = false);
-#endif
     static QString getValidLocalFilename(const QList<QUrl>& urlList);
+    // [host:]port, IPv6 address can be wrapped with [], host is empty if omitted
+    static bool parseAddress(const QString& text, QString& host, quint16& port);
+    static QThread* workerThread(WorkerRole role);
+    static void stopWorkerThreads();
 private:
+    static QThread* m_workerThreads[WorkerRoleNum];
     static const char unescapeTable[];
     static int unescapeHelper(QStringRef text, int &result, int baseBits);
 };
 
-class GestureConverter : public QObject
-{
-    Q_OBJECT
-
-protected:
-    bool eventFilter(QObject* obj, QEvent *event) override;
-};
-
 #endif // UTIL_H
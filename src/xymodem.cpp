@@ -0,0 +1,485 @@
+#include "xymodem.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+
+namespace
+{
+const quint8 SOH = 0x01;
+const quint8 STX = 0x02;
+const quint8 EOT = 0x04;
+const quint8 ACK = 0x06;
+const quint8 NAK = 0x15;
+const quint8 CAN = 0x18;
+const quint8 CRC16 = 'C';
+const char CPMEOF = 0x1A;
+}
+
+XYModem::XYModem(Variant variant, QObject *parent)
+    : FileProtocol{parent}, m_variant(variant), m_crc16(16, 0x1021ULL) // CRC-16/XMODEM
+{
+
+}
+
+bool XYModem::startTransmit(const QString &filename)
+{
+    m_file.close();
+    m_file.setFileName(filename);
+    if(!m_file.open(QFile::ReadOnly))
+        return false;
+
+    m_fileSize = m_file.size();
+    m_handledNum = 0;
+    m_blockNum = (m_variant == YModem) ? 0 : 1;
+    m_useCRC = true;
+    m_canCount = 0;
+    m_retryCount = 0;
+    m_lastPacket.clear();
+    m_state = TxWaitStart;
+    m_isRunning = true;
+    m_timer->start(m_argument.timeout);
+    return true;
+}
+
+bool XYModem::startReceive(const QString &path)
+{
+    m_file.close();
+    m_receivePath = path;
+    m_fileOpened = false;
+    m_fileSize = -1;
+    if(m_variant != YModem)
+    {
+        // no file name in XMODEM
+        m_file.setFileName(path);
+        if(!m_file.open(QFile::WriteOnly))
+            return false;
+        m_fileOpened = true;
+    }
+
+    m_handledNum = 0;
+    m_blockNum = (m_variant == YModem) ? 0 : 1;
+    m_useCRC = true;
+    m_canCount = 0;
+    m_retryCount = 0;
+    m_startCount = 0;
+    m_waitingStart = true;
+    m_blockAcked = false;
+    m_EOTReceived = false;
+    m_rxBuf.clear();
+    m_state = RxWaitBlock;
+    m_isRunning = true;
+    requestBlock();
+    return true;
+}
+
+void XYModem::newData(const QByteArray &data)
+{
+    if(!m_isRunning)
+        return;
+    if(m_state == RxWaitBlock)
+    {
+        m_rxBuf.append(data);
+        processRxBuffer();
+    }
+    else
+    {
+        for(auto it = data.cbegin(); it != data.cend() && m_isRunning; ++it)
+            onTxByte(*it);
+    }
+}
+
+void XYModem::onTimeout()
+{
+    if(!m_isRunning)
+        return;
+    if(++m_retryCount > m_argument.retryNum)
+    {
+        fail(tr("Timeout"));
+        return;
+    }
+    if(m_state == TxWaitStart || m_state == TxWaitEndStart)
+        m_timer->start(m_argument.timeout); // the receiver should start the transfer
+    else if(m_state == RxWaitBlock)
+    {
+        m_rxBuf.clear();
+        requestBlock();
+    }
+    else
+    {
+        emit send(m_lastPacket);
+        m_timer->start(m_argument.timeout);
+    }
+}
+
+QByteArray XYModem::makeBlock(quint8 num, const QByteArray &data, qsizetype blockSize, char padding)
+{
+    QByteArray block;
+    block.reserve(blockSize + 5);
+    block.append(blockSize == 1024 ? STX : SOH);
+    block.append(num);
+    block.append(~num);
+    block.append(data);
+    block.append(blockSize - data.size(), padding);
+    if(m_useCRC)
+    {
+        m_crc16.reset();
+        m_crc16.addData(block.constData() + 3, blockSize);
+        quint16 crc = m_crc16.getResult();
+        block.append(crc >> 8);
+        block.append(crc & 0xFF);
+    }
+    else
+    {
+        quint8 sum = 0;
+        for(qsizetype i = 3; i < block.size(); i++)
+            sum += block.at(i);
+        block.append(sum);
+    }
+    return block;
+}
+
+void XYModem::sendPacket(const QByteArray &packet)
+{
+    m_lastPacket = packet;
+    emit send(packet);
+    m_timer->start(m_argument.timeout);
+}
+
+void XYModem::resend()
+{
+    if(++m_retryCount > m_argument.retryNum)
+    {
+        fail(tr("Too many retries"));
+        return;
+    }
+    emit send(m_lastPacket);
+    m_timer->start(m_argument.timeout);
+}
+
+void XYModem::sendNextBlock()
+{
+    if(m_handledNum >= m_fileSize)
+    {
+        m_blockLen = 0;
+        m_state = TxWaitEOTAck;
+        sendPacket(QByteArray(1, EOT));
+        return;
+    }
+    // use 128-byte block for the tail, less padding
+    qsizetype blockSize = (m_variant == XModem || !m_useCRC || m_fileSize - m_handledNum <= 128) ? 128 : 1024;
+    QByteArray data = m_file.read(blockSize);
+    if(data.isEmpty())
+    {
+        fail(tr("Failed to read file."));
+        return;
+    }
+    m_blockLen = data.size();
+    m_state = TxWaitBlockAck;
+    sendPacket(makeBlock(m_blockNum, data, blockSize, CPMEOF));
+}
+
+void XYModem::sendHeader()
+{
+    // "name\0size mtime mode\0"
+    QFileInfo info(m_file.fileName());
+    QByteArray header = info.fileName().toUtf8();
+    header.append('\0');
+    header.append(QString("%1 %2 100644").arg(m_fileSize).arg(info.lastModified().toSecsSinceEpoch(), 0, 8).toLatin1());
+    header.append('\0');
+    header.truncate(1024);
+    m_state = TxWaitHeaderAck;
+    sendPacket(makeBlock(0, header, header.size() > 128 ? 1024 : 128, 0));
+}
+
+void XYModem::onTxByte(quint8 c)
+{
+    if(c == CAN)
+    {
+        if(++m_canCount >= 2)
+            fail(tr("Cancelled by the receiver"), false);
+        return;
+    }
+    m_canCount = 0;
+
+    if(m_state == TxWaitStart)
+    {
+        if(c == CRC16)
+        {
+            m_useCRC = true;
+            m_retryCount = 0;
+            if(m_blockNum == 0)
+                sendHeader();
+            else
+                sendNextBlock();
+        }
+        else if(c == NAK && m_variant == XModem)
+        {
+            // the receiver doesn't support CRC
+            m_useCRC = false;
+            m_retryCount = 0;
+            sendNextBlock();
+        }
+    }
+    else if(m_state == TxWaitHeaderAck)
+    {
+        if(c == ACK)
+        {
+            // the receiver sends 'C' again for the data blocks
+            m_blockNum = 1;
+            m_retryCount = 0;
+            m_state = TxWaitStart;
+            m_timer->start(m_argument.timeout);
+        }
+        else if(c == NAK)
+            resend();
+    }
+    else if(m_state == TxWaitBlockAck)
+    {
+        if(c == ACK)
+        {
+            m_handledNum += m_blockLen;
+            emit dataTransmitted(m_blockLen);
+            m_blockNum++;
+            m_retryCount = 0;
+            sendNextBlock();
+        }
+        else if(c == NAK)
+            resend();
+    }
+    else if(m_state == TxWaitEOTAck)
+    {
+        if(c == ACK)
+        {
+            if(m_variant == YModem)
+            {
+                m_retryCount = 0;
+                if(openNextFile())
+                {
+                    // the receiver sends 'C' for the next header
+                    m_fileSize = m_file.size();
+                    m_handledNum = 0;
+                    m_blockNum = 0;
+                    m_state = TxWaitStart;
+                }
+                else
+                    m_state = TxWaitEndStart; // end the batch with an empty header
+                m_timer->start(m_argument.timeout);
+            }
+            else
+                complete();
+        }
+        else if(c == NAK)
+            resend(); // YMODEM receiver confirms the EOT with NAK
+    }
+    else if(m_state == TxWaitEndStart)
+    {
+        if(c == CRC16)
+        {
+            m_state = TxWaitEndAck;
+            sendPacket(makeBlock(0, QByteArray(), 128, 0));
+        }
+    }
+    else if(m_state == TxWaitEndAck)
+    {
+        if(c == ACK)
+            complete();
+        else if(c == NAK)
+            resend();
+    }
+}
+
+void XYModem::sendByte(quint8 c)
+{
+    emit send(QByteArray(1, c));
+}
+
+void XYModem::requestBlock()
+{
+    if(m_waitingStart)
+    {
+        // fall back to checksum if the sender doesn't respond to 'C'
+        if(m_variant == XModem && ++m_startCount > 3)
+            m_useCRC = false;
+        sendByte(m_useCRC ? CRC16 : NAK);
+        m_timer->start(qMin(m_argument.timeout, 3000));
+    }
+    else
+    {
+        sendByte(NAK);
+        m_timer->start(m_argument.timeout);
+    }
+}
+
+void XYModem::processRxBuffer()
+{
+    while(m_isRunning && !m_rxBuf.isEmpty())
+    {
+        quint8 head = m_rxBuf.at(0);
+        if(head == SOH || head == STX)
+        {
+            qsizetype len = 3 + (head == SOH ? 128 : 1024) + (m_useCRC ? 2 : 1);
+            if(m_rxBuf.size() < len)
+                break;
+            QByteArray block = m_rxBuf.left(len);
+            m_rxBuf.remove(0, len);
+            onBlock(block);
+        }
+        else if(head == EOT)
+        {
+            m_rxBuf.remove(0, 1);
+            onEOT();
+        }
+        else if(head == CAN)
+        {
+            if(m_rxBuf.size() < 2)
+                break;
+            if((quint8)m_rxBuf.at(1) == CAN)
+            {
+                fail(tr("Cancelled by the sender"), false);
+                return;
+            }
+            m_rxBuf.remove(0, 1);
+        }
+        else
+            m_rxBuf.remove(0, 1); // noise
+    }
+}
+
+void XYModem::onBlock(const QByteArray &block)
+{
+    quint8 num = block.at(1);
+    qsizetype size = block.size() - 3 - (m_useCRC ? 2 : 1);
+    const char* data = block.constData() + 3;
+    bool valid = ((quint8)(num ^ (quint8)block.at(2)) == 0xFF);
+    if(valid && m_useCRC)
+    {
+        m_crc16.reset();
+        m_crc16.addData(data, size);
+        quint16 crc = m_crc16.getResult();
+        valid = ((quint8)block.at(3 + size) == (crc >> 8)) && ((quint8)block.at(4 + size) == (crc & 0xFF));
+    }
+    else if(valid)
+    {
+        quint8 sum = 0;
+        for(qsizetype i = 0; i < size; i++)
+            sum += data[i];
+        valid = (sum == (quint8)block.at(3 + size));
+    }
+    if(!valid)
+    {
+        // purge the line then ask for the block again
+        m_rxBuf.clear();
+        if(++m_retryCount > m_argument.retryNum)
+        {
+            fail(tr("Too many errors"));
+            return;
+        }
+        sendByte(NAK);
+        m_timer->start(m_argument.timeout);
+        return;
+    }
+    if(m_blockAcked && num == (quint8)(m_blockNum - 1))
+    {
+        // the ACK is lost, the sender repeats the block
+        sendByte(ACK);
+        m_timer->start(m_argument.timeout);
+        return;
+    }
+    if(num != m_blockNum)
+    {
+        fail(tr("Block out of sequence"));
+        return;
+    }
+
+    m_retryCount = 0;
+    m_waitingStart = false;
+    m_EOTReceived = false;
+    if(!m_fileOpened)
+    {
+        onHeaderBlock(QByteArray(data, size));
+        return;
+    }
+    qint64 len = size;
+    if(m_fileSize >= 0)
+        len = qMin(len, m_fileSize - m_handledNum); // remove the padding
+    if(len > 0 && m_file.write(data, len) != len)
+    {
+        fail(tr("Failed to write file."));
+        return;
+    }
+    m_handledNum += len;
+    if(len > 0)
+        emit dataReceived(len);
+    m_blockNum++;
+    m_blockAcked = true;
+    sendByte(ACK);
+    m_timer->start(m_argument.timeout);
+}
+
+void XYModem::onHeaderBlock(const QByteArray &data)
+{
+    qsizetype nameEnd = data.indexOf('\0');
+    QByteArray name = data.left(nameEnd);
+    if(name.isEmpty())
+    {
+        // empty header: end of batch
+        sendByte(ACK);
+        complete();
+        return;
+    }
+    QByteArray info = data.mid(nameEnd + 1);
+    qsizetype infoEnd = info.indexOf('\0');
+    if(infoEnd >= 0)
+        info.truncate(infoEnd);
+    bool ok;
+    qint64 size = info.split(' ').first().toLongLong(&ok);
+    m_fileSize = ok ? size : -1;
+
+    QString path = receiveFilePath(QString::fromUtf8(name));
+    m_file.setFileName(path);
+    if(!m_file.open(QFile::WriteOnly))
+    {
+        fail(tr("Failed to open") + " " + path);
+        return;
+    }
+    m_fileOpened = true;
+    m_handledNum = 0;
+    emit message(tr("Receiving") + " " + path);
+
+    m_blockNum = 1;
+    m_blockAcked = true;
+    m_waitingStart = true;
+    sendByte(ACK);
+    requestBlock(); // 'C' for the data blocks
+}
+
+void XYModem::onEOT()
+{
+    if(!m_fileOpened)
+        return;
+    if(m_variant == YModem && !m_EOTReceived)
+    {
+        // YMODEM confirms the EOT
+        m_EOTReceived = true;
+        sendByte(NAK);
+        m_timer->start(m_argument.timeout);
+        return;
+    }
+    sendByte(ACK);
+    m_file.close();
+    m_fileOpened = false;
+    if(m_variant != YModem)
+    {
+        complete();
+        return;
+    }
+    emit message(tr("Received") + " " + m_file.fileName());
+
+    // wait for the next header
+    m_EOTReceived = false;
+    m_blockNum = 0;
+    m_blockAcked = false;
+    m_waitingStart = true;
+    m_retryCount = 0;
+    requestBlock();
+}
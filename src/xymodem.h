@@ -0,0 +1,75 @@
+#ifndef XYMODEM_H
+#define XYMODEM_H
+
+#include "fileprotocol.h"
+#include "asynccrc.h"
+
+// XMODEM, XMODEM-1K and YMODEM(batch)
+class XYModem : public FileProtocol
+{
+    Q_OBJECT
+public:
+    enum Variant
+    {
+        XModem = 0,
+        XModem1K,
+        YModem,
+    };
+
+    explicit XYModem(Variant variant, QObject *parent = nullptr);
+
+    bool startTransmit(const QString& filename) override;
+    bool startReceive(const QString& path) override;
+    void newData(const QByteArray& data) override;
+protected:
+    enum State
+    {
+        Idle = 0,
+        // transmit
+        TxWaitStart, // wait for 'C' or NAK
+        TxWaitHeaderAck, // YMODEM block 0
+        TxWaitBlockAck,
+        TxWaitEOTAck,
+        TxWaitEndStart, // YMODEM, wait for 'C' then send the empty block 0
+        TxWaitEndAck,
+        // receive
+        RxWaitBlock,
+    };
+
+    Variant m_variant;
+    State m_state = Idle;
+    AsyncCRC m_crc16;
+    bool m_useCRC = true;
+    quint8 m_blockNum = 0;
+    QByteArray m_lastPacket;
+    qint64 m_fileSize = 0;
+    qint64 m_handledNum = 0;
+    int m_canCount = 0;
+
+    // transmit
+    qsizetype m_blockLen = 0; // valid data in m_lastPacket
+
+    // receive
+    QByteArray m_rxBuf;
+    bool m_waitingStart = true; // send 'C'(or NAK) until the sender starts
+    bool m_blockAcked = false; // a block of the current file is acknowledged
+    bool m_fileOpened = false;
+    bool m_EOTReceived = false;
+    int m_startCount = 0;
+
+    void onTimeout() override;
+    QByteArray makeBlock(quint8 num, const QByteArray& data, qsizetype blockSize, char padding);
+    void sendPacket(const QByteArray& packet);
+    void sendNextBlock();
+    void sendHeader();
+    void resend();
+    void onTxByte(quint8 c);
+    void processRxBuffer();
+    void onBlock(const QByteArray& block);
+    void onEOT();
+    void onHeaderBlock(const QByteArray& data);
+    void sendByte(quint8 c);
+    void requestBlock();
+};
+
+#endif // XYMODEM_H
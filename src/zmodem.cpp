@@ -0,0 +1,869 @@
+#include "zmodem.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <cctype>
+
+namespace
+{
+const quint8 ZPAD = '*';
+const quint8 ZDLE = 0x18;
+const quint8 ZBIN = 'A';
+const quint8 ZHEX = 'B';
+const quint8 ZBIN32 = 'C';
+
+// frame end of the subpacket
+const char ZCRCE = 'h'; // frame ends, header follows
+const char ZCRCG = 'i'; // frame continues nonstop
+const char ZCRCQ = 'j'; // frame continues, ZACK expected
+const char ZCRCW = 'k'; // frame ends, ZACK expected
+const quint8 ZRUB0 = 'l';
+const quint8 ZRUB1 = 'm';
+
+const quint8 XON = 0x11;
+const quint8 XOFF = 0x13;
+
+// ZF0 of ZRINIT
+const quint8 CANFDX = 0x01;
+const quint8 CANOVIO = 0x02;
+const quint8 CANFC32 = 0x20;
+
+// ZF0 of ZFILE
+const quint8 ZCBIN = 1;
+const quint8 ZCRECOV = 3;
+
+const qsizetype MaxBlockSize = 1024; // for sending
+const qsizetype MaxSubpacketSize = 8192; // for receiving
+
+inline bool isSpecial(quint8 c)
+{
+    return c == ZDLE || (c & 0x7F) == XON || (c & 0x7F) == XOFF;
+}
+}
+
+ZModem::ZModem(QObject *parent)
+    : FileProtocol{parent},
+      m_crc16(16, 0x1021ULL), // CRC-16/XMODEM
+      m_crc32(32, 0x04C11DB7ULL, 0xFFFFFFFFULL, true, true, 0xFFFFFFFFULL) // CRC-32
+{
+    m_sendTimer = new QTimer(this);
+    m_sendTimer->setSingleShot(true);
+    m_sendTimer->setInterval(0);
+    connect(m_sendTimer, &QTimer::timeout, this, &ZModem::sendData);
+}
+
+bool ZModem::startTransmit(const QString &filename)
+{
+    m_file.close();
+    m_file.setFileName(filename);
+    if(!m_file.open(QFile::ReadOnly))
+        return false;
+
+    m_fileName = QFileInfo(filename).fileName();
+    m_fileSize = m_file.size();
+    m_txCRC32 = false;
+    m_txPos = 0;
+    m_ackedPos = 0;
+    m_reportedPos = 0;
+    m_retryCount = 0;
+    m_errorCount = 0;
+    m_canCount = 0;
+    m_parserState = HuntPad;
+    m_state = TxWaitRInit;
+    m_isRunning = true;
+    // start the receiver if the peer is a shell
+    emit send("rz\r");
+    sendFrame(hexHeader(ZRQINIT, posHeader(0)));
+    return true;
+}
+
+bool ZModem::startReceive(const QString &path)
+{
+    m_file.close();
+    m_receivePath = path;
+    m_rxPos = 0;
+    m_retryCount = 0;
+    m_errorCount = 0;
+    m_canCount = 0;
+    m_parserState = HuntPad;
+    m_state = RxWaitFile;
+    m_isRunning = true;
+    sendRInit();
+    return true;
+}
+
+void ZModem::newData(const QByteArray &data)
+{
+    const char* p = data.constData();
+    qsizetype len = data.size();
+    qsizetype i = 0;
+    while(i < len && m_isRunning)
+    {
+        if(m_parserState == ReadSubpacket && !m_escape)
+        {
+            // fast path, copy the plain bytes in the subpacket
+            qsizetype j = i;
+            while(j < len && !isSpecial(p[j]))
+                j++;
+            if(j > i)
+            {
+                m_subpacket.append(p + i, j - i);
+                m_canCount = 0;
+                i = j;
+                if(m_subpacket.size() > MaxSubpacketSize)
+                {
+                    m_parserState = HuntPad;
+                    onSubpacket(false);
+                }
+                continue;
+            }
+        }
+        quint8 c = p[i++];
+        // 5 CANs abort the session, ZDLE is CAN
+        if(c == ZDLE)
+        {
+            if(++m_canCount >= 5)
+            {
+                fail(tr("Cancelled by the peer"), false);
+                return;
+            }
+        }
+        else
+            m_canCount = 0;
+        onByte(c);
+    }
+}
+
+void ZModem::onByte(quint8 c)
+{
+    switch(m_parserState)
+    {
+    case HuntPad:
+        if(c == ZPAD)
+            m_parserState = HuntDle;
+        break;
+    case HuntDle:
+        if(c == ZDLE)
+            m_parserState = HuntFormat;
+        else if(c != ZPAD)
+            m_parserState = HuntPad;
+        break;
+    case HuntFormat:
+        m_headerBuf.clear();
+        m_escape = false;
+        m_headerFormat = c;
+        if(c == ZHEX)
+            m_parserState = ReadHexHeader;
+        else if(c == ZBIN || c == ZBIN32)
+            m_parserState = ReadBinHeader;
+        else
+            m_parserState = HuntPad;
+        break;
+    case ReadHexHeader:
+    {
+        // type, 4 bytes and CRC-16 in hex
+        if(!isxdigit(c))
+        {
+            m_parserState = HuntPad;
+            break;
+        }
+        m_headerBuf.append(c);
+        if(m_headerBuf.size() < 14)
+            break;
+        m_parserState = HuntPad;
+        QByteArray raw = QByteArray::fromHex(m_headerBuf);
+        m_crc16.reset();
+        m_crc16.addData(raw.constData(), 5);
+        quint16 crc = m_crc16.getResult();
+        if(crc == (((quint8)raw.at(5) << 8) | (quint8)raw.at(6)))
+            onHeader(raw.at(0), (const quint8*)raw.constData() + 1);
+        break;
+    }
+    case ReadBinHeader:
+    case ReadSubpacket:
+    case ReadSubpacketCRC:
+    {
+        // the flow control characters are escaped by the sender, drop the raw ones
+        if((c & 0x7F) == XON || (c & 0x7F) == XOFF)
+            break;
+        if(c == ZDLE && !m_escape)
+        {
+            m_escape = true;
+            break;
+        }
+        if(m_escape)
+        {
+            m_escape = false;
+            if(m_parserState == ReadSubpacket && (c == ZCRCE || c == ZCRCG || c == ZCRCQ || c == ZCRCW))
+            {
+                m_frameEnd = c;
+                m_subpacketCRC.clear();
+                m_parserState = ReadSubpacketCRC;
+                break;
+            }
+            if(!unescape(c))
+            {
+                bool inSubpacket = (m_parserState != ReadBinHeader);
+                m_parserState = HuntPad;
+                if(inSubpacket)
+                    onSubpacket(false);
+                break;
+            }
+        }
+
+        if(m_parserState == ReadBinHeader)
+        {
+            m_headerBuf.append(c);
+            if(m_headerBuf.size() < (m_headerFormat == ZBIN32 ? 9 : 7))
+                break;
+            m_parserState = HuntPad;
+            const quint8* raw = (const quint8*)m_headerBuf.constData();
+            bool valid;
+            if(m_headerFormat == ZBIN32)
+            {
+                m_crc32.reset();
+                m_crc32.addData(m_headerBuf.constData(), 5);
+                quint32 crc = m_crc32.getResult();
+                valid = (crc == (raw[5] | (raw[6] << 8) | (raw[7] << 16) | ((quint32)raw[8] << 24)));
+            }
+            else
+            {
+                m_crc16.reset();
+                m_crc16.addData(m_headerBuf.constData(), 5);
+                quint16 crc = m_crc16.getResult();
+                valid = (crc == ((raw[5] << 8) | raw[6]));
+            }
+            if(valid)
+                onHeader(raw[0], raw + 1);
+        }
+        else if(m_parserState == ReadSubpacket)
+        {
+            m_subpacket.append(c);
+            if(m_subpacket.size() > MaxSubpacketSize)
+            {
+                m_parserState = HuntPad;
+                onSubpacket(false);
+            }
+        }
+        else
+        {
+            m_subpacketCRC.append(c);
+            if(m_subpacketCRC.size() < (m_rxCRC32 ? 4 : 2))
+                break;
+            const quint8* raw = (const quint8*)m_subpacketCRC.constData();
+            bool valid;
+            if(m_rxCRC32)
+            {
+                m_crc32.reset();
+                m_crc32.addData(m_subpacket);
+                m_crc32.addData(&m_frameEnd, 1);
+                quint32 crc = m_crc32.getResult();
+                valid = (crc == (raw[0] | (raw[1] << 8) | (raw[2] << 16) | ((quint32)raw[3] << 24)));
+            }
+            else
+            {
+                m_crc16.reset();
+                m_crc16.addData(m_subpacket);
+                m_crc16.addData(&m_frameEnd, 1);
+                quint16 crc = m_crc16.getResult();
+                valid = (crc == ((raw[0] << 8) | raw[1]));
+            }
+            // onSubpacket() might change the state
+            m_parserState = (m_frameEnd == ZCRCG || m_frameEnd == ZCRCQ) ? ReadSubpacket : HuntPad;
+            onSubpacket(valid);
+            m_subpacket.clear();
+        }
+        break;
+    }
+    }
+}
+
+bool ZModem::unescape(quint8 &c)
+{
+    if(c == ZRUB0)
+        c = 0x7F;
+    else if(c == ZRUB1)
+        c = 0xFF;
+    else if((c & 0x60) == 0x40)
+        c ^= 0x40;
+    else
+        return false;
+    return true;
+}
+
+void ZModem::onHeader(quint8 type, const quint8 *hdr)
+{
+    if(type > ZSTDERR)
+        return;
+    m_rxCRC32 = (m_headerFormat == ZBIN32);
+    if(m_state >= RxWaitFile)
+        onRxHeader(type, hdr);
+    else
+        onTxHeader(type, hdr);
+}
+
+void ZModem::onSubpacket(bool valid)
+{
+    // the receiver never sends subpackets to the sender
+    if(m_state >= RxWaitFile)
+        onRxSubpacket(valid);
+}
+
+void ZModem::readSubpacket(quint8 owner)
+{
+    m_subpacketOwner = owner;
+    m_subpacket.clear();
+    m_escape = false;
+    m_parserState = ReadSubpacket;
+}
+
+quint32 ZModem::headerPos(const quint8 *hdr)
+{
+    return hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((quint32)hdr[3] << 24);
+}
+
+QByteArray ZModem::posHeader(quint32 pos)
+{
+    QByteArray hdr(4, 0);
+    hdr[0] = pos & 0xFF;
+    hdr[1] = (pos >> 8) & 0xFF;
+    hdr[2] = (pos >> 16) & 0xFF;
+    hdr[3] = (pos >> 24) & 0xFF;
+    return hdr;
+}
+
+QByteArray ZModem::flagHeader(quint8 zf0, quint8 zf1, quint8 zf2, quint8 zf3)
+{
+    QByteArray hdr(4, 0);
+    hdr[0] = zf3;
+    hdr[1] = zf2;
+    hdr[2] = zf1;
+    hdr[3] = zf0;
+    return hdr;
+}
+
+QByteArray ZModem::hexHeader(quint8 type, const QByteArray &hdr)
+{
+    QByteArray raw;
+    raw.append(type);
+    raw.append(hdr);
+    m_crc16.reset();
+    m_crc16.addData(raw);
+    quint16 crc = m_crc16.getResult();
+    raw.append(crc >> 8);
+    raw.append(crc & 0xFF);
+
+    QByteArray frame;
+    frame.append(ZPAD);
+    frame.append(ZPAD);
+    frame.append(ZDLE);
+    frame.append(ZHEX);
+    frame.append(raw.toHex());
+    frame.append("\r\x8a");
+    if(type != ZFIN && type != ZACK)
+        frame.append(XON);
+    return frame;
+}
+
+QByteArray ZModem::binHeader(quint8 type, const QByteArray &hdr)
+{
+    QByteArray raw;
+    raw.append(type);
+    raw.append(hdr);
+
+    QByteArray frame;
+    frame.append(ZPAD);
+    frame.append(ZDLE);
+    frame.append(m_txCRC32 ? ZBIN32 : ZBIN);
+    appendEscaped(frame, raw.constData(), raw.size());
+    if(m_txCRC32)
+    {
+        m_crc32.reset();
+        m_crc32.addData(raw);
+        quint32 crc = m_crc32.getResult();
+        char crcBuf[4] = {(char)crc, (char)(crc >> 8), (char)(crc >> 16), (char)(crc >> 24)};
+        appendEscaped(frame, crcBuf, 4);
+    }
+    else
+    {
+        m_crc16.reset();
+        m_crc16.addData(raw);
+        quint16 crc = m_crc16.getResult();
+        char crcBuf[2] = {(char)(crc >> 8), (char)crc};
+        appendEscaped(frame, crcBuf, 2);
+    }
+    return frame;
+}
+
+QByteArray ZModem::subpacket(const char *data, qsizetype len, char frameEnd)
+{
+    QByteArray frame;
+    frame.reserve(len + len / 8 + 16);
+    appendEscaped(frame, data, len);
+    frame.append(ZDLE);
+    frame.append(frameEnd);
+    if(m_txCRC32)
+    {
+        m_crc32.reset();
+        m_crc32.addData(data, len);
+        m_crc32.addData(&frameEnd, 1);
+        quint32 crc = m_crc32.getResult();
+        char crcBuf[4] = {(char)crc, (char)(crc >> 8), (char)(crc >> 16), (char)(crc >> 24)};
+        appendEscaped(frame, crcBuf, 4);
+    }
+    else
+    {
+        m_crc16.reset();
+        m_crc16.addData(data, len);
+        m_crc16.addData(&frameEnd, 1);
+        quint16 crc = m_crc16.getResult();
+        char crcBuf[2] = {(char)(crc >> 8), (char)crc};
+        appendEscaped(frame, crcBuf, 2);
+    }
+    if(frameEnd == ZCRCW)
+        frame.append(XON);
+    return frame;
+}
+
+void ZModem::appendEscaped(QByteArray &dest, const char *data, qsizetype len)
+{
+    for(qsizetype i = 0; i < len; i++)
+    {
+        quint8 c = data[i];
+        bool escape = false;
+        switch(c)
+        {
+        case ZDLE:
+        case 0x10:
+        case 0x11:
+        case 0x13:
+        case 0x90:
+        case 0x91:
+        case 0x93:
+        case 0x98:
+            escape = true;
+            break;
+        case 0x0D:
+        case 0x8D:
+            // for Telenet, "@\r" is a command
+            escape = ((m_lastSent & 0x7F) == '@');
+            break;
+        }
+        if(escape)
+        {
+            dest.append(ZDLE);
+            c ^= 0x40;
+        }
+        dest.append(c);
+        m_lastSent = c;
+    }
+}
+
+void ZModem::sendFrame(const QByteArray &frame)
+{
+    m_lastFrame = frame;
+    emit send(frame);
+    m_timer->start(m_argument.timeout);
+}
+
+void ZModem::onTimeout()
+{
+    if(!m_isRunning)
+        return;
+    if(m_state == TxStreaming && !m_waitingAck)
+        return;
+    if(m_state == RxData && m_rxActive)
+    {
+        m_rxActive = false;
+        m_timer->start(m_argument.timeout);
+        return;
+    }
+    if(++m_retryCount > m_argument.retryNum)
+    {
+        fail(tr("Timeout"));
+        return;
+    }
+
+    if(m_state == TxStreaming)
+    {
+        // the ZACK might be lost, ask for it again
+        QByteArray frame;
+        if(m_needDataHeader)
+            frame = binHeader(ZDATA, posHeader(m_txPos));
+        frame.append(subpacket(nullptr, 0, ZCRCW));
+        m_needDataHeader = true;
+        emit send(frame);
+        m_timer->start(m_argument.timeout);
+    }
+    else if(m_state == RxWaitData || m_state == RxData)
+    {
+        m_parserState = HuntPad;
+        m_state = RxWaitData;
+        sendFrame(hexHeader(ZRPOS, posHeader(m_rxPos)));
+    }
+    else
+    {
+        emit send(m_lastFrame);
+        m_timer->start(m_argument.timeout);
+    }
+}
+
+// ********** transmit **********
+
+void ZModem::onTxHeader(quint8 type, const quint8 *hdr)
+{
+    if(type == ZRINIT)
+    {
+        if(m_state == TxWaitRInit)
+        {
+            m_txCRC32 = hdr[3] & CANFC32;
+            m_rxBufLen = hdr[0] | (hdr[1] << 8);
+            m_retryCount = 0;
+            sendFileHeader();
+        }
+        else if(m_state == TxWaitEOFAck)
+        {
+            m_retryCount = 0;
+            if(nextFile())
+                sendFileHeader();
+            else
+            {
+                // no more files, end the session
+                m_state = TxWaitFin;
+                sendFrame(hexHeader(ZFIN, posHeader(0)));
+            }
+        }
+        // ZFILE is resent by the timer in TxWaitRPos, the duplicated ZRINIT is ignored
+    }
+    else if(type == ZRPOS)
+    {
+        if(m_state != TxWaitRPos && m_state != TxStreaming && m_state != TxWaitEOFAck)
+            return;
+        qint64 pos = headerPos(hdr);
+        if(pos > m_fileSize)
+        {
+            fail(tr("Invalid position"));
+            return;
+        }
+        if(m_state != TxWaitRPos && ++m_errorCount > m_argument.retryNum)
+        {
+            fail(tr("Too many errors"));
+            return;
+        }
+        if(m_state == TxWaitRPos && pos > 0)
+            emit message(tr("Resuming from") + " " + QString::number(pos));
+        seekTo(pos);
+        m_state = TxStreaming;
+        sendData();
+    }
+    else if(type == ZACK)
+    {
+        if(m_state != TxStreaming)
+            return;
+        qint64 pos = headerPos(hdr);
+        if(pos > m_ackedPos && pos <= m_txPos)
+        {
+            m_ackedPos = pos;
+            m_errorCount = 0;
+        }
+        // ZCRCW: the frame ends, wait for all data
+        // ZCRCQ: the window is full, wait for some data
+        if(m_waitingAck && (m_needDataHeader ? m_ackedPos >= m_txPos : m_txPos - m_ackedPos < m_argument.window))
+        {
+            m_waitingAck = false;
+            m_retryCount = 0;
+            m_timer->stop();
+            sendData();
+        }
+    }
+    else if(type == ZSKIP)
+    {
+        if(m_state != TxWaitRPos)
+            return;
+        emit message(tr("Skipped by the receiver") + ": " + m_fileName);
+        m_retryCount = 0;
+        if(nextFile())
+            sendFileHeader();
+        else
+        {
+            m_state = TxWaitFin;
+            sendFrame(hexHeader(ZFIN, posHeader(0)));
+        }
+    }
+    else if(type == ZFIN)
+    {
+        if(m_state == TxWaitFin)
+        {
+            emit send("OO"); // over and out
+            complete();
+        }
+    }
+    else if(type == ZNAK)
+    {
+        if(m_state != TxStreaming && !m_lastFrame.isEmpty())
+            emit send(m_lastFrame);
+    }
+    else if(type == ZABORT || type == ZFERR || type == ZCAN)
+        fail(tr("Aborted by the receiver"));
+}
+
+void ZModem::sendFileHeader()
+{
+    // "name\0size mtime mode serial files_left bytes_left\0"
+    QByteArray info = m_fileName.toUtf8();
+    info.append('\0');
+    qint64 bytesLeft = m_fileSize;
+    for(const QString& filename : m_pendingFiles)
+        bytesLeft += QFileInfo(filename).size();
+    info.append(QString("%1 %2 100644 0 %3 %4").arg(m_fileSize).arg(QFileInfo(m_file).lastModified().toSecsSinceEpoch(), 0, 8).arg(m_pendingFiles.size() + 1).arg(bytesLeft).toLatin1());
+    info.append('\0');
+    m_state = TxWaitRPos;
+    sendFrame(binHeader(ZFILE, flagHeader(m_argument.resume ? ZCRECOV : ZCBIN)) + subpacket(info.constData(), info.size(), ZCRCW));
+}
+
+bool ZModem::nextFile()
+{
+    if(!openNextFile())
+        return false;
+    m_fileName = QFileInfo(m_file.fileName()).fileName();
+    m_fileSize = m_file.size();
+    m_txPos = 0;
+    m_ackedPos = 0;
+    m_reportedPos = 0;
+    m_errorCount = 0;
+    return true;
+}
+
+void ZModem::seekTo(qint64 pos)
+{
+    m_file.seek(pos);
+    m_txPos = pos;
+    m_ackedPos = pos;
+    m_lastZCRCQPos = pos;
+    m_frameStartPos = pos;
+    m_waitingAck = false;
+    m_needDataHeader = true;
+    m_timer->stop();
+    reportTxProgress(); // the skipped part when resuming
+}
+
+void ZModem::sendData()
+{
+    const qsizetype blockSize = (m_rxBufLen > 0 && m_rxBufLen < MaxBlockSize) ? m_rxBufLen : MaxBlockSize;
+    QByteArray frame;
+    // send a few subpackets each time, keep the event loop responsive
+    for(int i = 0; i < 16; i++)
+    {
+        if(!m_isRunning || m_state != TxStreaming || m_waitingAck)
+            return;
+        frame.clear();
+        if(m_needDataHeader)
+        {
+            frame = binHeader(ZDATA, posHeader(m_txPos));
+            m_needDataHeader = false;
+            m_frameStartPos = m_txPos;
+        }
+        QByteArray buf = m_file.read(blockSize);
+        if(buf.isEmpty() && m_txPos < m_fileSize)
+        {
+            fail(tr("Failed to read file."));
+            return;
+        }
+        qint64 end = m_txPos + buf.size();
+        char frameEnd = ZCRCG;
+        if(end >= m_fileSize)
+            frameEnd = ZCRCE;
+        else if(m_rxBufLen > 0 && end - m_frameStartPos + blockSize > m_rxBufLen)
+            frameEnd = ZCRCW; // the receiver's buffer is full
+        else if(m_argument.window > 0 && end - m_lastZCRCQPos >= m_argument.window / 4)
+        {
+            frameEnd = ZCRCQ;
+            m_lastZCRCQPos = end;
+        }
+        frame.append(subpacket(buf.constData(), buf.size(), frameEnd));
+        m_txPos = end;
+        reportTxProgress();
+        emit send(frame);
+
+        if(frameEnd == ZCRCE)
+        {
+            m_retryCount = 0;
+            m_state = TxWaitEOFAck;
+            sendFrame(binHeader(ZEOF, posHeader(m_txPos)));
+            return;
+        }
+        else if(frameEnd == ZCRCW)
+        {
+            m_waitingAck = true;
+            m_needDataHeader = true;
+            m_timer->start(m_argument.timeout);
+            return;
+        }
+        else if(m_argument.window > 0 && m_txPos - m_ackedPos >= m_argument.window)
+        {
+            m_waitingAck = true;
+            m_timer->start(m_argument.timeout);
+            return;
+        }
+    }
+    m_sendTimer->start();
+}
+
+void ZModem::reportTxProgress()
+{
+    // the data might be resent after ZRPOS
+    if(m_txPos <= m_reportedPos)
+        return;
+    emit dataTransmitted(m_txPos - m_reportedPos);
+    m_reportedPos = m_txPos;
+}
+
+// ********** receive **********
+
+void ZModem::sendRInit()
+{
+    // full streaming, no buffer limit
+    sendFrame(hexHeader(ZRINIT, flagHeader(CANFDX | CANOVIO | CANFC32)));
+}
+
+void ZModem::onRxHeader(quint8 type, const quint8 *hdr)
+{
+    if(type == ZRQINIT)
+    {
+        if(m_state == RxWaitFile)
+            sendRInit();
+    }
+    else if(type == ZSINIT || type == ZFILE)
+    {
+        m_fileOption = hdr[3];
+        readSubpacket(type);
+    }
+    else if(type == ZDATA)
+    {
+        if(m_state != RxWaitData && m_state != RxData)
+            return;
+        if(headerPos(hdr) != m_rxPos)
+        {
+            // not continuous, ask for the data again
+            onRxDataError();
+            return;
+        }
+        m_state = RxData;
+        m_rxActive = false;
+        m_timer->start(m_argument.timeout);
+        readSubpacket(type);
+    }
+    else if(type == ZEOF)
+    {
+        // ignore it if some data is lost, the sender will respond to ZRPOS
+        if((m_state != RxWaitData && m_state != RxData) || headerPos(hdr) != m_rxPos)
+            return;
+        m_file.close();
+        emit message(tr("Received") + " " + m_file.fileName());
+        m_retryCount = 0;
+        m_state = RxWaitFile;
+        sendRInit();
+    }
+    else if(type == ZFIN)
+    {
+        emit send(hexHeader(ZFIN, posHeader(0)));
+        complete();
+    }
+    else if(type == ZNAK)
+    {
+        if(!m_lastFrame.isEmpty())
+            emit send(m_lastFrame);
+    }
+    else if(type == ZABORT || type == ZCAN)
+        fail(tr("Aborted by the sender"));
+}
+
+void ZModem::onRxSubpacket(bool valid)
+{
+    if(m_subpacketOwner == ZDATA)
+    {
+        if(!valid)
+        {
+            onRxDataError();
+            return;
+        }
+        if(!m_subpacket.isEmpty())
+        {
+            if(m_file.write(m_subpacket) != m_subpacket.size())
+            {
+                fail(tr("Failed to write file."));
+                return;
+            }
+            m_rxPos += m_subpacket.size();
+            emit dataReceived(m_subpacket.size());
+        }
+        m_errorCount = 0;
+        m_retryCount = 0;
+        m_rxActive = true;
+        if(m_frameEnd == ZCRCQ || m_frameEnd == ZCRCW)
+            emit send(hexHeader(ZACK, posHeader(m_rxPos)));
+        if(m_frameEnd == ZCRCE || m_frameEnd == ZCRCW)
+            m_state = RxWaitData; // ZDATA or ZEOF follows
+    }
+    else if(!valid)
+    {
+        // ask the sender to send the header again
+        emit send(hexHeader(ZNAK, posHeader(0)));
+    }
+    else if(m_subpacketOwner == ZSINIT)
+    {
+        // the attention string is not used
+        emit send(hexHeader(ZACK, posHeader(0)));
+    }
+    else if(m_subpacketOwner == ZFILE)
+        openReceivedFile();
+}
+
+void ZModem::onRxDataError()
+{
+    if(++m_errorCount > m_argument.retryNum)
+    {
+        fail(tr("Too many errors"));
+        return;
+    }
+    // drop the rest of the frame, then wait for the ZDATA at m_rxPos
+    m_parserState = HuntPad;
+    m_state = RxWaitData;
+    sendFrame(hexHeader(ZRPOS, posHeader(m_rxPos)));
+}
+
+void ZModem::openReceivedFile()
+{
+    // "name\0size mtime mode ...\0"
+    qsizetype nameEnd = m_subpacket.indexOf('\0');
+    QByteArray name = (nameEnd >= 0) ? m_subpacket.left(nameEnd) : m_subpacket;
+    QByteArray info = (nameEnd >= 0) ? m_subpacket.mid(nameEnd + 1) : QByteArray();
+    qsizetype infoEnd = info.indexOf('\0');
+    if(infoEnd >= 0)
+        info.truncate(infoEnd);
+    bool ok;
+    qint64 size = info.split(' ').first().toLongLong(&ok);
+    m_fileSize = ok ? size : -1;
+
+    QString path = receiveFilePath(QString::fromUtf8(name));
+    m_file.close();
+    m_file.setFileName(path);
+    QFileInfo fileInfo(path);
+    // crash recovery, append to the existing part
+    bool resume = (m_fileOption == ZCRECOV || m_argument.resume) && fileInfo.exists() && (m_fileSize < 0 || fileInfo.size() <= m_fileSize);
+    if(!m_file.open(resume ? (QFile::WriteOnly | QFile::Append) : QFile::WriteOnly))
+    {
+        fail(tr("Failed to open") + " " + path);
+        return;
+    }
+    m_rxPos = resume ? m_file.size() : 0;
+    if(m_rxPos > 0)
+        emit message(tr("Resuming") + " " + path + " " + tr("from") + " " + QString::number(m_rxPos));
+    else
+        emit message(tr("Receiving") + " " + path);
+
+    m_errorCount = 0;
+    m_retryCount = 0;
+    m_state = RxWaitData;
+    sendFrame(hexHeader(ZRPOS, posHeader(m_rxPos)));
+}
@@ -0,0 +1,135 @@
+#ifndef ZMODEM_H
+#define ZMODEM_H
+
+#include "fileprotocol.h"
+#include "asynccrc.h"
+
+// ZMODEM with streaming(ZCRCG), sliding window(ZCRCQ) and crash recovery(ZRPOS)
+class ZModem : public FileProtocol
+{
+    Q_OBJECT
+public:
+    explicit ZModem(QObject *parent = nullptr);
+
+    bool startTransmit(const QString& filename) override;
+    bool startReceive(const QString& path) override;
+    void newData(const QByteArray& data) override;
+protected:
+    enum FrameType
+    {
+        ZRQINIT = 0,
+        ZRINIT,
+        ZSINIT,
+        ZACK,
+        ZFILE,
+        ZSKIP,
+        ZNAK,
+        ZABORT,
+        ZFIN,
+        ZRPOS,
+        ZDATA,
+        ZEOF,
+        ZFERR,
+        ZCRC,
+        ZCHALLENGE,
+        ZCOMPL,
+        ZCAN,
+        ZFREECNT,
+        ZCOMMAND,
+        ZSTDERR,
+    };
+
+    enum State
+    {
+        Idle = 0,
+        // transmit
+        TxWaitRInit,
+        TxWaitRPos, // ZFILE is sent
+        TxStreaming,
+        TxWaitEOFAck, // ZEOF is sent, wait for ZRINIT
+        TxWaitFin,
+        // receive
+        RxWaitFile, // ZRINIT is sent
+        RxWaitData, // ZRPOS is sent
+        RxData,
+    };
+
+    enum ParserState
+    {
+        HuntPad = 0,
+        HuntDle,
+        HuntFormat,
+        ReadHexHeader,
+        ReadBinHeader,
+        ReadSubpacket,
+        ReadSubpacketCRC,
+    };
+
+    State m_state = Idle;
+    AsyncCRC m_crc16, m_crc32;
+    QString m_fileName;
+    qint64 m_fileSize = 0;
+    int m_errorCount = 0;
+
+    // parser
+    ParserState m_parserState = HuntPad;
+    char m_headerFormat = 0;
+    bool m_escape = false;
+    int m_canCount = 0;
+    QByteArray m_headerBuf;
+    QByteArray m_subpacket;
+    QByteArray m_subpacketCRC;
+    char m_frameEnd = 0;
+    bool m_rxCRC32 = false; // for the subpacket following the header
+    quint8 m_subpacketOwner = 0; // type of the header before the subpacket
+
+    // transmit
+    bool m_txCRC32 = false;
+    qint64 m_rxBufLen = 0; // 0: the receiver can stream
+    qint64 m_txPos = 0;
+    qint64 m_ackedPos = 0;
+    qint64 m_reportedPos = 0;
+    qint64 m_lastZCRCQPos = 0;
+    qint64 m_frameStartPos = 0;
+    bool m_waitingAck = false;
+    bool m_needDataHeader = true;
+    QByteArray m_lastFrame; // for retransmission
+    QTimer* m_sendTimer;
+
+    quint8 m_lastSent = 0; // for escaping CR after '@'
+
+    // receive
+    qint64 m_rxPos = 0;
+    quint8 m_fileOption = 0; // ZF0 of ZFILE
+    bool m_rxActive = false; // data arrived in the timeout period
+
+    void onTimeout() override;
+    void onByte(quint8 c);
+    bool unescape(quint8& c);
+    void onHeader(quint8 type, const quint8* hdr);
+    void onSubpacket(bool valid);
+    void onTxHeader(quint8 type, const quint8* hdr);
+    void onRxHeader(quint8 type, const quint8* hdr);
+    void onRxSubpacket(bool valid);
+    void onRxDataError();
+    void openReceivedFile();
+    void sendRInit();
+    void readSubpacket(quint8 owner);
+
+    quint32 headerPos(const quint8* hdr);
+    QByteArray posHeader(quint32 pos);
+    QByteArray flagHeader(quint8 zf0, quint8 zf1 = 0, quint8 zf2 = 0, quint8 zf3 = 0);
+    QByteArray hexHeader(quint8 type, const QByteArray& hdr);
+    QByteArray binHeader(quint8 type, const QByteArray& hdr);
+    QByteArray subpacket(const char* data, qsizetype len, char frameEnd);
+    void appendEscaped(QByteArray& dest, const char* data, qsizetype len);
+    void sendFrame(const QByteArray& frame);
+
+    void sendFileHeader();
+    bool nextFile();
+    void seekTo(qint64 pos);
+    void sendData();
+    void reportTxProgress();
+};
+
+#endif // ZMODEM_H